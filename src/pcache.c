@@ -50,6 +50,7 @@ Transactions that do not delete pages can defer or user-defined commits
 pDiskHandle:for disk API
 pageSize:page size
 mutexHandle:mutex protection
+isShare:other jobs can read the cache. A cache that is not shared belongs to the writing job only and runs without the mutex
 recent:whether to retrieve the write cache or not. Write cache is not retrieved for non current write data
 listDictPageCache:cache pages
 pageDirty:dirty pages
@@ -59,12 +60,19 @@ Dicttablehandledirty: dirty record of table header data cache
 transaction_listDictPageCache: page cache in transaction
 transaction_listDictTableInFile: header data cache in transaction
 transaction_delPage: a deleted page in a transaction. It can only be deleted after the transaction is submitted successfully
+savepoint: savepoint stack of the transaction, the last one is the current savepoint
+transaction_reclaim: page chains detached by clearing tables in the transaction
+reclaim: committed page chains that are freed a few pages at a time by the job
+reclaimDone: first pages of the chains finished since the last flush, their records are deleted by the flush
+reclaimSave: the reclaim list changed since the last flush
+compact: table pages worth compacting, page address to CacheCompact
 */
 typedef struct _CacheHandle
 {
 	void* pDiskHandle;
 	unsigned int pageSize;
 	void* mutexHandle;
+	short isShare;
 	short recent;
 	sds objectName;
 
@@ -78,11 +86,17 @@ typedef struct _CacheHandle
 	ListDict* listTableHandle;
 	dict* dictTableHandleDirty;
 	dict* delPage;
+	list* reclaim;
+	dict* reclaimDone;
+	short reclaimSave;
+	dict* compact;
 
 	//transaction
 	ListDict* transaction_listDictPageCache;
 	ListDict* transaction_listDictTableInFile;
 	dict* transaction_delPage;
+	list* transaction_reclaim;
+	list* savepoint;
 
 	//alloc memory
 	void* memoryListPage;
@@ -100,6 +114,24 @@ typedef struct _CacheHandle
 
 } *PCacheHandle, CacheHandle;
 
+//Number of pages freed in one reclaim step
+#define _RECLAIMCOUNT_ 256
+
+//Number of pages compacted in one compaction step
+#define _COMPACTCOUNT_ 8
+
+#define CacheLock(pCacheHandle) do {\
+if (pCacheHandle->isShare) {\
+		MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);\
+	}\
+} while (0)
+
+#define CacheUnlock(pCacheHandle) do {\
+if (pCacheHandle->isShare) {\
+		MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);\
+	}\
+} while (0)
+
 static int PageCacheCmpFun(void* left, void* right) {
 
 	PDiskPageHead leftPage = (PDiskPageHead)left;
@@ -198,6 +230,330 @@ static dictType maskDictType = {
 	NULL,
 	NULL
 };
+
+static dictType savepointTableDictType = {
+	sdsHashCallback,
+	NULL,
+	NULL,
+	sdsCompareCallback,
+	sdsFreeCallback,
+	NULL
+};
+
+/*
+A savepoint inside the transaction.
+The first change of a transaction page or table head after the savepoint keeps the old image,
+so that the transaction can go back to the savepoint without losing the earlier changes.
+id: savepoint id given by the job
+pageImage: page address to the old page, NULL if the page was not in the transaction
+tableImage: table name to the old table head, NULL if the table head was not in the transaction
+delPage: copy of transaction_delPage when the savepoint was taken
+allocPage: pages allocated from disk after the savepoint
+reclaimLength: length of transaction_reclaim when the savepoint was taken
+*/
+typedef struct _CacheSavepoint
+{
+	unsigned int id;
+	dict* pageImage;
+	dict* tableImage;
+	dict* delPage;
+	dict* allocPage;
+	unsigned long reclaimLength;
+} *PCacheSavepoint, CacheSavepoint;
+
+/*
+A detached page chain waiting to be freed
+headAddr: first page of the chain, names the record of the chain in the file
+pageAddr: next page of the chain to free
+scanSet: the chain holds table pages whose set heads own page chains of their own
+savedAddr: pageAddr in the record of the chain in the file, 0 if there is no record
+*/
+typedef struct _CacheReclaim
+{
+	unsigned int headAddr;
+	unsigned int pageAddr;
+	short scanSet;
+	unsigned int savedAddr;
+} *PCacheReclaim, CacheReclaim;
+
+/*
+The record of a chain kept in the table list of the file,
+It is written with the table heads and the freed pages in one flush, so a restart resumes the chain
+*/
+#pragma pack(push,1)
+typedef struct _DiskReclaim
+{
+	unsigned int pageAddr;
+	unsigned short scanSet;
+} *PDiskReclaim, DiskReclaim;
+#pragma pack(pop)
+
+/*
+A table page worth compacting
+table: the table that owns the page
+freeSize: bytes of the page not used by keys, the pages with the most are compacted first
+*/
+typedef struct _CacheCompact
+{
+	sds table;
+	unsigned int freeSize;
+} *PCacheCompact, CacheCompact;
+
+static void uintFreeCallback(void *privdata, void *val) {
+	NOTUSED(privdata);
+	free(val);
+}
+
+static void CompactFreeCallback(void *privdata, void *val) {
+	NOTUSED(privdata);
+	PCacheCompact pCacheCompact = val;
+	plg_sdsFree(pCacheCompact->table);
+	free(pCacheCompact);
+}
+
+static dictType compactDictType = {
+	hashCallback,
+	NULL,
+	NULL,
+	uintCompareCallback,
+	uintFreeCallback,
+	CompactFreeCallback
+};
+
+/*
+Pages placed by the free space index of the tables may be gone with the rollback
+*/
+static void cache_ResetFreeSpace(PCacheHandle pCacheHandle) {
+
+	listIter* iter = plg_listGetIterator(plg_ListDictList(pCacheHandle->listTableHandle), AL_START_HEAD);
+	listNode* node;
+	while ((node = plg_listNext(iter)) != NULL) {
+		plg_TableResetFreeSpace(listNodeValue(node));
+	}
+	plg_listReleaseIterator(iter);
+}
+
+static void cache_ReclaimEmpty(list* reclaim) {
+
+	listIter* iter = plg_listGetIterator(reclaim, AL_START_HEAD);
+	listNode* node;
+	while ((node = plg_listNext(iter)) != NULL) {
+		free(listNodeValue(node));
+	}
+	plg_listReleaseIterator(iter);
+	plg_listEmpty(reclaim);
+}
+
+static void cache_SavepointSnapDelPage(PCacheHandle pCacheHandle, PCacheSavepoint pSavepoint) {
+
+	plg_dictEmpty(pSavepoint->delPage, NULL);
+	dictIterator* iter = plg_dictGetSafeIterator(pCacheHandle->transaction_delPage);
+	dictEntry* node;
+	while ((node = plg_dictNext(iter)) != NULL) {
+		dictAddWithUint(pSavepoint->delPage, *(unsigned int*)dictGetKey(node), NULL);
+	}
+	plg_dictReleaseIterator(iter);
+}
+
+static PCacheSavepoint cache_SavepointCreate(PCacheHandle pCacheHandle, unsigned int id) {
+
+	PCacheSavepoint pSavepoint = malloc(sizeof(CacheSavepoint));
+	pSavepoint->id = id;
+	pSavepoint->pageImage = plg_dictCreate(plg_DefaultUintPtr(), NULL, DICT_MIDDLE);
+	pSavepoint->tableImage = plg_dictCreate(&savepointTableDictType, NULL, DICT_MIDDLE);
+	pSavepoint->delPage = plg_dictCreate(plg_DefaultUintPtr(), NULL, DICT_MIDDLE);
+	pSavepoint->allocPage = plg_dictCreate(plg_DefaultUintPtr(), NULL, DICT_MIDDLE);
+	pSavepoint->reclaimLength = listLength(pCacheHandle->transaction_reclaim);
+	cache_SavepointSnapDelPage(pCacheHandle, pSavepoint);
+	return pSavepoint;
+}
+
+static void cache_SavepointDestroy(PCacheHandle pCacheHandle, PCacheSavepoint pSavepoint) {
+
+	dictIterator* iter = plg_dictGetSafeIterator(pSavepoint->pageImage);
+	dictEntry* node;
+	while ((node = plg_dictNext(iter)) != NULL) {
+		if (dictGetVal(node)) {
+			plg_MemListPush(pCacheHandle->memoryListPage, dictGetVal(node));
+		}
+	}
+	plg_dictReleaseIterator(iter);
+
+	iter = plg_dictGetSafeIterator(pSavepoint->tableImage);
+	while ((node = plg_dictNext(iter)) != NULL) {
+		if (dictGetVal(node)) {
+			plg_MemListPush(pCacheHandle->memoryListTable, dictGetVal(node));
+		}
+	}
+	plg_dictReleaseIterator(iter);
+
+	plg_dictRelease(pSavepoint->pageImage);
+	plg_dictRelease(pSavepoint->tableImage);
+	plg_dictRelease(pSavepoint->delPage);
+	plg_dictRelease(pSavepoint->allocPage);
+	free(pSavepoint);
+}
+
+static void cache_SavepointEmpty(PCacheHandle pCacheHandle) {
+
+	listIter* iter = plg_listGetIterator(pCacheHandle->savepoint, AL_START_HEAD);
+	listNode* node;
+	while ((node = plg_listNext(iter)) != NULL) {
+		cache_SavepointDestroy(pCacheHandle, listNodeValue(node));
+	}
+	plg_listReleaseIterator(iter);
+	plg_listEmpty(pCacheHandle->savepoint);
+}
+
+/*
+Keep the old image of the page before its first change after the current savepoint
+*/
+static void cache_SavepointPage(PCacheHandle pCacheHandle, unsigned int pageAddr) {
+
+	listNode* node = listLast(pCacheHandle->savepoint);
+	if (!node) {
+		return;
+	}
+
+	PCacheSavepoint pSavepoint = listNodeValue(node);
+	if (plg_dictFind(pSavepoint->pageImage, &pageAddr)) {
+		return;
+	}
+
+	void* image = 0;
+	dictEntry* entry = plg_dictFind(plg_ListDictDict(pCacheHandle->transaction_listDictPageCache), &pageAddr);
+	if (entry) {
+		image = plg_MemListPop(pCacheHandle->memoryListPage);
+		memcpy(image, plg_ListDictGetVal(entry), FULLSIZE(pCacheHandle->pageSize));
+	}
+	dictAddWithUint(pSavepoint->pageImage, pageAddr, image);
+}
+
+/*
+Keep the old image of the table head before its first change after the current savepoint
+*/
+static void cache_SavepointTable(PCacheHandle pCacheHandle, sds table) {
+
+	listNode* node = listLast(pCacheHandle->savepoint);
+	if (!node) {
+		return;
+	}
+
+	PCacheSavepoint pSavepoint = listNodeValue(node);
+	if (plg_dictFind(pSavepoint->tableImage, table)) {
+		return;
+	}
+
+	void* image = 0;
+	dictEntry* entry = plg_dictFind(plg_ListDictDict(pCacheHandle->transaction_listDictTableInFile), table);
+	if (entry) {
+		image = plg_MemListPop(pCacheHandle->memoryListTable);
+		memcpy(image, plg_ListDictGetVal(entry), sizeof(TableInFile));
+	}
+	plg_dictAdd(pSavepoint->tableImage, plg_sdsNewLen(table, plg_sdsLen(table)), image);
+}
+
+/*
+Put the transaction back to the state of the savepoint, the images are moved back to the transaction
+*/
+static void cache_SavepointUndo(PCacheHandle pCacheHandle, PCacheSavepoint pSavepoint) {
+
+	dictIterator* iter = plg_dictGetSafeIterator(pSavepoint->pageImage);
+	dictEntry* node;
+	while ((node = plg_dictNext(iter)) != NULL) {
+		plg_ListDictDel(pCacheHandle->transaction_listDictPageCache, dictGetKey(node));
+
+		PDiskPageHead image = dictGetVal(node);
+		if (image) {
+			plg_ListDictAdd(pCacheHandle->transaction_listDictPageCache, &image->addr, image);
+		}
+	}
+	plg_dictReleaseIterator(iter);
+	plg_dictEmpty(pSavepoint->pageImage, NULL);
+
+	iter = plg_dictGetSafeIterator(pSavepoint->tableImage);
+	while ((node = plg_dictNext(iter)) != NULL) {
+		plg_ListDictDel(pCacheHandle->transaction_listDictTableInFile, dictGetKey(node));
+
+		void* image = dictGetVal(node);
+		if (image) {
+			dictEntry* tableEntry = plg_dictFind(plg_ListDictDict(pCacheHandle->listTableHandle), dictGetKey(node));
+			if (tableEntry) {
+				plg_ListDictAdd(pCacheHandle->transaction_listDictTableInFile, dictGetKey(tableEntry), image);
+			} else {
+				plg_MemListPush(pCacheHandle->memoryListTable, image);
+			}
+		}
+	}
+	plg_dictReleaseIterator(iter);
+	plg_dictEmpty(pSavepoint->tableImage, NULL);
+
+	//Pages allocated after the savepoint are no longer used and are freed on commit
+	plg_dictEmpty(pCacheHandle->transaction_delPage, NULL);
+	iter = plg_dictGetSafeIterator(pSavepoint->delPage);
+	while ((node = plg_dictNext(iter)) != NULL) {
+		dictAddWithUint(pCacheHandle->transaction_delPage, *(unsigned int*)dictGetKey(node), NULL);
+	}
+	plg_dictReleaseIterator(iter);
+
+	iter = plg_dictGetSafeIterator(pSavepoint->allocPage);
+	while ((node = plg_dictNext(iter)) != NULL) {
+		dictAddWithUint(pCacheHandle->transaction_delPage, *(unsigned int*)dictGetKey(node), NULL);
+	}
+	plg_dictReleaseIterator(iter);
+	plg_dictEmpty(pSavepoint->allocPage, NULL);
+
+	//Page chains detached after the savepoint stay with their tables
+	listNode* reclaimNode;
+	while (listLength(pCacheHandle->transaction_reclaim) > pSavepoint->reclaimLength) {
+		reclaimNode = listLast(pCacheHandle->transaction_reclaim);
+		free(listNodeValue(reclaimNode));
+		plg_listDelNode(pCacheHandle->transaction_reclaim, reclaimNode);
+	}
+	plg_dictEmpty(pCacheHandle->compact, NULL);
+	cache_ResetFreeSpace(pCacheHandle);
+}
+
+/*
+Move the images of the savepoint to the previous savepoint, the older image wins
+*/
+static void cache_SavepointMerge(PCacheHandle pCacheHandle, PCacheSavepoint pSavepoint, PCacheSavepoint pPrevSavepoint) {
+
+	dictIterator* iter = plg_dictGetSafeIterator(pSavepoint->pageImage);
+	dictEntry* node;
+	while ((node = plg_dictNext(iter)) != NULL) {
+		if (plg_dictFind(pPrevSavepoint->pageImage, dictGetKey(node))) {
+			if (dictGetVal(node)) {
+				plg_MemListPush(pCacheHandle->memoryListPage, dictGetVal(node));
+			}
+		} else {
+			dictAddWithUint(pPrevSavepoint->pageImage, *(unsigned int*)dictGetKey(node), dictGetVal(node));
+		}
+	}
+	plg_dictReleaseIterator(iter);
+	plg_dictEmpty(pSavepoint->pageImage, NULL);
+
+	iter = plg_dictGetSafeIterator(pSavepoint->tableImage);
+	while ((node = plg_dictNext(iter)) != NULL) {
+		if (plg_dictFind(pPrevSavepoint->tableImage, dictGetKey(node))) {
+			if (dictGetVal(node)) {
+				plg_MemListPush(pCacheHandle->memoryListTable, dictGetVal(node));
+			}
+		} else {
+			sds table = dictGetKey(node);
+			plg_dictAdd(pPrevSavepoint->tableImage, plg_sdsNewLen(table, plg_sdsLen(table)), dictGetVal(node));
+		}
+	}
+	plg_dictReleaseIterator(iter);
+	plg_dictEmpty(pSavepoint->tableImage, NULL);
+
+	iter = plg_dictGetSafeIterator(pSavepoint->allocPage);
+	while ((node = plg_dictNext(iter)) != NULL) {
+		dictAddWithUint(pPrevSavepoint->allocPage, *(unsigned int*)dictGetKey(node), NULL);
+	}
+	plg_dictReleaseIterator(iter);
+	plg_dictEmpty(pSavepoint->allocPage, NULL);
+}
 /*
 loading page from file;
 */
@@ -231,6 +587,33 @@ void plg_CacheSetStat(void* pvCacheHandle, short stat) {
 	pCacheHandle->isOpenStat = stat;
 }
 
+/*
+Take the page frames from the arena of the manager, shared by all caches,
+frames beyond the arena come from malloc. 0 keeps malloc for every frame
+*/
+void plg_CacheSetPageArena(void* pvCacheHandle, void* pageArena) {
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	if (pageArena) {
+		plg_MemListSetArena(pCacheHandle->memoryListPage, pageArena);
+	}
+}
+
+/*
+Free page frames kept by the cache for reuse, the ones beyond are freed at once. 0 means no limit
+*/
+void plg_CacheSetPageHighWater(void* pvCacheHandle, unsigned int pageHighWater) {
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	plg_MemListSetHighWater(pCacheHandle->memoryListPage, pageHighWater);
+}
+
+/*
+Set before the job threads start, a cache that is not shared is only used by its own job
+*/
+void plg_CacheSetShare(void* pvCacheHandle, short isShare) {
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	pCacheHandle->isShare = isShare;
+}
+
 static unsigned int cache_ArrangementCheckBigValue(void* pvCacheHandle, void* page) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
@@ -274,6 +657,23 @@ static unsigned int cache_ArrangementCheck(void* pTableHandle, void* page) {
 		return 0;
 	}
 
+	//A sparse page of a table is merged into its neighbour by the job in its idle time,
+	//the deleted space of any page is still arranged at once
+	unsigned int pageSize = FULLSIZE(pCacheHandle->pageSize) - sizeof(DiskPageHead) - sizeof(DiskTablePage);
+	if (!((PTableInFile)plg_TablePTableInFile(pTableHandle))->isSetHead &&
+		((float)pDiskTablePage->usingLength / pageSize * 100) < _COMPACTSPARSE_) {
+
+		dictEntry* entry = plg_dictFind(pCacheHandle->compact, &pDiskPageHead->addr);
+		if (entry == NULL) {
+			PCacheCompact pCacheCompact = malloc(sizeof(CacheCompact));
+			pCacheCompact->table = plg_sdsDup(plg_TableName(pTableHandle));
+			pCacheCompact->freeSize = pageSize - pDiskTablePage->usingLength;
+			dictAddWithUint(pCacheHandle->compact, pDiskPageHead->addr, pCacheCompact);
+		} else {
+			((PCacheCompact)dictGetVal(entry))->freeSize = pageSize - pDiskTablePage->usingLength;
+		}
+	}
+
 	unsigned long long sec = plg_GetCurrentSec();
 	if (pDiskTablePage->arrangmentStamp == 0) {
 		pDiskTablePage->arrangmentStamp = sec;
@@ -284,7 +684,6 @@ static unsigned int cache_ArrangementCheck(void* pTableHandle, void* page) {
 	}
 	pDiskTablePage->arrangmentStamp = sec;
 
-	unsigned int pageSize = FULLSIZE(pCacheHandle->pageSize) - sizeof(DiskPageHead) - sizeof(DiskTablePage);
 	if (((float)pDiskTablePage->delSize / pageSize * 100) > _ARRANGMENTPERCENTAGE_) {
 		plg_TableArrangementPage(pCacheHandle->pageSize, page);
 	}
@@ -381,8 +780,16 @@ static unsigned int cache_CreatePage(void* pTableHandle,
 			return 0;
 		}
 
+		listNode* savepointNode = listLast(pCacheHandle->savepoint);
+		if (savepointNode) {
+			PCacheSavepoint pSavepoint = listNodeValue(savepointNode);
+			dictAddWithUint(pSavepoint->allocPage, pageAddr, NULL);
+		}
+
 		elog(log_fun, "cache_CreatePage.plg_DiskAllocPage:%i", pageAddr);
 	}
+	cache_SavepointPage(pCacheHandle, pageAddr);
+
 	//calloc memory
 	*retPage = plg_MemListPop(pCacheHandle->memoryListPage);
 	memset(*retPage, 0, FULLSIZE(pCacheHandle->pageSize));
@@ -415,13 +822,31 @@ static unsigned int cache_DelPage(void* pTableHandle, unsigned int pageAddr) {
 	}
 
 	//add to transaction
+	cache_SavepointPage(pCacheHandle, pageAddr);
 	plg_ListDictDel(pCacheHandle->transaction_listDictPageCache, &pageAddr);
 
 	//Temporary recycle pageAddr
 	dictAddWithUint(pCacheHandle->transaction_delPage, pageAddr, NULL);
+	plg_dictDelete(pCacheHandle->compact, &pageAddr);
 	return 1;
 }
 
+/*
+The chain is detached from the table in the transaction and freed after the commit
+*/
+static unsigned int cache_ReclaimPage(void* pTableHandle, unsigned int pageAddr, short scanSet) {
+
+	PCacheHandle pCacheHandle = plg_TableOperateHandle(pTableHandle);
+	elog(log_fun, "cache_ReclaimPage %i", pageAddr);
+
+	PCacheReclaim pCacheReclaim = malloc(sizeof(CacheReclaim));
+	pCacheReclaim->headAddr = pageAddr;
+	pCacheReclaim->pageAddr = pageAddr;
+	pCacheReclaim->scanSet = scanSet;
+	pCacheReclaim->savedAddr = 0;
+	plg_listAddNodeTail(pCacheHandle->transaction_reclaim, pCacheReclaim);
+	return 1;
+}
 
 static void* cache_pageCopyOnWrite(void* pTableHandle, unsigned int pageAddr, void* page) {
 	
@@ -439,6 +864,7 @@ static void* cache_pageCopyOnWrite(void* pTableHandle, unsigned int pageAddr, vo
 		plg_assert(plg_TableCheckSpace(page));
 	}
 
+	cache_SavepointPage(pCacheHandle, pageAddr);
 	dictEntry* entry = plg_dictFind(plg_ListDictDict(pCacheHandle->transaction_listDictPageCache), &pageAddr);
 	if (entry) {
 		PDiskPageHead pDiskPageHead = (PDiskPageHead)plg_ListDictGetVal(entry);
@@ -470,6 +896,7 @@ static void* cache_tableCopyOnWrite(void* pTableHandle, sds table, void* tableHe
 		return tableHead;
 	}
 
+	cache_SavepointTable(pCacheHandle, table);
 	entry = plg_dictFind(plg_ListDictDict(pCacheHandle->transaction_listDictTableInFile), table);
 	if (entry) {
 		return plg_ListDictGetVal(entry);
@@ -511,6 +938,35 @@ static void* cache_findTableInFile(void* pTableHandle, sds table, void* tableInF
 	return tableInFile;
 }
 
+/*
+Send the pages that are not in memory to the file thread to be read ahead,
+pageAddr is reused to hold the pages sent, and the number sent is returned
+*/
+static unsigned int cache_PrefetchPage(void* pTableHandle, unsigned int* pageAddr, unsigned int count) {
+
+	PCacheHandle pCacheHandle = plg_TableOperateHandle(pTableHandle);
+	if (plg_DiskIsNoSave(pCacheHandle->pDiskHandle)) {
+		return 0;
+	}
+
+	unsigned int sendCount = 0;
+	for (unsigned int l = 0; l < count; l++) {
+		if (pCacheHandle->recent && plg_dictFind(plg_ListDictDict(pCacheHandle->transaction_listDictPageCache), &pageAddr[l]) != 0) {
+			continue;
+		}
+		if (plg_dictFind(plg_ListDictDict(pCacheHandle->listPageCache), &pageAddr[l]) != 0) {
+			continue;
+		}
+		pageAddr[sendCount++] = pageAddr[l];
+	}
+
+	if (sendCount) {
+		elog(log_details, "cache_PrefetchPage.count:%i", sendCount);
+		plg_FilePrefetchPage(plg_DiskFileHandle(pCacheHandle->pDiskHandle), pageAddr, sendCount);
+	}
+	return sendCount;
+}
+
 static TableHandleCallBack tableHandleCallBack = {
 	cache_FindPage,
 	cache_CreatePage,
@@ -520,7 +976,9 @@ static TableHandleCallBack tableHandleCallBack = {
 	cache_addDirtyPage,
 	cache_tableCopyOnWrite,
 	cache_addDirtyTable,
-	cache_findTableInFile
+	cache_findTableInFile,
+	cache_PrefetchPage,
+	cache_ReclaimPage
 };
 
 static void FreeCallback(void *privdata, void *val) {
@@ -553,13 +1011,21 @@ void* plg_CacheCreateHandle(void* pDiskHandle) {
 	pCacheHandle->listTableHandle = plg_ListDictCreateHandle(&tableDictType, DICT_MIDDLE, LIST_MIDDLE, plg_TableHandleCmpFun, pCacheHandle);
 	pCacheHandle->dictTableHandleDirty = plg_dictCreate(plg_DefaultSdsDictPtr(), NULL, DICT_MIDDLE);
 	pCacheHandle->delPage = plg_dictCreate(plg_DefaultUintPtr(), NULL, DICT_MIDDLE);
+	pCacheHandle->reclaim = plg_listCreate(LIST_MIDDLE);
+	listSetFreeMethod(pCacheHandle->reclaim, free);
+	pCacheHandle->reclaimDone = plg_dictCreate(plg_DefaultUintPtr(), NULL, DICT_MIDDLE);
+	pCacheHandle->reclaimSave = 0;
+	pCacheHandle->compact = plg_dictCreate(&compactDictType, NULL, DICT_MIDDLE);
 
 	pCacheHandle->mutexHandle = plg_MutexCreateHandle(LockLevel_1);
+	pCacheHandle->isShare = 1;
 	pCacheHandle->objectName = plg_sdsNew("cache");
 
 	pCacheHandle->transaction_listDictPageCache = plg_ListDictCreateHandle(&pageDictType, DICT_MIDDLE, LIST_MIDDLE, NULL, pCacheHandle);
 	pCacheHandle->transaction_listDictTableInFile = plg_ListDictCreateHandle(&tableHeadDictType, DICT_MIDDLE, LIST_MIDDLE, NULL, pCacheHandle);
 	pCacheHandle->transaction_delPage = plg_dictCreate(plg_DefaultUintPtr(), NULL, DICT_MIDDLE);
+	pCacheHandle->transaction_reclaim = plg_listCreate(LIST_MIDDLE);
+	pCacheHandle->savepoint = plg_listCreate(LIST_MIDDLE);
 	pCacheHandle->memoryListPage = plg_MemListCreate(60, FULLSIZE(pCacheHandle->pageSize), 0);
 	pCacheHandle->memoryListTable = plg_MemListCreate(60, sizeof(TableInFile), 0);
 
@@ -582,10 +1048,17 @@ void plg_CacheDestroyHandle(void* pvCacheHandle) {
 	plg_ListDictDestroyHandle(pCacheHandle->listTableHandle);
 	plg_dictRelease(pCacheHandle->dictTableHandleDirty);
 	plg_dictRelease(pCacheHandle->delPage);
+	plg_listRelease(pCacheHandle->reclaim);
+	plg_dictRelease(pCacheHandle->reclaimDone);
+	plg_dictRelease(pCacheHandle->compact);
 
 	plg_ListDictDestroyHandle(pCacheHandle->transaction_listDictPageCache);
 	plg_ListDictDestroyHandle(pCacheHandle->transaction_listDictTableInFile);
 	plg_dictRelease(pCacheHandle->transaction_delPage);
+	cache_ReclaimEmpty(pCacheHandle->transaction_reclaim);
+	plg_listRelease(pCacheHandle->transaction_reclaim);
+	cache_SavepointEmpty(pCacheHandle);
+	plg_listRelease(pCacheHandle->savepoint);
 
 	plg_MemListDestory(pCacheHandle->memoryListPage);
 	plg_MemListDestory(pCacheHandle->memoryListTable);
@@ -602,7 +1075,7 @@ void plg_CacheDestroyHandle(void* pvCacheHandle) {
 ڱز,
 Ȼȥdisk,
 */
-static void* cahce_GetTableHandle(void* pvCacheHandle, sds sdsTable) {
+static void* cache_FindTableHandle(void* pvCacheHandle, sds sdsTable) {
 
 	//find in local
 	PCacheHandle pCacheHandle = pvCacheHandle;
@@ -637,10 +1110,51 @@ static void* cahce_GetTableHandle(void* pvCacheHandle, sds sdsTable) {
 	return 0;
 }
 
+/*
+Anything but a set operation reads the set heads from the table keys,
+So the set heads kept by the transaction are written back first
+*/
+static void* cahce_GetTableHandle(void* pvCacheHandle, sds sdsTable) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	void* pTableHandle = cache_FindTableHandle(pCacheHandle, sdsTable);
+	if (pTableHandle != 0) {
+		plg_TableSetHeadCache(pTableHandle, 0);
+		if (pCacheHandle->recent) {
+			plg_TableSetHeadFlush(pTableHandle, 1);
+		}
+	}
+	return pTableHandle;
+}
+
+/*
+The set operations of the transaction keep the resolved set heads until it ends,
+Reading the last commit resolves them from the table keys
+*/
+static void* cache_GetSetTableHandle(void* pvCacheHandle, sds sdsTable) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	void* pTableHandle = cache_FindTableHandle(pCacheHandle, sdsTable);
+	if (pTableHandle != 0) {
+		plg_TableSetHeadCache(pTableHandle, pCacheHandle->recent);
+	}
+	return pTableHandle;
+}
+
+static void cache_SetHeadFlush(PCacheHandle pCacheHandle, short isWrite) {
+
+	listIter* iter = plg_listGetIterator(plg_ListDictList(pCacheHandle->listTableHandle), AL_START_HEAD);
+	listNode* node;
+	while ((node = plg_listNext(iter)) != NULL) {
+		plg_TableSetHeadFlush(listNodeValue(node), isWrite);
+	}
+	plg_listReleaseIterator(iter);
+}
+
 unsigned short plg_CacheGetTableType(void* pvCacheHandle, sds sdsTable, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	int r = 0;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
@@ -648,42 +1162,42 @@ unsigned short plg_CacheGetTableType(void* pvCacheHandle, sds sdsTable, short re
 		r = plg_TableGetTableType(pTableHandle);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
 unsigned short plg_CacheSetTableType(void* pvCacheHandle, sds sdsTable, unsigned short tableType) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	unsigned short r = 0;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 
 		r = plg_TableSetTableType(pTableHandle, tableType);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
 unsigned short plg_CacheSetTableTypeIfByte(void* pvCacheHandle, sds sdsTable, unsigned short tableType) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	unsigned short r = 0;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 
 		r = plg_TableSetTableTypeIfByte(pTableHandle, tableType);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
-unsigned int plg_CacheTableAdd(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* value, unsigned int length) {
+unsigned int plg_CacheTableAdd(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* value, unsigned int length) {
 	
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	unsigned int r = 0;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
@@ -697,7 +1211,46 @@ unsigned int plg_CacheTableAdd(void* pvCacheHandle, sds sdsTable, void* vKey, sh
 		}
 		
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
+	return r;
+}
+
+unsigned int plg_CacheTableCompareAndSet(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* oldValue, unsigned int oldLength, void* value, unsigned int length) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	CacheLock(pCacheHandle);
+	unsigned int r = 0;
+	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	if (pTableHandle != 0) {
+		r = plg_TableCompareAndSet(pTableHandle, vKey, keyLen, oldValue, oldLength, value, length);
+	}
+	CacheUnlock(pCacheHandle);
+	return r;
+}
+
+unsigned int plg_CacheTableIncrDouble(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, double increment, double* result) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	CacheLock(pCacheHandle);
+	unsigned int r = 0;
+	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	if (pTableHandle != 0) {
+		r = plg_TableIncrDouble(pTableHandle, vKey, keyLen, increment, result);
+	}
+	CacheUnlock(pCacheHandle);
+	return r;
+}
+
+unsigned int plg_CacheTableAppend(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* value, unsigned int length) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	CacheLock(pCacheHandle);
+	unsigned int r = 0;
+	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	if (pTableHandle != 0) {
+		r = plg_TableAppend(pTableHandle, vKey, keyLen, value, length);
+	}
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
@@ -705,20 +1258,20 @@ unsigned int plg_CacheTableMultiAdd(void* pvCacheHandle, sds sdsTable, void* pDi
 
 	unsigned int r = 0;
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		r = plg_TableMultiAdd(pTableHandle, pDictExten);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 
 	return r;
 };
 
-unsigned int plg_CacheTableAddIfNoExist(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* value, unsigned int length) {
+unsigned int plg_CacheTableAddIfNoExist(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* value, unsigned int length) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	unsigned int r = 0;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
@@ -732,27 +1285,27 @@ unsigned int plg_CacheTableAddIfNoExist(void* pvCacheHandle, sds sdsTable, void*
 		}
 
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
-unsigned int plg_CacheTableRename(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* vNewKey, short newKeyLen) {
+unsigned int plg_CacheTableRename(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* vNewKey, unsigned int newKeyLen) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	unsigned int r = 0;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		r = plg_TableRename(pTableHandle, vKey, keyLen, vNewKey, newKeyLen);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
-unsigned int plg_CacheTableIsKeyExist(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, short recent) {
+unsigned int plg_CacheTableIsKeyExist(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	unsigned int r = 0;
 	pCacheHandle->recent = recent;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
@@ -760,20 +1313,20 @@ unsigned int plg_CacheTableIsKeyExist(void* pvCacheHandle, sds sdsTable, void* v
 		r = plg_TableIsKeyExist(pTableHandle, vKey, keyLen);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
-unsigned int plg_CacheTableDel(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen) {
+unsigned int plg_CacheTableDel(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	unsigned int r = 0;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		r = plg_TableDel(pTableHandle, vKey, keyLen);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
@@ -786,10 +1339,10 @@ Based on the above, read-only data can be concurrent without lock. One is that i
 2 The improvement of efficiency is limited in which part of data is read before data is written. 3 Degradation of a lock that writes data results in increased complexity.
 Because the use time of the mutex is reduced, the efficiency is improved to some extent, but the improvement is not obvious.
 */
-int plg_CacheTableFind(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* pDictExten, short recent) {
+int plg_CacheTableFind(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	int r = 0;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
@@ -797,35 +1350,48 @@ int plg_CacheTableFind(void* pvCacheHandle, sds sdsTable, void* vKey, short keyL
 		r = plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 0);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
 void plg_CacheTableMultiFind(void* pvCacheHandle, sds sdsTable, void* pKeyDictExten, void* pValueDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableMultiFind(pTableHandle, pKeyDictExten, pValueDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
+}
+
+void plg_CacheTablePrefetch(void* pvCacheHandle, sds sdsTable, void* pKeyDictExten, short recent) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	CacheLock(pCacheHandle);
+	pCacheHandle->recent = recent;
+	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	if (pTableHandle != 0) {
+		plg_TablePrefetch(pTableHandle, pKeyDictExten);
+	}
+	pCacheHandle->recent = 1;
+	CacheUnlock(pCacheHandle);
 }
 
 unsigned int plg_CacheTableRand(void* pvCacheHandle, sds sdsTable, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int r = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		r = plg_TableRand(pTableHandle, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
@@ -833,7 +1399,7 @@ unsigned int plg_CacheTableLength(void* pvCacheHandle, sds sdsTable, short recen
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int len = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
@@ -841,248 +1407,263 @@ unsigned int plg_CacheTableLength(void* pvCacheHandle, sds sdsTable, short recen
 		len = plg_TableLength(pTableHandle);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return len;
 }
 
-void plg_CacheTableLimite(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, unsigned int left , unsigned int right, void* pDictExten, short recent) {
+void plg_CacheTableLimite(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, unsigned int left , unsigned int right, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableLimite(pTableHandle, vKey, keyLen, left, right, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
 void plg_CacheTableOrder(void* pvCacheHandle, sds sdsTable, short order, unsigned int limite, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableOrder(pTableHandle, order, limite, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
-void plg_CacheTableRang(void* pvCacheHandle, sds sdsTable, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pDictExten, short recent) {
+void plg_CacheTableRang(void* pvCacheHandle, sds sdsTable, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableRang(pTableHandle, beginKey, beginKeyLen, endKey, endKeyLen, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
+}
+
+unsigned int plg_CacheTableRangBatch(void* pvCacheHandle, sds sdsTable, void* beginKey, unsigned int beginKeyLen, short afterBegin, void* endKey, unsigned int endKeyLen, unsigned int limit, void* pDictExten, short recent) {
+
+	unsigned int r = 1;
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	CacheLock(pCacheHandle);
+	pCacheHandle->recent = recent;
+	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	if (pTableHandle != 0) {
+		r = plg_TableRangBatch(pTableHandle, beginKey, beginKeyLen, afterBegin, endKey, endKeyLen, limit, pDictExten);
+	}
+	pCacheHandle->recent = 1;
+	CacheUnlock(pCacheHandle);
+	return r;
 }
 
-void plg_CacheTablePoint(void* pvCacheHandle, sds sdsTable, void* beginKey, short beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten, short recent) {
+void plg_CacheTablePoint(void* pvCacheHandle, sds sdsTable, void* beginKey, unsigned int beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TablePoint(pTableHandle, beginKey, beginKeyLen, direction, offset, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
-void plg_CacheTablePattern(void* pvCacheHandle, sds sdsTable, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pattern, short patternLen, void* pDictExten, short recent) {
+void plg_CacheTablePattern(void* pvCacheHandle, sds sdsTable, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pattern, short patternLen, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TablePattern(pTableHandle, beginKey, beginKeyLen, endKey, endKeyLen, pattern, patternLen, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
 void plg_CacheTableMembers(void* pvCacheHandle, sds sdsTable, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableMembers(pTableHandle, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
 void plg_CacheTableClear(void* pvCacheHandle, sds sdsTable) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableClear(pTableHandle, 1);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
-unsigned int plg_CacheTableSetAdd(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* vValue, short valueLen) {
+unsigned int plg_CacheTableSetAdd(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	unsigned int r = 0;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		r = plg_TableSetAdd(pTableHandle, vKey, keyLen, vValue, valueLen);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
-void plg_CacheTableSetRang(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen, void* pDictExten, short recent) {
+void plg_CacheTableSetRang(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetRang(pTableHandle, vKey, keyLen, beginValue, beginValueLen, endValue, endValueLen, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
-void plg_CacheTableSetPoint(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* beginValue, short beginValueLen, unsigned int direction, unsigned int offset, void* pDictExten, short recent) {
+void plg_CacheTableSetPoint(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, unsigned int direction, unsigned int offset, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetPoint(pTableHandle, vKey, keyLen, beginValue, beginValueLen, direction, offset, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
-void plg_CacheTableSetLimite(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* vValue, short valueLen, unsigned int left, unsigned int right, void* pDictExten, short recent) {
+void plg_CacheTableSetLimite(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen, unsigned int left, unsigned int right, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetLimite(pTableHandle, vKey, keyLen, vValue, valueLen, left, right, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
-unsigned int plg_CacheTableSetLength(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, short recent) {
+unsigned int plg_CacheTableSetLength(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int len = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		len = plg_TableSetLength(pTableHandle, vKey, keyLen);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return len;
 }
 
-unsigned int plg_CacheTableSetIsKeyExist(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* vValue, short valueLen, short recent) {
+unsigned int plg_CacheTableSetIsKeyExist(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	unsigned int r = 0;
 	pCacheHandle->recent = recent;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		r = plg_TableSetIsKeyExist(pTableHandle, vKey, keyLen, vValue, valueLen);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
-void plg_CacheTableSetMembers(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* pDictExten, short recent) {
+void plg_CacheTableSetMembers(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetMembers(pTableHandle, vKey, keyLen, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
-unsigned int plg_CacheTableSetRand(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* pDictExten, short recent) {
+unsigned int plg_CacheTableSetRand(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int r = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		r = plg_TableSetRand(pTableHandle, vKey, keyLen, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
-void plg_CacheTableSetDel(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* pValueDictExten) {
+void plg_CacheTableSetDel(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* pValueDictExten) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	CacheLock(pCacheHandle);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetDel(pTableHandle, vKey, keyLen, pValueDictExten);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
-unsigned int plg_CacheTableSetPop(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* pDictExten, short recent) {
+unsigned int plg_CacheTableSetPop(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* pDictExten, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int r = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		r = plg_TableSetPop(pTableHandle, vKey, keyLen, pDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return r;
 }
 
-unsigned int plg_CacheTableSetRangCount(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen, short recent) {
+unsigned int plg_CacheTableSetRangCount(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen, short recent) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int count = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		count = plg_TableSetRangCount(pTableHandle, vKey, keyLen, beginValue, beginValueLen, endValue, endValueLen);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return count;
 }
 
@@ -1095,27 +1676,27 @@ unsigned int plg_CacheTableSetUion(void* pvCacheHandle, sds sdsTable, void* pSet
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int count = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetUion(pTableHandle, pSetDictExten, pKeyDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return count;
 }
 
-unsigned int plg_CacheTableSetUionStore(void* pvCacheHandle, sds sdsTable, void* pSetDictExten, void* vKey, short keyLen) {
+unsigned int plg_CacheTableSetUionStore(void* pvCacheHandle, sds sdsTable, void* pSetDictExten, void* vKey, unsigned int keyLen) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int count = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	CacheLock(pCacheHandle);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetUionStore(pTableHandle, pSetDictExten, vKey, keyLen);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return count;
 }
 
@@ -1123,27 +1704,27 @@ unsigned int plg_CacheTableSetInter(void* pvCacheHandle, sds sdsTable, void* pSe
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int count = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetInter(pTableHandle, pSetDictExten, pKeyDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return count;
 }
 
-unsigned int plg_CacheTableSetInterStore(void* pvCacheHandle, sds sdsTable, void* pSetDictExten, void* vKey, short keyLen) {
+unsigned int plg_CacheTableSetInterStore(void* pvCacheHandle, sds sdsTable, void* pSetDictExten, void* vKey, unsigned int keyLen) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int count = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	CacheLock(pCacheHandle);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetInterStore(pTableHandle, pSetDictExten, vKey, keyLen);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return count;
 }
 
@@ -1151,40 +1732,40 @@ unsigned int plg_CacheTableSetDiff(void* pvCacheHandle, sds sdsTable, void* pSet
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int count = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetDiff(pTableHandle, pSetDictExten, pKeyDictExten);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return count;
 }
 
-unsigned int plg_CacheTableSetDiffStore(void* pvCacheHandle, sds sdsTable, void* pSetDictExten, void* vKey, short keyLen) {
+unsigned int plg_CacheTableSetDiffStore(void* pvCacheHandle, sds sdsTable, void* pSetDictExten, void* vKey, unsigned int keyLen) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int count = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	CacheLock(pCacheHandle);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetDiffStore(pTableHandle, pSetDictExten, vKey, keyLen);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return count;
 }
 
-unsigned int plg_CacheTableSetMove(void* pvCacheHandle, sds sdsTable, void* vSrcKey, short  srcKeyLen, void* vDesKey, short desKeyLen, void* vValue, short valueLen) {
+unsigned int plg_CacheTableSetMove(void* pvCacheHandle, sds sdsTable, void* vSrcKey, unsigned int srcKeyLen, void* vDesKey, unsigned int desKeyLen, void* vValue, unsigned int valueLen) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int count = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
-	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
+	CacheLock(pCacheHandle);
+	void* pTableHandle = cache_GetSetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableSetMove(pTableHandle, vSrcKey, srcKeyLen, vDesKey, desKeyLen, vValue, valueLen);
 	}
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return count;
 }
 
@@ -1193,14 +1774,14 @@ unsigned int plg_CacheTableMembersWithJson(void* pvCacheHandle, sds sdsTable, vo
 	pJSON* jsonRoot = vjsonRoot;
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	unsigned int count = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	pCacheHandle->recent = recent;
 	void* pTableHandle = cahce_GetTableHandle(pCacheHandle, sdsTable);
 	if (pTableHandle != 0) {
 		plg_TableMembersWithJson(pTableHandle, jsonRoot);
 	}
 	pCacheHandle->recent = 1;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 	return count;
 }
 
@@ -1291,10 +1872,10 @@ static unsigned int cache_PageCount(void* pvCacheHandle) {
 
 void plg_CachePageAllCount(void* pvCacheHandle, unsigned long long* cacheCount, unsigned long long* freeCacheCount) {
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	*cacheCount = dictSize(plg_ListDictDict(pCacheHandle->listPageCache));
 	*freeCacheCount = pCacheHandle->freeCacheCount;
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
 
 void plg_CachePageCountPrint(void* pvCacheHandle, void* vroot) {
@@ -1302,7 +1883,7 @@ void plg_CachePageCountPrint(void* pvCacheHandle, void* vroot) {
 	pJSON* root = vroot;
 	PCacheHandle pCacheHandle = pvCacheHandle;
 
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
 	dictIterator* iter_readPage = plg_dictGetSafeIterator(pCacheHandle->tableName_readPage);
 	dictEntry* node_readPage;
 	while ((node_readPage = plg_dictNext(iter_readPage)) != NULL) {
@@ -1331,7 +1912,7 @@ void plg_CachePageCountPrint(void* pvCacheHandle, void* vroot) {
 
 	plg_dictEmpty(pCacheHandle->tableName_writePage, 0);
 	plg_dictEmpty(pCacheHandle->tableName_readPage, 0);
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 
 	return;
 }
@@ -1344,7 +1925,10 @@ int plg_CacheCommit(void* pvCacheHandle) {
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	elog(log_fun, "plg_CacheCommit %U", pCacheHandle);
 	short tableHead = 0, delPage = 0;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
+	cache_SetHeadFlush(pCacheHandle, 1);
+	cache_SavepointEmpty(pCacheHandle);
+
 	//copy from transaction_listDictPageCache to listPageCache
 	dict* t_listDictPageCache = plg_ListDictDict(pCacheHandle->transaction_listDictPageCache);
 	dictIterator* itert_listDictPageCache = plg_dictGetSafeIterator(t_listDictPageCache);
@@ -1417,9 +2001,19 @@ int plg_CacheCommit(void* pvCacheHandle) {
 	plg_dictReleaseIterator(itert_delpage);
 	plg_dictEmpty(pCacheHandle->transaction_delPage, NULL);
 
+	//reclaim
+	listIter* itert_reclaim = plg_listGetIterator(pCacheHandle->transaction_reclaim, AL_START_HEAD);
+	listNode* nodet_reclaim;
+	while ((nodet_reclaim = plg_listNext(itert_reclaim)) != NULL) {
+		plg_listAddNodeTail(pCacheHandle->reclaim, listNodeValue(nodet_reclaim));
+		pCacheHandle->reclaimSave = 1;
+	}
+	plg_listReleaseIterator(itert_reclaim);
+	plg_listEmpty(pCacheHandle->transaction_reclaim);
+
 	//pageCount
 	cache_PageCount(pCacheHandle);
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 
 	elog(log_details, "plg_CacheCommit.tableHead:%i delPage:%i", tableHead, delPage);
 	return 1;
@@ -1432,11 +2026,96 @@ int plg_CacheRollBack(void* pvCacheHandle) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
 	elog(log_fun, "plg_CacheRollBack %U", pCacheHandle);
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheLock(pCacheHandle);
+	cache_SetHeadFlush(pCacheHandle, 0);
+	cache_SavepointEmpty(pCacheHandle);
 	plg_ListDictEmpty(pCacheHandle->transaction_listDictPageCache);
 	plg_ListDictEmpty(pCacheHandle->transaction_listDictTableInFile);
 	plg_dictEmpty(pCacheHandle->transaction_delPage, NULL);
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	cache_ReclaimEmpty(pCacheHandle->transaction_reclaim);
+
+	//Pages of the transaction may be gone, they are found again by the next changes
+	plg_dictEmpty(pCacheHandle->compact, NULL);
+	cache_ResetFreeSpace(pCacheHandle);
+	CacheUnlock(pCacheHandle);
+
+	return 1;
+}
+
+/*
+Start a savepoint inside the current transaction.
+The id must be larger than the ids of the savepoints already in the transaction
+*/
+int plg_CacheSavepoint(void* pvCacheHandle, unsigned int id) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	elog(log_fun, "plg_CacheSavepoint %U %i", pCacheHandle, id);
+	CacheLock(pCacheHandle);
+	cache_SetHeadFlush(pCacheHandle, 1);
+	plg_listAddNodeTail(pCacheHandle->savepoint, cache_SavepointCreate(pCacheHandle, id));
+	CacheUnlock(pCacheHandle);
+
+	return 1;
+}
+
+/*
+Undo the changes made after the savepoint id, the savepoint itself is kept.
+Savepoints after it are removed
+*/
+int plg_CacheRollbackTo(void* pvCacheHandle, unsigned int id) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	elog(log_fun, "plg_CacheRollbackTo %U %i", pCacheHandle, id);
+	int r = 0;
+	CacheLock(pCacheHandle);
+	cache_SetHeadFlush(pCacheHandle, 1);
+	listNode* node;
+	while ((node = listLast(pCacheHandle->savepoint)) != NULL) {
+
+		PCacheSavepoint pSavepoint = listNodeValue(node);
+		if (pSavepoint->id < id) {
+			break;
+		}
+
+		cache_SavepointUndo(pCacheHandle, pSavepoint);
+		if (pSavepoint->id == id) {
+			cache_SavepointSnapDelPage(pCacheHandle, pSavepoint);
+			r = 1;
+			break;
+		}
+
+		plg_listDelNode(pCacheHandle->savepoint, node);
+		cache_SavepointDestroy(pCacheHandle, pSavepoint);
+	}
+	CacheUnlock(pCacheHandle);
+
+	return r;
+}
+
+/*
+Remove the savepoint id and the savepoints after it, the changes are kept in the transaction
+*/
+int plg_CacheReleaseSavepoint(void* pvCacheHandle, unsigned int id) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	elog(log_fun, "plg_CacheReleaseSavepoint %U %i", pCacheHandle, id);
+	CacheLock(pCacheHandle);
+	listNode* node;
+	while ((node = listLast(pCacheHandle->savepoint)) != NULL) {
+
+		PCacheSavepoint pSavepoint = listNodeValue(node);
+		if (pSavepoint->id < id) {
+			break;
+		}
+
+		plg_listDelNode(pCacheHandle->savepoint, node);
+		listNode* prevNode = listLast(pCacheHandle->savepoint);
+		if (prevNode) {
+			cache_SavepointMerge(pCacheHandle, pSavepoint, listNodeValue(prevNode));
+		}
+		cache_SavepointDestroy(pCacheHandle, pSavepoint);
+	}
+	CacheUnlock(pCacheHandle);
 
 	return 1;
 }
@@ -1511,6 +2190,287 @@ static void cache_Arrange(void* pvCacheHandle) {
 	pCacheHandle->cacheStamp = stamp;
 }
 
+static void cache_ReclaimAdd(PCacheHandle pCacheHandle, unsigned int pageAddr, short scanSet) {
+
+	if (pageAddr == 0) {
+		return;
+	}
+
+	PCacheReclaim pCacheReclaim = malloc(sizeof(CacheReclaim));
+	pCacheReclaim->headAddr = pageAddr;
+	pCacheReclaim->pageAddr = pageAddr;
+	pCacheReclaim->scanSet = scanSet;
+	pCacheReclaim->savedAddr = 0;
+	plg_listAddNodeTail(pCacheHandle->reclaim, pCacheReclaim);
+}
+
+static void cache_ReclaimDone(PCacheHandle pCacheHandle, listNode* node) {
+
+	PCacheReclaim pCacheReclaim = listNodeValue(node);
+	if (pCacheReclaim->savedAddr) {
+		dictAddWithUint(pCacheHandle->reclaimDone, pCacheReclaim->headAddr, NULL);
+	}
+	plg_listDelNode(pCacheHandle->reclaim, node);
+	pCacheHandle->reclaimSave = 1;
+}
+
+/*
+Write the records of the chains into the table list of the file, called under plg_DiskLock
+*/
+static void cache_ReclaimSave(PCacheHandle pCacheHandle) {
+
+	if (!pCacheHandle->reclaimSave) {
+		return;
+	}
+	pCacheHandle->reclaimSave = 0;
+
+	listIter* iter = plg_listGetIterator(pCacheHandle->reclaim, AL_START_HEAD);
+	listNode* node;
+	while ((node = plg_listNext(iter)) != NULL) {
+		PCacheReclaim pCacheReclaim = listNodeValue(node);
+		if (pCacheReclaim->savedAddr == pCacheReclaim->pageAddr) {
+			continue;
+		}
+
+		DiskReclaim diskReclaim;
+		diskReclaim.pageAddr = pCacheReclaim->pageAddr;
+		diskReclaim.scanSet = pCacheReclaim->scanSet;
+		if (plg_DiskInsideReclaimSet(pCacheHandle->pDiskHandle, pCacheReclaim->headAddr, &diskReclaim, sizeof(DiskReclaim))) {
+			pCacheReclaim->savedAddr = pCacheReclaim->pageAddr;
+		}
+	}
+	plg_listReleaseIterator(iter);
+
+	dictIterator* dictIter = plg_dictGetSafeIterator(pCacheHandle->reclaimDone);
+	dictEntry* dictNode;
+	while ((dictNode = plg_dictNext(dictIter)) != NULL) {
+		plg_DiskInsideReclaimSet(pCacheHandle->pDiskHandle, *(unsigned int*)dictGetKey(dictNode), NULL, 0);
+	}
+	plg_dictReleaseIterator(dictIter);
+	plg_dictEmpty(pCacheHandle->reclaimDone, NULL);
+}
+
+static void cache_ReclaimResumeCB(void* ptr, unsigned int headAddr, void* value, unsigned int length) {
+
+	PCacheHandle pCacheHandle = ptr;
+	if (length != sizeof(DiskReclaim)) {
+		elog(log_error, "cache_ReclaimResumeCB.length %i!", length);
+		return;
+	}
+
+	PDiskReclaim pDiskReclaim = value;
+	PCacheReclaim pCacheReclaim = malloc(sizeof(CacheReclaim));
+	pCacheReclaim->headAddr = headAddr;
+	pCacheReclaim->pageAddr = pDiskReclaim->pageAddr;
+	pCacheReclaim->scanSet = pDiskReclaim->scanSet;
+	pCacheReclaim->savedAddr = pDiskReclaim->pageAddr;
+	plg_listAddNodeTail(pCacheHandle->reclaim, pCacheReclaim);
+}
+
+/*
+Take over the chains left in the file by the last run, returns the number of chains taken
+*/
+unsigned int plg_CacheReclaimResume(void* pvCacheHandle) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	CacheLock(pCacheHandle);
+	plg_DiskReclaimResume(pCacheHandle->pDiskHandle, pCacheHandle, cache_ReclaimResumeCB);
+	unsigned int r = listLength(pCacheHandle->reclaim);
+	CacheUnlock(pCacheHandle);
+	return r;
+}
+
+/*
+The set heads of a freed table page own page chains that are freed with it
+*/
+static void cache_ReclaimSetHead(PCacheHandle pCacheHandle, void* page) {
+
+	PDiskTablePage pDiskTablePage = (PDiskTablePage)((unsigned char*)page + sizeof(DiskPageHead));
+	for (unsigned short l = 0; l < pDiskTablePage->tableSize; l++) {
+		PDiskTableElement pDiskTableElement = &pDiskTablePage->element[l];
+		if (pDiskTableElement->currentLevel != 0 || pDiskTableElement->keyOffset == 0) {
+			continue;
+		}
+
+		PDiskTableKey pDiskTableKey = (PDiskTableKey)POINTER(page, pDiskTableElement->keyOffset);
+		if (pDiskTableKey->valueType != VALUE_SETHEAD) {
+			continue;
+		}
+
+		PTableInFile pTableInFile = (PTableInFile)((unsigned char*)pDiskTableKey + sizeof(DiskTableKey) + pDiskTableKey->keyStrSize);
+		cache_ReclaimAdd(pCacheHandle, pTableInFile->tablePageHead, 0);
+		cache_ReclaimAdd(pCacheHandle, pTableInFile->tableUsingPage, 0);
+		cache_ReclaimAdd(pCacheHandle, pTableInFile->valuePage, 0);
+		cache_ReclaimAdd(pCacheHandle, pTableInFile->valueUsingPage, 0);
+	}
+}
+
+/*
+Free up to _RECLAIMCOUNT_ pages of the detached page chains, they are released at the next flush.
+The next pages of the chains are read ahead for the next step.
+Returns the number of chains still waiting
+*/
+unsigned int plg_CacheReclaim(void* pvCacheHandle) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	elog(log_fun, "plg_CacheReclaim %U", pCacheHandle);
+	CacheLock(pCacheHandle);
+	void* loadPage = 0;
+	unsigned int count = 0;
+	listNode* node;
+	while (count++ < _RECLAIMCOUNT_ && (node = listFirst(pCacheHandle->reclaim)) != NULL) {
+
+		PCacheReclaim pCacheReclaim = listNodeValue(node);
+		void* page;
+		dictEntry* entry = plg_dictFind(plg_ListDictDict(pCacheHandle->listPageCache), &pCacheReclaim->pageAddr);
+		if (entry) {
+			page = plg_ListDictGetVal(entry);
+		} else {
+			if (loadPage == 0) {
+				loadPage = plg_MemListPop(pCacheHandle->memoryListPage);
+			}
+			page = loadPage;
+			if (0 == cache_LoadPageFromFile(pCacheHandle, pCacheReclaim->pageAddr, page)) {
+				elog(log_error, "plg_CacheReclaim.disk load page %i!", pCacheReclaim->pageAddr);
+				cache_ReclaimDone(pCacheHandle, node);
+				continue;
+			}
+		}
+		pCacheHandle->reclaimSave = 1;
+
+		PDiskPageHead pDiskPageHead = page;
+		if (pCacheReclaim->scanSet && pDiskPageHead->type == TABLEPAGE) {
+			cache_ReclaimSetHead(pCacheHandle, page);
+		}
+
+		dictAddWithUint(pCacheHandle->delPage, pCacheReclaim->pageAddr, NULL);
+		plg_dictDelete(pCacheHandle->compact, &pCacheReclaim->pageAddr);
+		pCacheReclaim->pageAddr = pDiskPageHead->nextPage;
+		if (pCacheReclaim->pageAddr == 0) {
+			cache_ReclaimDone(pCacheHandle, node);
+		}
+	}
+
+	if (loadPage) {
+		plg_MemListPush(pCacheHandle->memoryListPage, loadPage);
+	}
+
+	if (!plg_DiskIsNoSave(pCacheHandle->pDiskHandle)) {
+		unsigned int pageAddr[_PREFETCHPAGE_];
+		unsigned int prefetchCount = 0;
+		listIter* iter = plg_listGetIterator(pCacheHandle->reclaim, AL_START_HEAD);
+		while ((node = plg_listNext(iter)) != NULL && prefetchCount < _PREFETCHPAGE_) {
+			PCacheReclaim pCacheReclaim = listNodeValue(node);
+			if (plg_dictFind(plg_ListDictDict(pCacheHandle->listPageCache), &pCacheReclaim->pageAddr) == 0) {
+				pageAddr[prefetchCount++] = pCacheReclaim->pageAddr;
+			}
+		}
+		plg_listReleaseIterator(iter);
+		if (prefetchCount) {
+			plg_FilePrefetchPage(plg_DiskFileHandle(pCacheHandle->pDiskHandle), pageAddr, prefetchCount);
+		}
+	}
+
+	unsigned int r = listLength(pCacheHandle->reclaim);
+	CacheUnlock(pCacheHandle);
+	return r;
+}
+
+unsigned int plg_CacheReclaimLength(void* pvCacheHandle) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	CacheLock(pCacheHandle);
+	unsigned int r = listLength(pCacheHandle->reclaim);
+	CacheUnlock(pCacheHandle);
+	return r;
+}
+
+typedef struct _CacheCompactPage
+{
+	unsigned int pageAddr;
+	unsigned int freeSize;
+} *PCacheCompactPage, CacheCompactPage;
+
+static int cache_CompactCmp(void* v1, void* v2) {
+
+	PCacheCompactPage p1 = v1, p2 = v2;
+	if (p1->freeSize == p2->freeSize) {
+		return 0;
+	}
+	return p1->freeSize < p2->freeSize ? 1 : -1;
+}
+
+/*
+Compact up to _COMPACTCOUNT_ of the pages with the most free bytes in a transaction of its own,
+the freed pages are released at the next flush.
+Returns the number of pages still waiting
+*/
+unsigned int plg_CacheCompact(void* pvCacheHandle) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	elog(log_fun, "plg_CacheCompact %U", pCacheHandle);
+	CacheLock(pCacheHandle);
+
+	//The pages of cleared tables are freed first, they may still be in the list
+	unsigned int count = dictSize(pCacheHandle->compact);
+	if (count == 0 || listLength(pCacheHandle->reclaim)) {
+		CacheUnlock(pCacheHandle);
+		return count;
+	}
+
+	PCacheCompactPage pCompactPage = malloc(sizeof(CacheCompactPage) * count);
+	unsigned int l = 0;
+	dictIterator* iter = plg_dictGetSafeIterator(pCacheHandle->compact);
+	dictEntry* node;
+	while ((node = plg_dictNext(iter)) != NULL) {
+		pCompactPage[l].pageAddr = *(unsigned int*)dictGetKey(node);
+		pCompactPage[l].freeSize = ((PCacheCompact)dictGetVal(node))->freeSize;
+		l++;
+	}
+	plg_dictReleaseIterator(iter);
+	plg_SortArrary(pCompactPage, sizeof(CacheCompactPage), count, cache_CompactCmp);
+
+	unsigned int r = 1;
+	for (l = 0; l < count && l < _COMPACTCOUNT_ && r; l++) {
+
+		//A page compacted before may have freed this one
+		dictEntry* entry = plg_dictFind(pCacheHandle->compact, &pCompactPage[l].pageAddr);
+		if (entry == NULL) {
+			continue;
+		}
+
+		sds table = plg_sdsDup(((PCacheCompact)dictGetVal(entry))->table);
+		plg_dictDelete(pCacheHandle->compact, &pCompactPage[l].pageAddr);
+		void* pTableHandle = cahce_GetTableHandle(pCacheHandle, table);
+		if (pTableHandle != 0) {
+			r = plg_TableCompactPage(pTableHandle, pCompactPage[l].pageAddr);
+		}
+		plg_sdsFree(table);
+	}
+	free(pCompactPage);
+	CacheUnlock(pCacheHandle);
+
+	if (r) {
+		plg_CacheCommit(pCacheHandle);
+	} else {
+		plg_CacheRollBack(pCacheHandle);
+	}
+
+	CacheLock(pCacheHandle);
+	r = dictSize(pCacheHandle->compact);
+	CacheUnlock(pCacheHandle);
+	return r;
+}
+
+unsigned int plg_CacheCompactLength(void* pvCacheHandle) {
+
+	PCacheHandle pCacheHandle = pvCacheHandle;
+	CacheLock(pCacheHandle);
+	unsigned int r = dictSize(pCacheHandle->compact);
+	CacheUnlock(pCacheHandle);
+	return r;
+}
+
 /*
 Triggered page update to file
 Trigger a transaction commit and update cache to file
@@ -1520,7 +2480,10 @@ Caching also requires scheduling strategies.
 void plg_CacheFlush(void* pvCacheHandle) {
 
 	PCacheHandle pCacheHandle = pvCacheHandle;
-	MutexLock(pCacheHandle->mutexHandle, pCacheHandle->objectName);	
+	CacheLock(pCacheHandle);	
+	//the table heads, the freed pages and the reclaim records go to the file in one flush
+	plg_DiskLock(pCacheHandle->pDiskHandle);
+
 	//process pCacheHandle->dictTableHandleDirty
 	dictIterator* iter_dictTableHandleDirty = plg_dictGetSafeIterator(pCacheHandle->dictTableHandleDirty);
 	dictEntry* node_dictTableHandleDirty;
@@ -1530,9 +2493,9 @@ void plg_CacheFlush(void* pvCacheHandle) {
 		if (tableHandleEntry != 0) {
 			PTableInFile pTableInFile = plg_TablePTableInFile(plg_ListDictGetVal(tableHandleEntry));
 			if (pTableInFile->tablePageHead == 0) {
-				plg_DiskTableDel(pCacheHandle->pDiskHandle, dictGetKey(node_dictTableHandleDirty));
+				plg_DiskInsideTableDel(pCacheHandle->pDiskHandle, dictGetKey(node_dictTableHandleDirty));
 			} else {
-				plg_DiskTableAdd(pCacheHandle->pDiskHandle, dictGetKey(node_dictTableHandleDirty), pTableInFile, sizeof(TableInFile));
+				plg_DiskInsideTableAdd(pCacheHandle->pDiskHandle, dictGetKey(node_dictTableHandleDirty), pTableInFile, sizeof(TableInFile));
 			}
 		}
 	}
@@ -1546,14 +2509,18 @@ void plg_CacheFlush(void* pvCacheHandle) {
 		plg_ListDictDel(pCacheHandle->listPageCache, dictGetKey(node_delPage));
 		plg_dictDelete(pCacheHandle->pageDirty, dictGetKey(node_delPage));
 
-		plg_DiskFreePage(pCacheHandle->pDiskHandle, *(unsigned int*)dictGetKey(node_delPage));
+		plg_DiskInsideFreePage(pCacheHandle->pDiskHandle, *(unsigned int*)dictGetKey(node_delPage));
 	}
 	plg_dictReleaseIterator(iter_delPage);
 	plg_dictEmpty(pCacheHandle->delPage, NULL);
 
+	cache_ReclaimSave(pCacheHandle);
+	plg_DiskInsideFlush(pCacheHandle->pDiskHandle);
+	plg_DiskUnlock(pCacheHandle->pDiskHandle);
+
 	//process pCacheHandle->pageDirty;
 	cacheFlushDirtyToFile(pCacheHandle);
 
 	cache_Arrange(pCacheHandle);
-	MutexUnlock(pCacheHandle->mutexHandle, pCacheHandle->objectName);
+	CacheUnlock(pCacheHandle);
 }
\ No newline at end of file
@@ -27,46 +27,54 @@ void plg_CacheDestroyHandle(void* pvCacheHandle);
 unsigned short plg_CacheGetTableType(void* pvCacheHandle, sds sdsTable, short recent);
 unsigned short plg_CacheSetTableType(void* pvCacheHandle, sds sdsTable, unsigned short tableType);
 unsigned short plg_CacheSetTableTypeIfByte(void* pvCacheHandle, sds sdsTable, unsigned short tableType);
-unsigned int plg_CacheTableAdd(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* value, unsigned int length);
-unsigned int plg_CacheTableDel(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen);
-int plg_CacheTableFind(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* pDictExten, short recent);
+unsigned int plg_CacheTableAdd(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* value, unsigned int length);
+unsigned int plg_CacheTableDel(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen);
+int plg_CacheTableFind(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* pDictExten, short recent);
 unsigned int plg_CacheTableLength(void* pvCacheHandle, char* sdsTable, short recent);
-unsigned int plg_CacheTableAddIfNoExist(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* value, unsigned int length);
-unsigned int plg_CacheTableIsKeyExist(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, short recent);
-unsigned int plg_CacheTableRename(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* vNewKey, short newKeyLen);
-void plg_CacheTableLimite(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, unsigned int left, unsigned int right, void* pDictExten, short recent);
+unsigned int plg_CacheTableAddIfNoExist(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* value, unsigned int length);
+unsigned int plg_CacheTableIsKeyExist(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, short recent);
+unsigned int plg_CacheTableRename(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* vNewKey, unsigned int newKeyLen);
+void plg_CacheTableLimite(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, unsigned int left, unsigned int right, void* pDictExten, short recent);
 void plg_CacheTableOrder(void* pvCacheHandle, char* sdsTable, short order, unsigned int limite, void* pDictExten, short recent);
-void plg_CacheTableRang(void* pvCacheHandle, char* sdsTable, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pDictExten, short recent);
-void plg_CacheTablePattern(void* pvCacheHandle, char* sdsTable, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pattern, short patternLen, void* pDictExten, short recent);
+void plg_CacheTableRang(void* pvCacheHandle, char* sdsTable, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pDictExten, short recent);
+unsigned int plg_CacheTableRangBatch(void* pvCacheHandle, char* sdsTable, void* beginKey, unsigned int beginKeyLen, short afterBegin, void* endKey, unsigned int endKeyLen, unsigned int limit, void* pDictExten, short recent);
+void plg_CacheTablePattern(void* pvCacheHandle, char* sdsTable, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pattern, short patternLen, void* pDictExten, short recent);
 unsigned int plg_CacheTableMultiAdd(void* pvCacheHandle, char* sdsTable, void* pDictExten);
+unsigned int plg_CacheTableCompareAndSet(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* oldValue, unsigned int oldLength, void* value, unsigned int length);
+unsigned int plg_CacheTableIncrDouble(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, double increment, double* result);
+unsigned int plg_CacheTableAppend(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* value, unsigned int length);
 void plg_CacheTableMultiFind(void* pvCacheHandle, char* sdsTable, void* pKeyDictExten, void* pValueDictExten, short recent);
+void plg_CacheTablePrefetch(void* pvCacheHandle, char* sdsTable, void* pKeyDictExten, short recent);
 unsigned int plg_CacheTableRand(void* pvCacheHandle, char* sdsTable, void* pDictExten, short recent);
 void plg_CacheTableClear(void* pvCacheHandle, char* sdsTable);
-void plg_CacheTablePoint(void* pvCacheHandle, sds sdsTable, void* beginKey, short beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten, short recent);
+void plg_CacheTablePoint(void* pvCacheHandle, sds sdsTable, void* beginKey, unsigned int beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten, short recent);
 void plg_CacheTableMembers(void* pvCacheHandle, sds sdsTable, void* pDictExten, short recent);
 
 //set
-unsigned int plg_CacheTableSetAdd(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* vValue, short valueLen);
-void plg_CacheTableSetRang(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen, void* pDictExten, short recent);
-void plg_CacheTableSetPoint(void* pvCacheHandle, sds sdsTable, void* vKey, short keyLen, void* beginValue, short beginValueLen, unsigned int direction, unsigned int offset, void* pDictExten, short recent);
-void plg_CacheTableSetLimite(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* vValue, short valueLen, unsigned int left, unsigned int right, void* pDictExten, short recent);
-unsigned int plg_CacheTableSetLength(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, short recent);
-unsigned int plg_CacheTableSetIsKeyExist(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* vValue, short valueLen, short recent);
-void plg_CacheTableSetMembers(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* pDictExten, short recent);
-unsigned int plg_CacheTableSetRand(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* pDictExten, short recent);
-void plg_CacheTableSetDel(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* pValueDictExten);
-unsigned int plg_CacheTableSetPop(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* pDictExten, short recent);
-unsigned int plg_CacheTableSetRangCount(void* pvCacheHandle, char* sdsTable, void* vKey, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen, short recent);
+unsigned int plg_CacheTableSetAdd(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen);
+void plg_CacheTableSetRang(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen, void* pDictExten, short recent);
+void plg_CacheTableSetPoint(void* pvCacheHandle, sds sdsTable, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, unsigned int direction, unsigned int offset, void* pDictExten, short recent);
+void plg_CacheTableSetLimite(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen, unsigned int left, unsigned int right, void* pDictExten, short recent);
+unsigned int plg_CacheTableSetLength(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, short recent);
+unsigned int plg_CacheTableSetIsKeyExist(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen, short recent);
+void plg_CacheTableSetMembers(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* pDictExten, short recent);
+unsigned int plg_CacheTableSetRand(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* pDictExten, short recent);
+void plg_CacheTableSetDel(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* pValueDictExten);
+unsigned int plg_CacheTableSetPop(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* pDictExten, short recent);
+unsigned int plg_CacheTableSetRangCount(void* pvCacheHandle, char* sdsTable, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen, short recent);
 unsigned int plg_CacheTableSetUion(void* pvCacheHandle, char* sdsTable, void* pSetDictExten, void* pKeyDictExten, short recent);
-unsigned int plg_CacheTableSetUionStore(void* pvCacheHandle, char* sdsTable, void* pSetDictExten, void* vKey, short keyLen);
+unsigned int plg_CacheTableSetUionStore(void* pvCacheHandle, char* sdsTable, void* pSetDictExten, void* vKey, unsigned int keyLen);
 unsigned int plg_CacheTableSetInter(void* pvCacheHandle, char* sdsTable, void* pSetDictExten, void* pKeyDictExten, short recent);
-unsigned int plg_CacheTableSetInterStore(void* pvCacheHandle, char* sdsTable, void* pSetDictExten, void* vKey, short keyLen);
+unsigned int plg_CacheTableSetInterStore(void* pvCacheHandle, char* sdsTable, void* pSetDictExten, void* vKey, unsigned int keyLen);
 unsigned int plg_CacheTableSetDiff(void* pvCacheHandle, char* sdsTable, void* pSetDictExten, void* pKeyDictExten, short recent);
-unsigned int plg_CacheTableSetDiffStore(void* pvCacheHandle, char* sdsTable, void* pSetDictExten, void* vKey, short keyLen);
-unsigned int plg_CacheTableSetMove(void* pvCacheHandle, sds sdsTable, void* vSrcKey, short  srcKeyLen, void* vDesKey, short desKeyLen, void* vValue, short valueLen);
+unsigned int plg_CacheTableSetDiffStore(void* pvCacheHandle, char* sdsTable, void* pSetDictExten, void* vKey, unsigned int keyLen);
+unsigned int plg_CacheTableSetMove(void* pvCacheHandle, sds sdsTable, void* vSrcKey, unsigned int srcKeyLen, void* vDesKey, unsigned int desKeyLen, void* vValue, unsigned int valueLen);
 
 int plg_CacheCommit(void* pvCacheHandle);
 int plg_CacheRollBack(void* pvCacheHandle);
+int plg_CacheSavepoint(void* pvCacheHandle, unsigned int id);
+int plg_CacheRollbackTo(void* pvCacheHandle, unsigned int id);
+int plg_CacheReleaseSavepoint(void* pvCacheHandle, unsigned int id);
 void plg_CacheFlush(void* pvCacheHandle);
 
 //config
@@ -76,5 +84,13 @@ void plg_CacheSetPercent(void* pvCacheHandle, unsigned int percent);
 unsigned int plg_CacheTableMembersWithJson(void* pvCacheHandle, char* sdsTable, void* jsonRoot, short recent);
 void plg_CachePageCountPrint(void* pvCacheHandle, void* vroot);
 void plg_CacheSetStat(void* pvCacheHandle, short stat);
+void plg_CacheSetPageArena(void* pvCacheHandle, void* pageArena);
+void plg_CacheSetPageHighWater(void* pvCacheHandle, unsigned int pageHighWater);
+void plg_CacheSetShare(void* pvCacheHandle, short isShare);
+unsigned int plg_CacheReclaim(void* pvCacheHandle);
+unsigned int plg_CacheReclaimLength(void* pvCacheHandle);
+unsigned int plg_CacheReclaimResume(void* pvCacheHandle);
+unsigned int plg_CacheCompact(void* pvCacheHandle);
+unsigned int plg_CacheCompactLength(void* pvCacheHandle);
 void plg_CachePageAllCount(void* pvCacheHandle, unsigned long long* cacheCount, unsigned long long* freeCacheCount);
 #endif
\ No newline at end of file
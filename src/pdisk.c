@@ -112,6 +112,7 @@ Diskheadbody: the data part of the file header information
 Pagedisk: page cache, file header, bitpage and tablepage are all resident caches
 Pagedirty: dirty page. The modified and newly created pages in each operation are written back to the file after the operation is completed
 MemPool: memory pool
+ReclaimResume: the reclaim records found in the file were handed to a cache
 */
 typedef struct _DiskHandle
 {
@@ -125,22 +126,35 @@ typedef struct _DiskHandle
 	PDiskHeadBody diskHeadBody;
 	dict* pageDisk;
 	dict* pageDirty;
+	short reclaimResume;
 } *PDiskHandle, DiskHandle;
 
 /*
-Format the new file
+A page size in KB that a file can use.
+Offsets in a page are unsigned short, so a page is at most _PAGESIZEMAX_
 */
-static void* plg_DiskFileFormat(){
+unsigned int plg_DiskCheckPageSize(unsigned short pageSize) {
+
+	if (pageSize < _PAGESIZEMIN_ || pageSize > _PAGESIZEMAX_ || (pageSize & (pageSize - 1)) != 0) {
+		return 0;
+	}
+	return 1;
+}
+
+/*
+Format the new file with pages of pageSize KB
+*/
+static void* plg_DiskFileFormat(unsigned short pageSize){
 
 	elog(log_fun, "plg_DiskFileFormat");
 	//calloc memory
-	unsigned char* pagebuffer = calloc(1, FULLSIZE(_PAGESIZE_) * 2);
+	unsigned char* pagebuffer = calloc(1, FULLSIZE(pageSize) * 2);
 
 	//init PDiskHead
 	PDiskHead pDiskHead = (PDiskHead)pagebuffer;
 	pDiskHead->keyWord = _KEYWORD_;
 	pDiskHead->version = _VERSION_;
-	pDiskHead->pageSize = _PAGESIZE_;
+	pDiskHead->pageSize = pageSize;
 
 	//init PDiskHeadBody
 	PDiskHeadBody pDiskHeadBody = (PDiskHeadBody)(pagebuffer + sizeof(DiskHead));
@@ -151,13 +165,13 @@ static void* plg_DiskFileFormat(){
 	plg_TableInitTableInFile(&pDiskHeadBody->tableInFile);
 
 	//init bitpage
-	PDiskPageHead pDiskPageHead = (PDiskPageHead)(pagebuffer + FULLSIZE(_PAGESIZE_));
+	PDiskPageHead pDiskPageHead = (PDiskPageHead)(pagebuffer + FULLSIZE(pageSize));
 
 	//begin 0
 	pDiskPageHead->addr = _PAGEBITADDR_;
 	pDiskPageHead->type = BITPAGE;
-	PDiskBitPage pDiskBitPage = (PDiskBitPage)(pagebuffer + FULLSIZE(_PAGESIZE_) + sizeof(DiskPageHead));
-	pDiskHeadBody->bitPageSize = FULLSIZE(_PAGESIZE_) - sizeof(DiskPageHead) - sizeof(DiskBitPage) * 8;
+	PDiskBitPage pDiskBitPage = (PDiskBitPage)(pagebuffer + FULLSIZE(pageSize) + sizeof(DiskPageHead));
+	pDiskHeadBody->bitPageSize = FULLSIZE(pageSize) - sizeof(DiskPageHead) - sizeof(DiskBitPage) * 8;
 
 	//begin 0
 	pDiskBitPage->bitLength = _PAGEAMOUNT_;
@@ -165,8 +179,8 @@ static void* plg_DiskFileFormat(){
 	plg_BitArrayAdd(pDiskBitPage->element, 1);
 
 	//Calculate CRC
-	pDiskHead->crc = plg_crc16((char*)pDiskHeadBody, FULLSIZE(_PAGESIZE_) - sizeof(DiskHead));
-	pDiskPageHead->crc = plg_crc16((char*)pDiskBitPage, FULLSIZE(_PAGESIZE_) - sizeof(DiskPageHead));
+	pDiskHead->crc = plg_crc16((char*)pDiskHeadBody, FULLSIZE(pageSize) - sizeof(DiskHead));
+	pDiskPageHead->crc = plg_crc16((char*)pDiskBitPage, FULLSIZE(pageSize) - sizeof(DiskPageHead));
 
 	return pagebuffer;
 }
@@ -757,6 +771,88 @@ void plg_DiskPrintTableName(void* pvDiskHandle) {
 	plg_TableReleaseIterator(iter);
 }
 
+/*
+The page chains of cleared tables waiting to be freed by a cache are kept in the table list,
+The names start with a zero byte followed by the first page of the chain, so they never meet a table name
+*/
+#define DiskIsReclaimKey(keyStr, keyStrSize) ((keyStrSize) == 1 + sizeof(unsigned int) && ((char*)(keyStr))[0] == 0)
+
+static sds disk_ReclaimKey(unsigned int headAddr) {
+
+	char key[1 + sizeof(unsigned int)];
+	key[0] = 0;
+	memcpy(key + 1, &headAddr, sizeof(unsigned int));
+	return plg_sdsNewLen(key, sizeof(key));
+}
+
+/*
+Write the record of a chain, a zero length deletes it.
+Called under plg_DiskLock, the records are written by the next plg_DiskInsideFlush
+*/
+unsigned int plg_DiskInsideReclaimSet(void* pvDiskHandle, unsigned int headAddr, void* value, unsigned int length) {
+
+	PDiskHandle pDiskHandle = pvDiskHandle;
+	sds key = disk_ReclaimKey(headAddr);
+	unsigned int r;
+	if (length) {
+		r = plg_DiskInsideTableAdd(pDiskHandle, key, value, length);
+	} else {
+		r = plg_DiskInsideTableDel(pDiskHandle, key);
+	}
+	plg_sdsFree(key);
+	return r;
+}
+
+/*
+After a restart the first cache that asks takes over the chains left in the file
+*/
+void plg_DiskReclaimResume(void* pvDiskHandle, void* ptr, ReclaimResumeCB funCB) {
+
+	PDiskHandle pDiskHandle = pvDiskHandle;
+	MutexLock(pDiskHandle->mutexHandle, pDiskHandle->objName);
+	if (!pDiskHandle->reclaimResume) {
+		pDiskHandle->reclaimResume = 1;
+
+		void* iter = plg_TableGetIteratorWithKey(pDiskHandle->tableHandle, NULL, 0);
+		PDiskTableKey keyStr;
+		while ((keyStr = plg_TableNextIterator(iter)) != NULL) {
+			if (!DiskIsReclaimKey(keyStr->keyStr, keyStr->keyStrSize) || keyStr->valueType != VALUE_NORMAL) {
+				continue;
+			}
+
+			unsigned int headAddr;
+			memcpy(&headAddr, keyStr->keyStr + 1, sizeof(unsigned int));
+			funCB(ptr, headAddr, (unsigned char*)keyStr + sizeof(DiskTableKey) + keyStr->keyStrSize, keyStr->valueSize);
+		}
+		plg_TableReleaseIterator(iter);
+	}
+	MutexUnlock(pDiskHandle->mutexHandle, pDiskHandle->objName);
+}
+
+/*
+Several changes of the file head, the table list and the page bits are written in one flush
+*/
+void plg_DiskLock(void* pvDiskHandle) {
+
+	PDiskHandle pDiskHandle = pvDiskHandle;
+	MutexLock(pDiskHandle->mutexHandle, pDiskHandle->objName);
+}
+
+void plg_DiskUnlock(void* pvDiskHandle) {
+
+	PDiskHandle pDiskHandle = pvDiskHandle;
+	MutexUnlock(pDiskHandle->mutexHandle, pDiskHandle->objName);
+}
+
+unsigned int plg_DiskInsideFlush(void* pvDiskHandle) {
+
+	PDiskHandle pDiskHandle = pvDiskHandle;
+	if (dictSize(pDiskHandle->pageDirty) == 0) {
+		return 0;
+	}
+	return plg_DiskFlushDirtyToFile(pDiskHandle, plg_FileFlushPage);
+}
+
 void plg_DiskFillTableName(void* pvDiskHandle, void* ptr, FillTableNameCB funCB) {
 
 	PDiskHandle pDiskHandle = pvDiskHandle;
@@ -765,6 +861,10 @@ void plg_DiskFillTableName(void* pvDiskHandle, void* ptr, FillTableNameCB funCB)
 	PDiskTableKey keyStr;
 	while ((keyStr = plg_TableNextIterator(iter)) != NULL) {
 
+		if (DiskIsReclaimKey(keyStr->keyStr, keyStr->keyStrSize)) {
+			continue;
+		}
+
 		sds key = plg_sdsNewLen(keyStr->keyStr, keyStr->keyStrSize);
 		funCB(pDiskHandle, ptr, key);
 	};
@@ -829,6 +929,12 @@ void* plg_DiskfindTableInFile(void* pvDiskHandle, sds table, void* tableInFile)
 	return tableInFile;
 }
 
+static unsigned int plg_DiskPrefetchPage(void* pTableHandle, unsigned int* pageAddr, unsigned int count) {
+	NOTUSED(pTableHandle);
+	NOTUSED(pageAddr);
+	NOTUSED(count);
+	return 0;
+}
 
 static TableHandleCallBack tableHandleCallBack = {
 	plg_DiskFindPage,
@@ -839,7 +945,9 @@ static TableHandleCallBack tableHandleCallBack = {
 	plg_DiskAddDirtyPage,
 	plg_DisktableCopyOnWrite,
 	plg_DiskaddDirtyTable,
-	plg_DiskfindTableInFile
+	plg_DiskfindTableInFile,
+	plg_DiskPrefetchPage,
+	NULL
 };
 
 /*
@@ -853,6 +961,7 @@ static void plg_DiskHandleInit(void* pvDiskHandle, char* filePath, void* pManage
 	pDiskHandle->mutexHandle = plg_MutexCreateHandle(LockLevel_2);
 	pDiskHandle->objName = plg_sdsNew("disk");
 	pDiskHandle->allWeight = 0;
+	pDiskHandle->reclaimResume = 0;
 	pDiskHandle->tableHandle = plg_TableCreateHandle(&pDiskHandle->diskHeadBody->tableInFile, pDiskHandle, pDiskHandle->diskHead->pageSize, NULL, &tableHandleCallBack);
 	pDiskHandle->noSave = noSave;
 	if (pDiskHandle->noSave) {
@@ -878,17 +987,26 @@ It will not be modified or deleted.
 pManage:PManage
 Filepath: open filename
 Pdiskhandle: handle returned
+pageSize: page size in KB of a new file, 0 is _PAGESIZE_. An existing file uses the page size in its DiskHead
 */
 
 SDS_TYPE
-unsigned int plg_DiskFileOpen(void* pManageEqueue, char* filePath, void** pDiskHandle, char isNew, char noSave) {
+unsigned int plg_DiskFileOpen(void* pManageEqueue, char* filePath, void** pDiskHandle, char isNew, char noSave, unsigned short pageSize) {
 
 	PDiskHandle pdiskHandle = 0;
+	if (pageSize == 0) {
+		pageSize = _PAGESIZE_;
+	}
+
+	if (!plg_DiskCheckPageSize(pageSize)) {
+		elog(log_error, "plg_DiskFileOpen.pageSize:%i!", pageSize);
+		return 0;
+	}
 
 	if (noSave) {
 
 		//no file
-		char* ptr = plg_DiskFileFormat();
+		char* ptr = plg_DiskFileFormat(pageSize);
 		PDiskHead pdiskHead = (PDiskHead)ptr;
 		unsigned char* diskpagebuffer = malloc(FULLSIZE(pdiskHead->pageSize));
 		memcpy(diskpagebuffer, ptr, FULLSIZE(pdiskHead->pageSize));
@@ -947,8 +1065,8 @@ unsigned int plg_DiskFileOpen(void* pManageEqueue, char* filePath, void** pDiskH
 	//base infomation write to file
 	if (inputFileLength == 0) {
 		fseek_t(inputFile, 0, SEEK_SET);
-		void* ptr = plg_DiskFileFormat();
-		fwrite(ptr, 1, FULLSIZE(_PAGESIZE_) * 2, inputFile);
+		void* ptr = plg_DiskFileFormat(pageSize);
+		fwrite(ptr, 1, FULLSIZE(pageSize) * 2, inputFile);
 		free(ptr);
 	}
 
@@ -971,6 +1089,12 @@ unsigned int plg_DiskFileOpen(void* pManageEqueue, char* filePath, void** pDiskH
 		return 0;
 	}
 
+	//The file keeps the page size it was created with
+	if (!plg_DiskCheckPageSize(pdiskHead->pageSize)) {
+		elog(log_error, "plg_DiskFileOpen.pageSize:%i!", pdiskHead->pageSize);
+		return 0;
+	}
+
 	//create DiskHandle and join to listDiskHandle
 	pdiskHandle = malloc(sizeof(DiskHandle));
 
@@ -20,7 +20,8 @@
 #define __DISK_H
 
 //API
-unsigned int plg_DiskFileOpen(void* pManage, char* filePath, void** pDiskHandle, char isNew, char noSave);
+unsigned int plg_DiskFileOpen(void* pManage, char* filePath, void** pDiskHandle, char isNew, char noSave, unsigned short pageSize);
+unsigned int plg_DiskCheckPageSize(unsigned short pageSize);
 void plg_DiskFileCloseHandle(void* pDiskHandle);
 unsigned long long plg_DiskGetPageSize(void* pDiskHandle);
 void* plg_DiskFileHandle(void* pDiskHandle);
@@ -34,6 +35,13 @@ int plg_DiskTableFind(void* pDiskHandle, void* tableName, void* pDictExten);
 
 unsigned int plg_DiskAllocPage(void* pDiskHandle, unsigned int* pageAddr);
 unsigned int plg_DiskFreePage(void* pDiskHandle, unsigned int pageAddr);
+void plg_DiskLock(void* pDiskHandle);
+void plg_DiskUnlock(void* pDiskHandle);
+unsigned int plg_DiskInsideFreePage(void* pDiskHandle, unsigned int pageAddr);
+unsigned int plg_DiskInsideFlush(void* pDiskHandle);
+unsigned int plg_DiskInsideReclaimSet(void* pDiskHandle, unsigned int headAddr, void* value, unsigned int length);
+typedef void(*ReclaimResumeCB)(void* ptr, unsigned int headAddr, void* value, unsigned int length);
+void plg_DiskReclaimResume(void* pDiskHandle, void* ptr, ReclaimResumeCB funCB);
 
 void plg_DiskSetIsRun(void* pDiskHandle, int isRun);
 
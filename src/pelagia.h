@@ -40,12 +40,21 @@ PELAGIA_API int plg_MngAddTable(void* pManage, char* nameOrder, short nameOrderL
 PELAGIA_API int plg_MngSetWeight(void* pManage, char* nameTable, short nameTableLen, unsigned int weight);
 PELAGIA_API int plg_MngSetNoShare(void* pManage, char* nameTable, short nameTableLen, unsigned char noShare);
 PELAGIA_API int plg_MngSetNoSave(void* pManage, char* nameTable, short nameTableLen, unsigned char noSave);
+PELAGIA_API int plg_MngSetPageSize(void* pManage, char* nameTable, short nameTableLen, unsigned short pageSize);
 PELAGIA_API void plg_MngSetLuaHot(void* pvManage, short luaHot);
 PELAGIA_API void plg_MngSetLuaLibPath(void* pvManage, char* newLuaLibPath);
 PELAGIA_API void plg_MngSetAllNoSave(void* pvManage, short noSave);
 PELAGIA_API void plg_MngSetStat(void* pvManage, short stat);
 PELAGIA_API void plg_MngSetStatCheckTime(void* pvManage, short checkTime);
 PELAGIA_API void plg_MngSetMaxQueue(void* pvManage, unsigned int maxQueue);
+PELAGIA_API void plg_MngSetGroupCount(void* pvManage, unsigned int groupCount);
+PELAGIA_API void plg_MngSetGroupInterval(void* pvManage, unsigned int groupInterval);
+PELAGIA_API void plg_MngSetPageArena(void* pvManage, unsigned int pageArena);
+PELAGIA_API void plg_MngSetPageHighWater(void* pvManage, unsigned int pageHighWater);
+PELAGIA_API void plg_MngSetLuaGCMode(void* pvManage, short luaGCMode);
+PELAGIA_API void plg_MngSetLuaGCPause(void* pvManage, int luaGCPause);
+PELAGIA_API void plg_MngSetLuaGCStepMul(void* pvManage, int luaGCStepMul);
+PELAGIA_API void plg_MngSetLuaGCIdleStep(void* pvManage, int luaGCIdleStep);
 PELAGIA_API void plg_MngAddLibFun(void* pvManage, char* libPath, char* Fun);
 
 PELAGIA_API int plg_MngAllocJob(void* pManage, unsigned int core);
@@ -89,6 +98,9 @@ PELAGIA_API void plg_JobSetWeight(void* pEventPorcess, unsigned int weight);
 PELAGIA_API void plg_JobSetDonotFlush();
 PELAGIA_API void plg_JobSetDonotCommit();
 PELAGIA_API void plg_JobForceCommit();
+PELAGIA_API unsigned int plg_JobSavepoint();
+PELAGIA_API unsigned int plg_JobRollbackTo(unsigned int savepoint);
+PELAGIA_API void plg_JobReleaseSavepoint(unsigned int savepoint);
 PELAGIA_API int plg_JobRemoteCall(void* order, short orderLen, void* value, short valueLen);
 PELAGIA_API int plg_JobRemoteCallWithOrderID(void* order, short orderLen, void* value, short valueLen, unsigned int orderID);
 PELAGIA_API int plg_JobRemoteCallWithMaxCore(void* order, short orderLen, void* value, short valueLen);
@@ -108,6 +120,13 @@ enum TableType {
 	TT_Set
 };
 
+//collector mode of the lua vm of each job
+enum LuaGCMode {
+	LGC_Default = 0,
+	LGC_Incremental,
+	LGC_Generational
+};
+
 //order id
 PELAGIA_API void* plg_JobGetOrderIDPtr();
 PELAGIA_API void plg_JobSetOrderIDPtr(void* ptr);
@@ -117,42 +136,47 @@ PELAGIA_API unsigned short plg_JobSetTableType(void* table, short tableLen, unsi
 PELAGIA_API unsigned short plg_JobSetTableTypeIfByte(void* table, short tableLen, unsigned short tableType);
 
 //namorl db
-PELAGIA_API unsigned int plg_JobSet(void* table, short tableLen, void* key, short keyLen, void* value, unsigned int valueLen);
+PELAGIA_API unsigned int plg_JobSet(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen);
 PELAGIA_API unsigned int plg_JobMultiSet(void* table, short tableLen, void* pDictExten);
-PELAGIA_API unsigned int plg_JobDel(void* table, short tableLen, void* key, short keyLen);
-PELAGIA_API unsigned int plg_JobSetIfNoExit(void* table, short tableLen, void* key, short keyLen, void* value, unsigned int valueLen);
+PELAGIA_API unsigned int plg_JobDel(void* table, short tableLen, void* key, unsigned int keyLen);
+PELAGIA_API unsigned int plg_JobSetIfNoExit(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen);
+PELAGIA_API unsigned int plg_JobCompareAndSet(void* table, short tableLen, void* key, unsigned int keyLen, void* oldValue, unsigned int oldValueLen, void* value, unsigned int valueLen);
+PELAGIA_API unsigned int plg_JobIncrDouble(void* table, short tableLen, void* key, unsigned int keyLen, double increment, double* result);
+PELAGIA_API unsigned int plg_JobAppend(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen);
 PELAGIA_API void plg_JobTableClear(void* table, short tableLen);
-PELAGIA_API unsigned int plg_JobRename(void* table, short tableLen, void* key, short keyLen, void* newKey, short newKeyLen);
+PELAGIA_API unsigned int plg_JobRename(void* table, short tableLen, void* key, unsigned int keyLen, void* newKey, unsigned int newKeyLen);
 
-PELAGIA_API void* plg_JobGet(void* table, short tableLen, void* key, short keyLen, unsigned int* valueLen);//need free
+PELAGIA_API void* plg_JobGet(void* table, short tableLen, void* key, unsigned int keyLen, unsigned int* valueLen);//need free
 PELAGIA_API unsigned int plg_JobLength(void* table, short tableLen);
-PELAGIA_API unsigned int plg_JobIsKeyExist(void* table, short tableLen, void* key, short keyLen);
-PELAGIA_API void plg_JobLimite(void* table, short tableLen, void* key, short keyLen, unsigned int left, unsigned int right, void* pDictExten);
+PELAGIA_API unsigned int plg_JobIsKeyExist(void* table, short tableLen, void* key, unsigned int keyLen);
+PELAGIA_API void plg_JobLimite(void* table, short tableLen, void* key, unsigned int keyLen, unsigned int left, unsigned int right, void* pDictExten);
 PELAGIA_API void plg_JobOrder(void* table, short tableLen, short order, unsigned int limite, void* pDictExten);
-PELAGIA_API void plg_JobRang(void* table, short tableLen, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pDictExten);
-PELAGIA_API void plg_JobPoint(void* table, short tableLen, void* beginKey, short beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten);
-PELAGIA_API void plg_JobPattern(void* table, short tableLen, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pattern, short patternLen, void* pDictExten);
+PELAGIA_API void plg_JobRang(void* table, short tableLen, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pDictExten);
+PELAGIA_API unsigned int plg_JobRangBatch(void* table, short tableLen, void* beginKey, unsigned int beginKeyLen, short afterBegin, void* endKey, unsigned int endKeyLen, unsigned int limit, void* pDictExten);
+PELAGIA_API void plg_JobPoint(void* table, short tableLen, void* beginKey, unsigned int beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten);
+PELAGIA_API void plg_JobPattern(void* table, short tableLen, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pattern, short patternLen, void* pDictExten);
 PELAGIA_API void plg_JobMultiGet(void* table, short tableLen, void* pKeyDictExten, void* pValueDictExten);
+PELAGIA_API void plg_JobPrefetch(void* table, short tableLen, void* pKeyDictExten);
 PELAGIA_API void* plg_JobRand(void* table, short tableLen, unsigned int* valueLen);//need free
 PELAGIA_API void plg_JobMembers(void* table, short tableLen, void* pDictExten);
 
 //set db
-PELAGIA_API unsigned int plg_JobSAdd(void* table, short tableLen, void* key, short keyLen, void* value, short valueLen);
-PELAGIA_API void plg_JobSMove(void* table, short tableLen, void* srcKey, short srcKeyLen, void* desKey, short desKeyLen, void* value, short valueLen);
-PELAGIA_API void* plg_JobSPop(void* table, short tableLen, void* key, short keyLen, unsigned int* valueLen);
-PELAGIA_API void plg_JobSDel(void* table, short tableLen, void* key, short keyLen, void* pValueDictExten);
-PELAGIA_API void plg_JobSUionStore(void* table, short tableLen, void* pSetDictExten, void* key, short keyLen);
-PELAGIA_API void plg_JobSInterStore(void* table, short tableLen, void* pSetDictExten, void* key, short keyLen);
-PELAGIA_API void plg_JobSDiffStore(void* table, short tableLen, void* pSetDictExten, void* key, short keyLen);
-
-PELAGIA_API void plg_JobSRang(void* table, short tableLen, void* key, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen, void* pDictExten);
-PELAGIA_API void plg_JobSPoint(void* table, short tableLen, void* key, short keyLen, void* beginValue, short beginValueLen, unsigned int direction, unsigned int offset, void* pDictExten);
-PELAGIA_API void plg_JobSLimite(void* table, short tableLen, void* key, short keyLen, void* value, short valueLen, unsigned int left, unsigned int right, void* pDictExten);
-PELAGIA_API unsigned int plg_JobSLength(void* table, short tableLen, void* key, short keyLen);
-PELAGIA_API unsigned int plg_JobSIsKeyExist(void* table, short tableLen, void* key, short keyLen, void* value, short valueLen);
-PELAGIA_API void plg_JobSMembers(void* table, short tableLen, void* key, short keyLen, void* pDictExten);
-PELAGIA_API void* plg_JobSRand(void* table, short tableLen, void* key, short keyLen, unsigned int* valueLen);
-PELAGIA_API unsigned int plg_JobSRangCount(void* table, short tableLen, void* key, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen);
+PELAGIA_API unsigned int plg_JobSAdd(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen);
+PELAGIA_API void plg_JobSMove(void* table, short tableLen, void* srcKey, unsigned int srcKeyLen, void* desKey, unsigned int desKeyLen, void* value, unsigned int valueLen);
+PELAGIA_API void* plg_JobSPop(void* table, short tableLen, void* key, unsigned int keyLen, unsigned int* valueLen);
+PELAGIA_API void plg_JobSDel(void* table, short tableLen, void* key, unsigned int keyLen, void* pValueDictExten);
+PELAGIA_API void plg_JobSUionStore(void* table, short tableLen, void* pSetDictExten, void* key, unsigned int keyLen);
+PELAGIA_API void plg_JobSInterStore(void* table, short tableLen, void* pSetDictExten, void* key, unsigned int keyLen);
+PELAGIA_API void plg_JobSDiffStore(void* table, short tableLen, void* pSetDictExten, void* key, unsigned int keyLen);
+
+PELAGIA_API void plg_JobSRang(void* table, short tableLen, void* key, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen, void* pDictExten);
+PELAGIA_API void plg_JobSPoint(void* table, short tableLen, void* key, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, unsigned int direction, unsigned int offset, void* pDictExten);
+PELAGIA_API void plg_JobSLimite(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen, unsigned int left, unsigned int right, void* pDictExten);
+PELAGIA_API unsigned int plg_JobSLength(void* table, short tableLen, void* key, unsigned int keyLen);
+PELAGIA_API unsigned int plg_JobSIsKeyExist(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen);
+PELAGIA_API void plg_JobSMembers(void* table, short tableLen, void* key, unsigned int keyLen, void* pDictExten);
+PELAGIA_API void* plg_JobSRand(void* table, short tableLen, void* key, unsigned int keyLen, unsigned int* valueLen);
+PELAGIA_API unsigned int plg_JobSRangCount(void* table, short tableLen, void* key, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen);
 PELAGIA_API void plg_JobSUion(void* table, short tableLen, void* pSetDictExten, void* pKeyDictExten);
 PELAGIA_API void plg_JobSInter(void* table, short tableLen, void* pSetDictExten, void* pKeyDictExten);
 PELAGIA_API void plg_JobSDiff(void* table, short tableLen, void* pSetDictExten, void* pKeyDictExten);
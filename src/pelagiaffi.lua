@@ -0,0 +1,79 @@
+-- Fast bindings for LuaJIT through the ffi, same results as pelagia.Set, pelagia.Get and pelagia.RangIter.
+-- On plain Lua the pelagia library is used.
+--   local pffi = require 'pelagiaffi'
+--   pffi.Set("t0", "a", "b")
+--   for k, v in pffi.Rang("t0", "a", "z", 64) do print(k, v) end
+
+local pffi = {}
+
+if jit == nil then
+  pffi.Set = pelagia.Set
+  pffi.Get = pelagia.Get
+  pffi.Rang = pelagia.RangIter
+  return pffi
+end
+
+local ffi = require 'ffi'
+
+ffi.cdef[[
+int plg_LffiSet(const char* t, size_t tLen, const char* k, size_t kLen, const char* v, size_t vLen);
+char* plg_LffiGet(const char* t, size_t tLen, const char* k, size_t kLen, unsigned int* valueLen);
+char* plg_LffiRang(const char* t, size_t tLen, const char* b, size_t bLen, short afterBegin, const char* e, size_t eLen, unsigned int limit, unsigned int* count, unsigned int* finish);
+void plg_LffiFree(void* ptr);
+]]
+
+-- The symbols are in the executable when it is linked with -Wl,-E, otherwise in the pelagia library
+local C = ffi.C
+if not pcall(function() return C.plg_LffiSet end) then
+  C = ffi.load('pelagia')
+end
+
+local len = ffi.new('unsigned int[1]')
+local finish = ffi.new('unsigned int[1]')
+local uintSize = ffi.sizeof('unsigned int')
+
+function pffi.Set(t, k, v)
+  return C.plg_LffiSet(t, #t, k, #k, v, #v)
+end
+
+function pffi.Get(t, k)
+  local p = C.plg_LffiGet(t, #t, k, #k, len)
+  if p == nil then
+    return nil
+  end
+  local v = ffi.string(p, len[0])
+  C.plg_LffiFree(p)
+  return v
+end
+
+-- An iterator over the range read in batches, a row is read from the buffer of its batch when it is reached.
+-- A nil b starts at the head, a nil e runs to the tail and a nil batch reads 64 rows at a time
+function pffi.Rang(t, b, e, batch)
+  e = e or ''
+  batch = batch or 0
+  local buf, cur, left, last, after = nil, nil, 0, false, 0
+  return function()
+    if left == 0 then
+      if last then
+        return nil
+      end
+      buf = ffi.gc(C.plg_LffiRang(t, #t, b, b and #b or 0, after, e, #e, batch, len, finish), C.plg_LffiFree)
+      cur, left, last, after = buf, len[0], finish[0] ~= 0, 1
+      if left == 0 then
+        last = true
+        return nil
+      end
+    end
+    local kLen = ffi.cast('unsigned int*', cur)[0]
+    local k = ffi.string(cur + uintSize, kLen)
+    cur = cur + uintSize + kLen
+    local vLen = ffi.cast('unsigned int*', cur)[0]
+    local v = ffi.string(cur + uintSize, vLen)
+    cur = cur + uintSize + vLen
+    left = left - 1
+    b = k
+    return k, v
+  end
+end
+
+return pffi
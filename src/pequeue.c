@@ -100,6 +100,14 @@ int plg_eqWait(void* pvEventQueue) {
 	return sem_wait(&pEventQueue->semaphore);
 }
 
+/*
+Return -1 without blocking when no event was pushed
+*/
+int plg_eqTryWait(void* pvEventQueue) {
+	PEventQueue pEventQueue = pvEventQueue;
+	return sem_trywait(&pEventQueue->semaphore);
+}
+
 void* plg_eqPop(void* pvEventQueue) {
 	PEventQueue pEventQueue = pvEventQueue;
 	void* value = 0;
@@ -26,6 +26,7 @@ void plg_eqPush(void* pEventQueue, void* value);
 int plg_eqIfNoPush(void* pvEventQueue, void* value, unsigned int maxQueue);
 int plg_eqTimeWait(void* pEventQueue, long long sec, long long nsec);
 int plg_eqWait(void* pEventQueue);
+int plg_eqTryWait(void* pEventQueue);
 void* plg_eqPop(void* pEventQueue);
 void* plg_eqPopWithLen(void* pvEventQueue, unsigned int *len);
 void plg_eqDestory(void* pEventQueue, QueuerDestroyFun fun);
@@ -30,21 +30,55 @@
 #include "pelagia.h"
 #include "pbitarray.h"
 #include "pinterface.h"
+#include "padlist.h"
+#include "pdict.h"
+#include "plistdict.h"
 
 #define FileName(filePath) (strrchr(filePath, '\\') ? (strrchr(filePath, '\\') + 1):filePath)
 
+//Maximum number of pages read ahead and waiting to be taken by the cache
+#define _PREFETCHSTAGE_ 256
+
 typedef struct _FileHandle
 {
 	void* memoryList;
 	sds filePath;
 	FILE* fileHandle;
+	FILE* prefetchHandle;
 	sds fileName;
 	void* pJobHandle;
 	sds objName;
 	void* mutexHandle;
 	unsigned int fullPageSize;
+	void* prefetchPage;
 } *PFileHandle, FileHandle;
 
+static unsigned long long hashCallback(const void *key) {
+	return plg_dictGenHashFunction((unsigned char*)key, sizeof(unsigned int));
+}
+
+static int uintCompareCallback(void *privdata, const void *key1, const void *key2) {
+	NOTUSED(privdata);
+	if (*(unsigned int*)key1 != *(unsigned int*)key2)
+		return 0;
+	else
+		return 1;
+}
+
+static void PrefetchFreeCallback(void *privdata, void *val) {
+	PFileHandle pFileHandle = privdata;
+	plg_MemListPush(pFileHandle->memoryList, listNodeValue((listNode*)val));
+}
+
+static dictType prefetchDictType = {
+	hashCallback,
+	NULL,
+	NULL,
+	uintCompareCallback,
+	NULL,
+	PrefetchFreeCallback
+};
+
 void* plg_FileJobHandle(void* pvFileHandle) {
 	PFileHandle pFileHandle = pvFileHandle;
 	return pFileHandle->pJobHandle;
@@ -72,6 +106,13 @@ unsigned int plg_FileInsideFlushPage(void* pvFileHandle, void* pPFileParamPageIn
 	PFileHandle pFileHandle = pvFileHandle;
 	PFileParamPageInfo pInterPFileParamPageInfo = pPFileParamPageInfo;
 
+	//pages read ahead before this write are out of date
+	MutexLock(pFileHandle->mutexHandle, pFileHandle->objName);
+	for (unsigned int l = 0; l < pageArrarySize; l++) {
+		plg_ListDictDel(pFileHandle->prefetchPage, &pInterPFileParamPageInfo[l].pageId);
+	}
+	MutexUnlock(pFileHandle->mutexHandle, pFileHandle->objName);
+
 	for (unsigned int l = 0; l < pageArrarySize; l++) {
 
 		//check length
@@ -133,6 +174,59 @@ static int OrderFlushPage(char* value, short valueLen) {
 	return 1;
 }
 
+static unsigned int file_ReadPage(PFileHandle pFileHandle, FILE* fileHandle, unsigned int pageSize, unsigned int pageAddr, void* page);
+
+typedef struct OrderPrefetchPageValue
+{
+	PFileHandle pFileHandle;
+	unsigned int pageCount;
+	unsigned int pageAddr[_PREFETCHPAGE_];
+}*POrderPrefetchPageValue, OrderPrefetchPageValue;
+
+/*
+Read the pages into the staging area on the file thread,
+The oldest page is dropped when the staging area is full.
+The read uses the private handle of the file thread outside the lock,
+flushes run on the same thread so a staged page is never older than the file
+*/
+static int OrderPrefetchPage(char* value, short valueLen) {
+	NOTUSED(valueLen);
+	POrderPrefetchPageValue pOrderPrefetchPageValue = (POrderPrefetchPageValue)value;
+	PFileHandle pFileHandle = pOrderPrefetchPageValue->pFileHandle;
+
+	for (unsigned int l = 0; l < pOrderPrefetchPageValue->pageCount; l++) {
+		MutexLock(pFileHandle->mutexHandle, pFileHandle->objName);
+		dictEntry* entry = plg_dictFind(plg_ListDictDict(pFileHandle->prefetchPage), &pOrderPrefetchPageValue->pageAddr[l]);
+		MutexUnlock(pFileHandle->mutexHandle, pFileHandle->objName);
+		if (entry != 0) {
+			continue;
+		}
+
+		void* page = plg_MemListPop(pFileHandle->memoryList);
+		if (file_ReadPage(pFileHandle, pFileHandle->prefetchHandle, pFileHandle->fullPageSize, pOrderPrefetchPageValue->pageAddr[l], page) == 0) {
+			plg_MemListPush(pFileHandle->memoryList, page);
+			continue;
+		}
+
+		PDiskPageHead pDiskPageHead = page;
+		MutexLock(pFileHandle->mutexHandle, pFileHandle->objName);
+		if (plg_dictFind(plg_ListDictDict(pFileHandle->prefetchPage), &pDiskPageHead->addr) == 0) {
+			if (dictSize(plg_ListDictDict(pFileHandle->prefetchPage)) >= _PREFETCHSTAGE_) {
+				PDiskPageHead pOldPageHead = listNodeValue(listLast(plg_ListDictList(pFileHandle->prefetchPage)));
+				plg_ListDictDel(pFileHandle->prefetchPage, &pOldPageHead->addr);
+			}
+			plg_ListDictAdd(pFileHandle->prefetchPage, &pDiskPageHead->addr, page);
+			page = 0;
+		}
+		MutexUnlock(pFileHandle->mutexHandle, pFileHandle->objName);
+
+		if (page) {
+			plg_MemListPush(pFileHandle->memoryList, page);
+		}
+	}
+	return 1;
+}
+
 void* plg_FileCreateHandle(char* fullPath, void* pManageEqueue, unsigned int fullPageSize) {
 	PFileHandle pFileHandle = malloc(sizeof(FileHandle));
 	pFileHandle->filePath = fullPath;
@@ -145,25 +239,38 @@ void* plg_FileCreateHandle(char* fullPath, void* pManageEqueue, unsigned int ful
 	}
 	pFileHandle->fileHandle = outputFile;
 
+	//unbuffered, so it reads what the flush wrote through the other handle
+	pFileHandle->prefetchHandle = fopen_t(pFileHandle->filePath, "rb");
+	if (!pFileHandle->prefetchHandle) {
+		elog(log_warn, "plg_FileCreateHandle.fopen_t.rb!");
+		fclose(outputFile);
+		return 0;
+	}
+	setvbuf(pFileHandle->prefetchHandle, NULL, _IONBF, 0);
+
 	pFileHandle->fileName = plg_sdsNew(FileName(fullPath));
 	pFileHandle->mutexHandle = plg_MutexCreateHandle(LockLevel_3);
 	pFileHandle->pJobHandle = plg_JobCreateHandle(pManageEqueue, TT_FILE, NULL, 0, 1);
 	pFileHandle->objName = plg_sdsNew("file");
 	pFileHandle->fullPageSize = fullPageSize;
 	pFileHandle->memoryList = plg_MemListCreate(60, fullPageSize, 1);
+	pFileHandle->prefetchPage = plg_ListDictCreateHandle(&prefetchDictType, DICT_MIDDLE, LIST_MIDDLE, NULL, pFileHandle);
 	plg_JobSetPrivate(pFileHandle->pJobHandle, pFileHandle);
 	//order process
 	plg_JobAddAdmOrderProcess(pFileHandle->pJobHandle, "destroy", plg_JobCreateFunPtr(OrderDestroy));
 	plg_JobAddAdmOrderProcess(pFileHandle->pJobHandle, "flush", plg_JobCreateFunPtr(OrderFlushPage));
+	plg_JobAddAdmOrderProcess(pFileHandle->pJobHandle, "prefetch", plg_JobCreateFunPtr(OrderPrefetchPage));
 	return pFileHandle;
 }
 
 void plg_FileDestoryHandle(void* pvFileHandle) {
 	PFileHandle pFileHandle = pvFileHandle;
+	plg_ListDictDestroyHandle(pFileHandle->prefetchPage);
 	plg_MemListDestory(pFileHandle->memoryList);
 	plg_JobDestoryHandle(pFileHandle->pJobHandle);
 	plg_sdsFree(pFileHandle->filePath);
 	fclose(pFileHandle->fileHandle);
+	fclose(pFileHandle->prefetchHandle);
 	plg_sdsFree(pFileHandle->fileName);
 	plg_sdsFree(pFileHandle->objName);
 	plg_MutexDestroyHandle(pFileHandle->mutexHandle);
@@ -173,9 +280,8 @@ void plg_FileDestoryHandle(void* pvFileHandle) {
 /*
 loading page from file;
 */
-unsigned int file_InsideLoadPageFromFile(void* pvFileHandle, unsigned int pageSize, unsigned int pageAddr, void* page) {
+static unsigned int file_ReadPage(PFileHandle pFileHandle, FILE* fileHandle, unsigned int pageSize, unsigned int pageAddr, void* page) {
 
-	PFileHandle pFileHandle = pvFileHandle;
 	elog(log_fun, "file_InsideLoadPageFromFile:%s pageAddr:%i", pFileHandle->filePath, pageAddr);
 	//The file header cannot be loaded through this function
 	if (pageAddr == 0) {
@@ -184,8 +290,8 @@ unsigned int file_InsideLoadPageFromFile(void* pvFileHandle, unsigned int pageSi
 	}
 
 	//check file length
-	fseek_t(pFileHandle->fileHandle, 0, SEEK_END);
-	long long inputFileLength = ftell_t(pFileHandle->fileHandle);
+	fseek_t(fileHandle, 0, SEEK_END);
+	long long inputFileLength = ftell_t(fileHandle);
 
 	//file size error
 	if (inputFileLength < pageAddr * pageSize) {
@@ -194,8 +300,8 @@ unsigned int file_InsideLoadPageFromFile(void* pvFileHandle, unsigned int pageSi
 	}
 
 	//file read
-	fseek_t(pFileHandle->fileHandle, pageAddr * pageSize, SEEK_SET);
-	unsigned long long retRead = fread(page, 1, pageSize, pFileHandle->fileHandle);
+	fseek_t(fileHandle, pageAddr * pageSize, SEEK_SET);
+	unsigned long long retRead = fread(page, 1, pageSize, fileHandle);
 	if (retRead != pageSize) {
 		elog(log_error, "file_InsideLoadPageFromFile.fread!");
 		return 0;
@@ -203,15 +309,46 @@ unsigned int file_InsideLoadPageFromFile(void* pvFileHandle, unsigned int pageSi
 	return 1;
 }
 
+unsigned int file_InsideLoadPageFromFile(void* pvFileHandle, unsigned int pageSize, unsigned int pageAddr, void* page) {
+	PFileHandle pFileHandle = pvFileHandle;
+	return file_ReadPage(pFileHandle, pFileHandle->fileHandle, pageSize, pageAddr, page);
+}
+
 unsigned int plg_FileLoadPage(void* pvFileHandle, unsigned int pageSize, unsigned int pageAddr, void* page) {
 
 	PFileHandle pFileHandle = pvFileHandle;
 	MutexLock(pFileHandle->mutexHandle, pFileHandle->objName);
-	unsigned int r = file_InsideLoadPageFromFile(pFileHandle, pageSize, pageAddr, page);
+	unsigned int r;
+	dictEntry* entry = plg_dictFind(plg_ListDictDict(pFileHandle->prefetchPage), &pageAddr);
+	if (entry != 0) {
+		memcpy(page, plg_ListDictGetVal(entry), pageSize);
+		plg_ListDictDel(pFileHandle->prefetchPage, &pageAddr);
+		r = 1;
+	} else {
+		r = file_InsideLoadPageFromFile(pFileHandle, pageSize, pageAddr, page);
+	}
 	MutexUnlock(pFileHandle->mutexHandle, pFileHandle->objName);
 	return r;
 }
 
+/*
+Ask the file thread to read pages ahead of use,
+The cache takes them from the staging area in plg_FileLoadPage
+*/
+unsigned int plg_FilePrefetchPage(void* pvFileHandle, unsigned int* pageAddr, unsigned int pageCount) {
+
+	PFileHandle pFileHandle = pvFileHandle;
+	OrderPrefetchPageValue orderPrefetchPageValue;
+	orderPrefetchPageValue.pFileHandle = pFileHandle;
+
+	for (unsigned int l = 0; l < pageCount; l += _PREFETCHPAGE_) {
+		orderPrefetchPageValue.pageCount = pageCount - l > _PREFETCHPAGE_ ? _PREFETCHPAGE_ : pageCount - l;
+		memcpy(orderPrefetchPageValue.pageAddr, pageAddr + l, orderPrefetchPageValue.pageCount * sizeof(unsigned int));
+		plg_JobSendOrder(plg_JobEqueueHandle(pFileHandle->pJobHandle), "prefetch", (char*)&orderPrefetchPageValue, sizeof(OrderPrefetchPageValue));
+	}
+	return 1;
+}
+
 /*
 Managing memory allocation by yourself and returning memory across threads are also involved.
 The overall efficiency is poor
@@ -303,4 +440,4 @@ void plg_MaskCmp(void* ptrVMask, char* src, char* des, int len) {
 void plg_MaskBit(void* ptrVMask, int num) {
 	PMaskPage ptrMask = ptrVMask;
 	plg_BitArrayAdd(ptrMask->maskBuff, num);
-}
\ No newline at end of file
+}
@@ -19,11 +19,15 @@
 #ifndef __FILE_H
 #define __FILE_H
 
+//Maximum number of pages in one prefetch order
+#define _PREFETCHPAGE_ 16
+
 typedef unsigned int(*FlushCallBack)(void* pFileHandle, void* pPFileParamPageInfo, void** pageArrary, unsigned int pageArrarySize);
 
 unsigned int plg_FileInsideFlushPage(void* pFileHandle, void* pPFileParamPageInfo, void** pageArrary, unsigned int pageArrarySize);
 unsigned int plg_FileFlushPage(void* pFileHandle, void* pPFileParamPageInfo, void** pageArrary, unsigned int pageArrarySize);
 unsigned int plg_FileLoadPage(void* pFileHandle, unsigned int pageSize, unsigned int pageAddr, void* page);
+unsigned int plg_FilePrefetchPage(void* pFileHandle, unsigned int* pageAddr, unsigned int pageCount);
 void* plg_FileCreateHandle(char* fullPath, void* pManageEqueue, unsigned int pageSize);
 void plg_FileDestoryHandle(void* pFileHandle);
 void* plg_FileJobHandle(void* pFileHandle);
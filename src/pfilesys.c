@@ -20,6 +20,10 @@
 #include "plateform.h"
 #include "pfilesys.h"
 #include "pelog.h"
+#ifdef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
 
 static void mkdir_t(const char *_Path) {
 
@@ -46,6 +50,33 @@ short plg_SysSetFileLength(void* vfile, unsigned long long len)
 #endif
 }
 
+/*
+Last modification time of the file in nanoseconds and its size, 0 if it cannot be read.
+Where the system only keeps seconds, two saves in one second differ only by the size
+*/
+unsigned long long plg_SysFileMTime(const char* path, unsigned long long* size)
+{
+#ifdef _WIN32
+	struct _stat64 st;
+	if (_stat64(path, &st) != 0) {
+		return 0;
+	}
+	*size = st.st_size;
+	return (unsigned long long)st.st_mtime * 1000000000;
+#else
+	struct stat st;
+	if (stat(path, &st) != 0) {
+		return 0;
+	}
+	*size = st.st_size;
+#ifdef __APPLE__
+	return (unsigned long long)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+	return (unsigned long long)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+}
+
 void plg_MkDirs(char *muldir)
 {
 	int i, len;
@@ -71,4 +71,5 @@
 
 void plg_MkDirs(char *muldir);
 short plg_SysSetFileLength(void* file, unsigned long long len);
+unsigned long long plg_SysFileMTime(const char* path, unsigned long long* size);
 #endif
\ No newline at end of file
@@ -20,11 +20,14 @@
 #define __INTERFACE_H
 
 #define _PAGESIZE_ 64
+#define _PAGESIZEMIN_ 4
+#define _PAGESIZEMAX_ 64
 #define _PAGEAMOUNT_ 2
 #define FULLSIZE(PS) PS * 1024
 
 #define _ARRANGMENTTIME_ 5
 #define _ARRANGMENTPERCENTAGE_ 5
+#define _COMPACTSPARSE_ 25
 
 //page type
 enum PageType {
@@ -270,6 +273,7 @@ Sdsparent: mark the parent table, and the dependent table will be put into a fil
 Weight: weight
 Issave: save or not
 Isshare: share or not
+pageSize: page size in KB of the file that keeps the table, 0 is _PAGESIZE_
 */
 typedef struct _TableName
 {
@@ -277,6 +281,7 @@ typedef struct _TableName
 	unsigned int weight;
 	unsigned char noSave;
 	unsigned char noShare;
+	unsigned short pageSize;
 }*PTableName, TableName;
 
 /*
@@ -34,6 +34,7 @@
 #include "plibsys.h"
 #include "plvm.h"
 #include "pquicksort.h"
+#include "pmemorylist.h"
 #include "pelagia.h"
 #include "pjson.h"
 #include "pfilesys.h"
@@ -143,6 +144,17 @@ typedef struct __Intervalometer {
 	unsigned int orderID;
 }*PIntervalometer, Intervalometer;
 
+/*
+Savepoint of the job transaction
+id: savepoint id, also used by the cache
+tranLength: the length of tranCache when the savepoint was taken
+*/
+typedef struct _JobSavepoint
+{
+	unsigned int id;
+	unsigned int tranLength;
+}*PJobSavepoint, JobSavepoint;
+
 /*
 Threadtype: the type of the current thread
 Pmanagequeue: event handle for management thread
@@ -163,6 +175,15 @@ Flush_laststamp: time of last submission
 Flush_interval: commit interval
 Flush_Lastcount: number of submissions
 Flush_count: total number of times
+Group commit related flags, orders run back to back in one transaction
+Group_count: the maximum number of orders in one transaction, 0 or 1 commit every order
+Group_interval: the maximum time of one transaction in milliseconds, 0 no limit
+Group_lastCount: number of orders in the current transaction
+Group_lastStamp: time of the first order in the current transaction
+Group_queueLength: the length of the event queue after the current order was taken
+Transavepoint: savepoints of the current transaction
+SavepointID: the id of the last savepoint
+OrderSavepoint: with group commit the savepoint before the current order, scripts cannot release it or roll back over it
 */
 typedef struct _JobHandle
 {
@@ -174,6 +195,9 @@ typedef struct _JobHandle
 	dict* dictCache;
 	dict* order_process;
 	dict* tableName_cacheHandle;
+
+	//types of the tables written by the job, only the job changes them so they are kept until a rollback
+	dict* tableName_tableType;
 	unsigned int allWeight;
 	list* userEvent;
 	list* userProcess;
@@ -183,6 +207,8 @@ typedef struct _JobHandle
 
 	list* tranCache;
 	list* tranFlush;
+	list* reclaimCache;
+	list* compactCache;
 
 	//config
 	unsigned long long flush_lastStamp;
@@ -190,9 +216,30 @@ typedef struct _JobHandle
 	unsigned int flush_lastCount;
 	unsigned int flush_count;
 
+	//group commit
+	unsigned int group_count;
+	unsigned int group_interval;
+	unsigned int group_lastCount;
+	unsigned long long group_lastStamp;
+	unsigned int group_queueLength;
+
+	//arena of the manager for the page frames of the caches created by the job
+	void* pageArena;
+	//free page frames kept by each cache created by the job
+	unsigned int pageHighWater;
+
+	//savepoint
+	list* tranSavepoint;
+	unsigned int savepointID;
+	unsigned int orderSavepoint;
+
 	//vm
 	void* luaHandle;
 
+	//a step of luaGC_idleStep KB of the lua collector runs when the queue is idle, until the cycle ends
+	int luaGC_idleStep;
+	short luaGC_pending;
+
 	//current order name from order_process;
 	char* pOrderName;
 
@@ -370,6 +417,7 @@ void plg_JobSetDonotCommit() {
 	pJobHandle->donotCommit = 1;
 }
 
+
 void job_Flush(void* pvJobHandle) {
 
 	PJobHandle pJobHandle = pvJobHandle;
@@ -382,6 +430,69 @@ void job_Flush(void* pvJobHandle) {
 	plg_listEmpty(pJobHandle->tranFlush);
 }
 
+/*
+One step of freeing the pages of cleared tables, it runs when the job has no order to process.
+The caches are flushed with the orders, or once all their pages are freed
+*/
+static void job_Reclaim(void* pvJobHandle) {
+
+	PJobHandle pJobHandle = pvJobHandle;
+	listIter* iter = plg_listGetIterator(pJobHandle->reclaimCache, AL_START_HEAD);
+	listNode* node;
+	while ((node = plg_listNext(iter)) != NULL) {
+		void* pCacheHandle = listNodeValue(node);
+		if (plg_CacheReclaim(pCacheHandle) == 0) {
+			plg_listDelNode(pJobHandle->reclaimCache, node);
+		}
+
+		if (!plg_listSearchKey(pJobHandle->tranFlush, pCacheHandle)) {
+			plg_listAddNodeHead(pJobHandle->tranFlush, pCacheHandle);
+		}
+	}
+	plg_listReleaseIterator(iter);
+
+	if (listLength(pJobHandle->reclaimCache) == 0) {
+		job_Flush(pJobHandle);
+	}
+}
+
+/*
+One step of compacting the fragmented table pages, it runs when the job has nothing else to do.
+The compacted caches are flushed with the orders, or once all their pages are compacted
+*/
+static void job_Compact(void* pvJobHandle) {
+
+	PJobHandle pJobHandle = pvJobHandle;
+	listIter* iter = plg_listGetIterator(pJobHandle->compactCache, AL_START_HEAD);
+	listNode* node;
+	while ((node = plg_listNext(iter)) != NULL) {
+		void* pCacheHandle = listNodeValue(node);
+		if (plg_CacheCompact(pCacheHandle) == 0) {
+			plg_listDelNode(pJobHandle->compactCache, node);
+		}
+
+		if (!plg_listSearchKey(pJobHandle->tranFlush, pCacheHandle)) {
+			plg_listAddNodeHead(pJobHandle->tranFlush, pCacheHandle);
+		}
+	}
+	plg_listReleaseIterator(iter);
+
+	if (listLength(pJobHandle->compactCache) == 0) {
+		job_Flush(pJobHandle);
+	}
+}
+
+/*
+Each cache appears only once in the transaction, so that the savepoint can find the caches joined after it
+*/
+static void job_AddTranCache(void* pvJobHandle, void* pCacheHandle) {
+
+	PJobHandle pJobHandle = pvJobHandle;
+	if (!plg_listSearchKey(pJobHandle->tranCache, pCacheHandle)) {
+		plg_listAddNodeTail(pJobHandle->tranCache, pCacheHandle);
+	}
+}
+
 void job_Commit(void* pvJobHandle) {
 
 	PJobHandle pJobHandle = pvJobHandle;
@@ -390,10 +501,22 @@ void job_Commit(void* pvJobHandle) {
 	while ((node = plg_listNext(iter)) != NULL) {
 		plg_CacheCommit(listNodeValue(node));
 
-		plg_listAddNodeHead(pJobHandle->tranFlush, listNodeValue(node));
+		if (!plg_listSearchKey(pJobHandle->tranFlush, listNodeValue(node))) {
+			plg_listAddNodeHead(pJobHandle->tranFlush, listNodeValue(node));
+		}
+
+		if (plg_CacheReclaimLength(listNodeValue(node)) && !plg_listSearchKey(pJobHandle->reclaimCache, listNodeValue(node))) {
+			plg_listAddNodeTail(pJobHandle->reclaimCache, listNodeValue(node));
+		}
+
+		if (plg_CacheCompactLength(listNodeValue(node)) && !plg_listSearchKey(pJobHandle->compactCache, listNodeValue(node))) {
+			plg_listAddNodeTail(pJobHandle->compactCache, listNodeValue(node));
+		}
 	}
 	plg_listReleaseIterator(iter);
 	plg_listEmpty(pJobHandle->tranCache);
+	plg_listEmpty(pJobHandle->tranSavepoint);
+	pJobHandle->savepointID = 0;
 }
 
 void job_Rollback(void* pvJobHandle) {
@@ -406,6 +529,135 @@ void job_Rollback(void* pvJobHandle) {
 	}
 	plg_listReleaseIterator(iter);
 	plg_listEmpty(pJobHandle->tranCache);
+	plg_listEmpty(pJobHandle->tranSavepoint);
+	pJobHandle->savepointID = 0;
+	plg_dictEmpty(pJobHandle->tableName_tableType, NULL);
+}
+
+/*
+Start a savepoint in all caches of the current transaction.
+Caches that join the transaction later have no change before the savepoint
+*/
+unsigned int job_Savepoint(void* pvJobHandle) {
+
+	PJobHandle pJobHandle = pvJobHandle;
+	PJobSavepoint pJobSavepoint = malloc(sizeof(JobSavepoint));
+	pJobSavepoint->id = ++pJobHandle->savepointID;
+	pJobSavepoint->tranLength = listLength(pJobHandle->tranCache);
+
+	listIter* iter = plg_listGetIterator(pJobHandle->tranCache, AL_START_HEAD);
+	listNode* node;
+	while ((node = plg_listNext(iter)) != NULL) {
+		plg_CacheSavepoint(listNodeValue(node), pJobSavepoint->id);
+	}
+	plg_listReleaseIterator(iter);
+
+	plg_listAddNodeTail(pJobHandle->tranSavepoint, pJobSavepoint);
+	return pJobSavepoint->id;
+}
+
+/*
+Undo the changes after the savepoint, the savepoint is kept and the later savepoints are removed
+*/
+unsigned int job_RollbackTo(void* pvJobHandle, unsigned int id) {
+
+	PJobHandle pJobHandle = pvJobHandle;
+	PJobSavepoint pJobSavepoint = 0;
+	listIter* iter = plg_listGetIterator(pJobHandle->tranSavepoint, AL_START_HEAD);
+	listNode* node;
+	while ((node = plg_listNext(iter)) != NULL) {
+		if (((PJobSavepoint)listNodeValue(node))->id == id) {
+			pJobSavepoint = listNodeValue(node);
+			break;
+		}
+	}
+	plg_listReleaseIterator(iter);
+
+	if (!pJobSavepoint) {
+		return 0;
+	}
+
+	plg_dictEmpty(pJobHandle->tableName_tableType, NULL);
+
+	//caches joined after the savepoint roll back all
+	while (listLength(pJobHandle->tranCache) > pJobSavepoint->tranLength) {
+		node = listLast(pJobHandle->tranCache);
+		plg_CacheRollBack(listNodeValue(node));
+		plg_listDelNode(pJobHandle->tranCache, node);
+	}
+
+	iter = plg_listGetIterator(pJobHandle->tranCache, AL_START_HEAD);
+	while ((node = plg_listNext(iter)) != NULL) {
+		plg_CacheRollbackTo(listNodeValue(node), id);
+	}
+	plg_listReleaseIterator(iter);
+
+	while ((node = listLast(pJobHandle->tranSavepoint)) != NULL) {
+		if (((PJobSavepoint)listNodeValue(node))->id == id) {
+			break;
+		}
+		plg_listDelNode(pJobHandle->tranSavepoint, node);
+	}
+	return 1;
+}
+
+/*
+Remove the savepoint and the later savepoints, the changes stay in the transaction
+*/
+void job_ReleaseSavepoint(void* pvJobHandle, unsigned int id) {
+
+	PJobHandle pJobHandle = pvJobHandle;
+	listIter* iter = plg_listGetIterator(pJobHandle->tranCache, AL_START_HEAD);
+	listNode* node;
+	while ((node = plg_listNext(iter)) != NULL) {
+		plg_CacheReleaseSavepoint(listNodeValue(node), id);
+	}
+	plg_listReleaseIterator(iter);
+
+	while ((node = listLast(pJobHandle->tranSavepoint)) != NULL) {
+		if (((PJobSavepoint)listNodeValue(node))->id < id) {
+			break;
+		}
+		plg_listDelNode(pJobHandle->tranSavepoint, node);
+	}
+}
+
+/*
+With group commit the failed order only undoes its own changes,
+the orders before it in the group have sent their events and are never undone
+*/
+static void job_OrderRollback(void* pvJobHandle) {
+
+	PJobHandle pJobHandle = pvJobHandle;
+	if (!pJobHandle->orderSavepoint) {
+		job_Rollback(pJobHandle);
+	} else if (!job_RollbackTo(pJobHandle, pJobHandle->orderSavepoint)) {
+		elog(log_error, "in order <%s>.job_OrderRollback. Savepoint <%i> of the order does not exist!", pJobHandle->pOrderName, pJobHandle->orderSavepoint);
+	}
+}
+
+/*
+Check if the orders of the current transaction should be committed.
+Commit when the group is full, the time window is over, the queue is empty or the thread is exiting
+*/
+static short job_GroupCommitReady(void* pvJobHandle) {
+
+	PJobHandle pJobHandle = pvJobHandle;
+	if (pJobHandle->group_count <= 1) {
+		return 1;
+	}
+
+	unsigned long long milli = plg_GetCurrentMilli();
+	if (pJobHandle->group_lastCount++ == 0) {
+		pJobHandle->group_lastStamp = milli;
+	}
+
+	if (pJobHandle->group_lastCount >= pJobHandle->group_count || pJobHandle->group_queueLength == 0 || pJobHandle->exitThread != 0 ||
+		(pJobHandle->group_interval && milli - pJobHandle->group_lastStamp >= pJobHandle->group_interval)) {
+		pJobHandle->group_lastCount = 0;
+		return 1;
+	}
+	return 0;
 }
 
 static int OrderDestroy(char* value, short valueLen) {
@@ -430,6 +682,9 @@ static int OrderJobFinish(char* value, short valueLen) {
 	PJobHandle pJobHandle = job_Handle();
 
 	if (!pJobHandle->donotCommit) {
+		if (!job_GroupCommitReady(pJobHandle)) {
+			return 1;
+		}
 		job_Commit(pJobHandle);		
 	} else {
 		pJobHandle->donotCommit = 0;
@@ -454,6 +709,75 @@ void plg_JobForceCommit() {
 	PJobHandle pJobHandle = job_Handle();
 	job_Commit(pJobHandle);
 	job_Flush(pJobHandle);
+
+	//the rest of the order runs in a new savepoint of its own
+	if (pJobHandle->orderSavepoint) {
+		pJobHandle->orderSavepoint = job_Savepoint(pJobHandle);
+	}
+}
+
+/*
+Start a savepoint in the current transaction.
+The order can go back to it with plg_JobRollbackTo without losing the changes before it.
+Return the id of the savepoint, 0 for failure
+*/
+unsigned int plg_JobSavepoint() {
+
+	CheckUsingThread(0);
+	elog(log_fun, "plg_JobSavepoint");
+	PJobHandle pJobHandle = plg_LocksGetSpecific();
+	if (!pJobHandle) {
+		elog(log_error, "plg_LocksGetSpecific:pJobHandle ");
+		return 0;
+	}
+
+	return job_Savepoint(pJobHandle);
+}
+
+/*
+Undo the changes after the savepoint, the savepoint can be used again
+*/
+unsigned int plg_JobRollbackTo(unsigned int savepoint) {
+
+	CheckUsingThread(0);
+	elog(log_fun, "plg_JobRollbackTo %i", savepoint);
+	PJobHandle pJobHandle = plg_LocksGetSpecific();
+	if (!pJobHandle) {
+		elog(log_error, "plg_LocksGetSpecific:pJobHandle ");
+		return 0;
+	}
+
+	if (savepoint < pJobHandle->orderSavepoint) {
+		elog(log_error, "in order <%s>.plg_JobRollbackTo. Savepoint <%i> belongs to an earlier order of the group!", pJobHandle->pOrderName, savepoint);
+		return 0;
+	}
+
+	if (0 == job_RollbackTo(pJobHandle, savepoint)) {
+		elog(log_error, "in order <%s>.plg_JobRollbackTo. Savepoint <%i> does not exist!", pJobHandle->pOrderName, savepoint);
+		return 0;
+	}
+	return 1;
+}
+
+/*
+Remove the savepoint and the later savepoints, the changes stay in the transaction
+*/
+void plg_JobReleaseSavepoint(unsigned int savepoint) {
+
+	CheckUsingThread(NORET);
+	elog(log_fun, "plg_JobReleaseSavepoint %i", savepoint);
+	PJobHandle pJobHandle = plg_LocksGetSpecific();
+	if (!pJobHandle) {
+		elog(log_error, "plg_LocksGetSpecific:pJobHandle ");
+		return;
+	}
+
+	if (savepoint <= pJobHandle->orderSavepoint) {
+		elog(log_error, "in order <%s>.plg_JobReleaseSavepoint. Savepoint <%i> is kept by the group commit!", pJobHandle->pOrderName, savepoint);
+		return;
+	}
+
+	job_ReleaseSavepoint(pJobHandle, savepoint);
 }
 
 static void InitProcessCommend(void* pvJobHandle) {
@@ -490,6 +814,7 @@ void* plg_JobCreateHandle(void* pManageEqueue, enum ThreadType threadType, char*
 	pJobHandle->order_equeue = plg_dictCreate(plg_DefaultSdsDictPtr(), NULL, DICT_MIDDLE);
 	pJobHandle->order_process = plg_dictCreate(plg_DefaultSdsDictPtr(), NULL, DICT_MIDDLE);
 	pJobHandle->tableName_cacheHandle = plg_dictCreate(plg_DefaultSdsDictPtr(), NULL, DICT_MIDDLE);
+	pJobHandle->tableName_tableType = plg_dictCreate(plg_DefaultSdsDictPtr(), NULL, DICT_MIDDLE);
 	pJobHandle->dictCache = plg_dictCreate(&PtrDictType, NULL, DICT_MIDDLE);
 	pJobHandle->order_runCount = plg_dictCreate(&SdsDictType, NULL, DICT_MIDDLE);
 	pJobHandle->order_msg = plg_dictCreate(&SdsDictType, NULL, DICT_MIDDLE);
@@ -497,6 +822,12 @@ void* plg_JobCreateHandle(void* pManageEqueue, enum ThreadType threadType, char*
 
 	pJobHandle->tranCache = plg_listCreate(LIST_MIDDLE);
 	pJobHandle->tranFlush = plg_listCreate(LIST_MIDDLE);
+	pJobHandle->reclaimCache = plg_listCreate(LIST_MIDDLE);
+	pJobHandle->compactCache = plg_listCreate(LIST_MIDDLE);
+	pJobHandle->orderSavepoint = 0;
+	pJobHandle->tranSavepoint = plg_listCreate(LIST_MIDDLE);
+	listSetFreeMethod(pJobHandle->tranSavepoint, free);
+	pJobHandle->savepointID = 0;
 
 	pJobHandle->userEvent = plg_listCreate(LIST_MIDDLE);
 	listSetFreeMethod(pJobHandle->userEvent, listSdsFree);
@@ -519,6 +850,16 @@ void* plg_JobCreateHandle(void* pManageEqueue, enum ThreadType threadType, char*
 	pJobHandle->flush_lastCount = 0;
 	pJobHandle->maxQueue = 0;
 
+	pJobHandle->group_count = 0;
+	pJobHandle->group_interval = 0;
+	pJobHandle->group_lastCount = 0;
+	pJobHandle->group_lastStamp = 0;
+	pJobHandle->pageArena = 0;
+	pJobHandle->pageHighWater = 0;
+	pJobHandle->group_queueLength = 0;
+	pJobHandle->luaGC_idleStep = 0;
+	pJobHandle->luaGC_pending = 0;
+
 	if (luaLIBPath && plg_sdsLen(luaLIBPath)) {
 		pJobHandle->luaHandle = plg_LvmLoad(luaLIBPath, luaHot);
 	} else {
@@ -562,8 +903,12 @@ void plg_JobDestoryHandle(void* pvJobHandle) {
 	plg_dictRelease(pJobHandle->dictCache);
 	plg_listRelease(pJobHandle->tranCache);
 	plg_listRelease(pJobHandle->tranFlush);
+	plg_listRelease(pJobHandle->reclaimCache);
+	plg_listRelease(pJobHandle->compactCache);
+	plg_listRelease(pJobHandle->tranSavepoint);
 	plg_dictRelease(pJobHandle->order_process);
 	plg_dictRelease(pJobHandle->tableName_cacheHandle);
+	plg_dictRelease(pJobHandle->tableName_tableType);
 	plg_listRelease(pJobHandle->userEvent);
 	plg_listRelease(pJobHandle->userProcess);
 	plg_listRelease(pJobHandle->pListIntervalometer);
@@ -613,7 +958,14 @@ void* plg_JobNewTableCache(void* pvJobHandle, char* table, void* pDiskHandle) {
 	if (valueEntry == 0) {
 		void* pCacheHandle = plg_CacheCreateHandle(pDiskHandle);
 		plg_CacheSetStat(pCacheHandle, pJobHandle->isOpenStat);
+		plg_CacheSetPageArena(pCacheHandle, pJobHandle->pageArena);
+		plg_CacheSetPageHighWater(pCacheHandle, pJobHandle->pageHighWater);
 		plg_dictAdd(pJobHandle->dictCache, table, pCacheHandle);
+
+		//pages of the tables cleared before the restart
+		if (plg_CacheReclaimResume(pCacheHandle)) {
+			plg_listAddNodeTail(pJobHandle->reclaimCache, pCacheHandle);
+		}
 		return pCacheHandle;
 	} else {
 		return dictGetVal(valueEntry);
@@ -811,6 +1163,30 @@ void plg_JobSetMaxQueue(void* pvJobHandle, unsigned int maxQueue){
 	pJobHandle->maxQueue = maxQueue;
 }
 
+void plg_JobSetGroupCommit(void* pvJobHandle, unsigned int groupCount, unsigned int groupInterval) {
+	PJobHandle pJobHandle = pvJobHandle;
+	pJobHandle->group_count = groupCount;
+	pJobHandle->group_interval = groupInterval;
+}
+
+void plg_JobSetPageArena(void* pvJobHandle, void* pageArena) {
+	PJobHandle pJobHandle = pvJobHandle;
+	pJobHandle->pageArena = pageArena;
+}
+
+void plg_JobSetPageHighWater(void* pvJobHandle, unsigned int pageHighWater) {
+	PJobHandle pJobHandle = pvJobHandle;
+	pJobHandle->pageHighWater = pageHighWater;
+}
+
+void plg_JobSetLuaGC(void* pvJobHandle, short mode, int pause, int stepMul, int idleStep) {
+	PJobHandle pJobHandle = pvJobHandle;
+	if (pJobHandle->luaHandle) {
+		plg_LvmSetGC(pJobHandle->luaHandle, mode, pause, stepMul);
+		pJobHandle->luaGC_idleStep = idleStep;
+	}
+}
+
 static void plg_LogStat(void* pvJobHandle, unsigned long long passTime) {
 
 	pJSON* root = pJson_CreateObject();
@@ -876,6 +1252,9 @@ static void plg_LogStat(void* pvJobHandle, unsigned long long passTime) {
 	pJson_AddItemToObject(root, "cache", cacheJson);
 	pJson_AddNumberToObject(cacheJson, "cache", allCacheCount);
 	pJson_AddNumberToObject(cacheJson, "free", allFreeCacheCount);
+	if (pJobHandle->pageArena) {
+		pJson_AddNumberToObject(cacheJson, "arena", plg_MemArenaUsed(pJobHandle->pageArena));
+	}
 
 	if (dictSize(pJobHandle->dictCache)) {
 		iter_cache = plg_dictGetSafeIterator(pJobHandle->dictCache);
@@ -931,7 +1310,33 @@ static void* plg_JobThreadRouting(void* pvJobHandle) {
 	unsigned long long checkTime = plg_GetCurrentMilli();
 
 	do {
-		if (timer == 0) {
+		if (listLength(pJobHandle->reclaimCache) && listLength(pJobHandle->tranCache) == 0) {
+			//pages of cleared tables are left, free them while no order is waiting
+			if (-1 == plg_eqTryWait(pJobHandle->eQueue)) {
+				job_Reclaim(pJobHandle);
+				if (timer != 0 && plg_GetCurrentMilli() >= timer) {
+					timer = plg_JogActIntervalometer(pJobHandle);
+				}
+			}
+		} else if (listLength(pJobHandle->compactCache) && listLength(pJobHandle->tranCache) == 0) {
+			//fragmented table pages are left, compact a few of them while no order is waiting
+			if (-1 == plg_eqTryWait(pJobHandle->eQueue)) {
+				job_Compact(pJobHandle);
+				if (timer != 0 && plg_GetCurrentMilli() >= timer) {
+					timer = plg_JogActIntervalometer(pJobHandle);
+				}
+			}
+		} else if (pJobHandle->luaGC_pending) {
+			//no order is waiting, collect the garbage of the lua orders instead of sleeping
+			if (-1 == plg_eqTryWait(pJobHandle->eQueue)) {
+				if (plg_LvmGCStep(pJobHandle->luaHandle, pJobHandle->luaGC_idleStep)) {
+					pJobHandle->luaGC_pending = 0;
+				}
+				if (timer != 0 && plg_GetCurrentMilli() >= timer) {
+					timer = plg_JogActIntervalometer(pJobHandle);
+				}
+			}
+		} else if (timer == 0) {
 			plg_eqWait(pJobHandle->eQueue);
 		} else {
 
@@ -968,12 +1373,10 @@ static void* plg_JobThreadRouting(void* pvJobHandle) {
 					pEventPorcess = plg_MngGetProcess(pManage, pOrderPacket->order, &pJobHandle->pOrderName);
 				} 
 				
+				//an order without process still goes through the finish, so that a pending group is committed
 				if (!pEventPorcess) {
 					elog(log_error, "not proocess for order %s", pOrderPacket->order);
-					continue;
-				}
-
-				if (pEventPorcess) {
+				} else {
 
 					if (pOrderPacket->orderID) {
 						pJobHandle->curretnOrderID = JobJobOrderID(pOrderPacket->orderID);
@@ -981,10 +1384,15 @@ static void* plg_JobThreadRouting(void* pvJobHandle) {
 						pJobHandle->curretnOrderID = 0;
 					}
 
+					//group commit, the order runs in its own savepoint
+					if (pJobHandle->group_count > 1) {
+						pJobHandle->orderSavepoint = job_Savepoint(pJobHandle);
+					}
+
 					if (pEventPorcess->scriptType == ST_PTR) {
 
 						if (0 == pEventPorcess->functionPoint(pOrderPacket->value, plg_sdsLen(pOrderPacket->value))) {
-							job_Rollback(pJobHandle);
+							job_OrderRollback(pJobHandle);
 						}
 					} else if (pEventPorcess->scriptType == ST_LIB) {
 
@@ -994,7 +1402,7 @@ static void* plg_JobThreadRouting(void* pvJobHandle) {
 							RoutingFun fun = plg_SysLibSym(libHandle, pEventPorcess->function);
 							if (fun) {
 								if (0 == fun(pOrderPacket->value, plg_sdsLen(pOrderPacket->value))) {
-									job_Rollback(pJobHandle);
+									job_OrderRollback(pJobHandle);
 								}
 							} else {
 								elog(log_error, "Lib instruction %s received, but no Lib function found for %s!", (char*)pOrderPacket->order, pEventPorcess->function);
@@ -1006,15 +1414,24 @@ static void* plg_JobThreadRouting(void* pvJobHandle) {
 					} else if (pEventPorcess->scriptType == ST_LUA){
 						if (pJobHandle->luaHandle)  {
 
-							if (0 == plg_LvmCallFile(pJobHandle->luaHandle, pEventPorcess->fileClass, pEventPorcess->function, pOrderPacket->value, plg_sdsLen(pOrderPacket->value))) {
-								job_Rollback(pJobHandle);
+							if (0 == plg_LvmCallFile(pJobHandle->luaHandle, pEventPorcess, pEventPorcess->fileClass, pEventPorcess->function, pOrderPacket->value, plg_sdsLen(pOrderPacket->value))) {
+								job_OrderRollback(pJobHandle);
+							}
+							if (pJobHandle->luaGC_idleStep) {
+								pJobHandle->luaGC_pending = 1;
 							}
 
 						} else {
 							elog(log_error, "Lua instruction %s received, but no Lua virtual machine found!", (char*)pOrderPacket->order);
 						}
 					}
+
+					if (pJobHandle->orderSavepoint) {
+						job_ReleaseSavepoint(pJobHandle, pJobHandle->orderSavepoint);
+						pJobHandle->orderSavepoint = 0;
+					}
 				}
+				pJobHandle->group_queueLength = nowEventQueueLength;
 
 				//finish
 				if (pFinishPorcess && pFinishPorcess->scriptType == ST_PTR) {
@@ -1227,7 +1644,19 @@ unsigned short plg_JobGetTableType(void* table, short tableLen) {
 	sds sdsTable = plg_sdsNewLen(table, tableLen);
 	dictEntry* valueEntry = plg_dictFind(pJobHandle->tableName_cacheHandle, sdsTable);
 	if (valueEntry != 0) {
-		r = plg_CacheGetTableType(dictGetVal(valueEntry), sdsTable, job_IsTableAllowWrite(pJobHandle, sdsTable));
+		//the type seen by the transaction of the job is kept, the last commit of other jobs is not
+		short recent = job_IsTableAllowWrite(pJobHandle, sdsTable);
+		short keep = recent && job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry));
+		dictEntry* typeEntry = keep ? plg_dictFind(pJobHandle->tableName_tableType, sdsTable) : 0;
+		if (typeEntry != 0) {
+			r = (unsigned short)dictGetUnsignedIntegerVal(typeEntry);
+		} else {
+			r = plg_CacheGetTableType(dictGetVal(valueEntry), sdsTable, recent);
+			if (keep) {
+				typeEntry = plg_dictAddRaw(pJobHandle->tableName_tableType, dictGetKey(valueEntry), NULL);
+				dictSetUnsignedIntegerVal(typeEntry, r);
+			}
+		}
 	} else {
 		short orderLen;
 		char* order = plg_JobCurrentOrder(&orderLen);
@@ -1255,8 +1684,9 @@ unsigned short plg_JobSetTableType(void* table, short tableLen, unsigned short t
 	if (valueEntry != 0) {
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			r = plg_CacheSetTableType(dictGetVal(valueEntry), sdsTable, tableType);
+			plg_dictDelete(pJobHandle->tableName_tableType, sdsTable);
 			if (r == tableType) {
-				plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+				job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 			}
 		} else {
 			short orderLen;
@@ -1290,8 +1720,9 @@ unsigned short plg_JobSetTableTypeIfByte(void* table, short tableLen, unsigned s
 	if (valueEntry != 0) {
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			r = plg_CacheSetTableTypeIfByte(dictGetVal(valueEntry), sdsTable, tableType);
+			plg_dictDelete(pJobHandle->tableName_tableType, sdsTable);
 			if (r == tableType) {
-				plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+				job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 			}
 		} else {
 			short orderLen;
@@ -1312,7 +1743,7 @@ unsigned short plg_JobSetTableTypeIfByte(void* table, short tableLen, unsigned s
 /*
 First check the running cache
 */
-unsigned int plg_JobSet(void* table, short tableLen, void* key, short keyLen, void* value, unsigned int valueLen) {
+unsigned int plg_JobSet(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen) {
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobSet %s %s", table, key);
 	
@@ -1330,7 +1761,7 @@ unsigned int plg_JobSet(void* table, short tableLen, void* key, short keyLen, vo
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			r = plg_CacheTableAdd(dictGetVal(valueEntry), sdsTable, key, keyLen, value, valueLen);
 			if (r) {
-				plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+				job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 			}
 		} else {
 			short orderLen;
@@ -1351,7 +1782,7 @@ unsigned int plg_JobSet(void* table, short tableLen, void* key, short keyLen, vo
 /*
 Get set type will fail
 */
-void* plg_JobGet(void* table, short tableLen, void* key, short keyLen, unsigned int* valueLen) {
+void* plg_JobGet(void* table, short tableLen, void* key, unsigned int keyLen, unsigned int* valueLen) {
 
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobGet %s %s", table, key);
@@ -1392,7 +1823,7 @@ void* plg_JobGet(void* table, short tableLen, void* key, short keyLen, unsigned
 	return ptr;
 }
 
-unsigned int plg_JobDel(void* table, short tableLen, void* key, short keyLen) {
+unsigned int plg_JobDel(void* table, short tableLen, void* key, unsigned int keyLen) {
 
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobDel %s %s", table, key);
@@ -1410,7 +1841,7 @@ unsigned int plg_JobDel(void* table, short tableLen, void* key, short keyLen) {
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			r = plg_CacheTableDel(dictGetVal(valueEntry), sdsTable, key, keyLen);
 			if (r) {
-				plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+				job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 			}
 		} else {
 			short orderLen;
@@ -1453,7 +1884,7 @@ unsigned int plg_JobLength(void* table, short tableLen) {
 	return len;
 }
 
-unsigned int plg_JobSetIfNoExit(void* table, short tableLen, void* key, short keyLen, void* value, unsigned int valueLen) {
+unsigned int plg_JobSetIfNoExit(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen) {
 
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobSetIfNoExit %s %s", table, key);
@@ -1472,7 +1903,7 @@ unsigned int plg_JobSetIfNoExit(void* table, short tableLen, void* key, short ke
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			r = plg_CacheTableAddIfNoExist(dictGetVal(valueEntry), sdsTable, key, keyLen, value, valueLen);
 			if (r) {
-				plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+				job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 			}
 		} else {
 			short orderLen;
@@ -1489,7 +1920,122 @@ unsigned int plg_JobSetIfNoExit(void* table, short tableLen, void* key, short ke
 	return r;
 }
 
-unsigned int plg_JobIsKeyExist(void* table, short tableLen, void* key, short keyLen) {
+/*
+Set the key only if it still holds oldValue, compared and written with one search.
+An oldValue of zero length sets the key only if it does not exist
+*/
+unsigned int plg_JobCompareAndSet(void* table, short tableLen, void* key, unsigned int keyLen, void* oldValue, unsigned int oldValueLen, void* value, unsigned int valueLen) {
+
+	CheckUsingThread(0);
+	elog(log_fun, "plg_JobCompareAndSet %s %s", table, key);
+
+	unsigned int r = 0;
+	PJobHandle pJobHandle = plg_LocksGetSpecific();
+	
+	if (!pJobHandle) {
+		elog(log_error, "plg_LocksGetSpecific:pJobHandle ");
+		return 0;
+	}
+
+	sds sdsTable = plg_sdsNewLen(table, tableLen);
+	dictEntry* valueEntry = plg_dictFind(pJobHandle->tableName_cacheHandle, sdsTable);
+	if (valueEntry != 0) {
+		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
+			r = plg_CacheTableCompareAndSet(dictGetVal(valueEntry), sdsTable, key, keyLen, oldValue, oldValueLen, value, valueLen);
+			if (r) {
+				job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
+			}
+		} else {
+			short orderLen;
+			char* order = plg_JobCurrentOrder(&orderLen);
+			elog(log_error, "plg_JobCompareAndSet.No permission in <%s> to table <%s>!", order, sdsTable);
+		}
+	} else {
+		short orderLen;
+		char* order = plg_JobCurrentOrder(&orderLen);
+		elog(log_error, "in order <%s>.plg_JobCompareAndSet. Cannot access table <%s>!", order, sdsTable);
+	}
+	plg_sdsFree(sdsTable);
+
+	return r;
+}
+
+/*
+For TT_Double tables, the new value is returned in result
+*/
+unsigned int plg_JobIncrDouble(void* table, short tableLen, void* key, unsigned int keyLen, double increment, double* result) {
+
+	CheckUsingThread(0);
+	elog(log_fun, "plg_JobIncrDouble %s %s", table, key);
+
+	unsigned int r = 0;
+	PJobHandle pJobHandle = plg_LocksGetSpecific();
+	
+	if (!pJobHandle) {
+		elog(log_error, "plg_LocksGetSpecific:pJobHandle ");
+		return 0;
+	}
+
+	sds sdsTable = plg_sdsNewLen(table, tableLen);
+	dictEntry* valueEntry = plg_dictFind(pJobHandle->tableName_cacheHandle, sdsTable);
+	if (valueEntry != 0) {
+		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
+			r = plg_CacheTableIncrDouble(dictGetVal(valueEntry), sdsTable, key, keyLen, increment, result);
+			if (r) {
+				job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
+			}
+		} else {
+			short orderLen;
+			char* order = plg_JobCurrentOrder(&orderLen);
+			elog(log_error, "plg_JobIncrDouble.No permission in <%s> to table <%s>!", order, sdsTable);
+		}
+	} else {
+		short orderLen;
+		char* order = plg_JobCurrentOrder(&orderLen);
+		elog(log_error, "in order <%s>.plg_JobIncrDouble. Cannot access table <%s>!", order, sdsTable);
+	}
+	plg_sdsFree(sdsTable);
+
+	return r;
+}
+
+unsigned int plg_JobAppend(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen) {
+
+	CheckUsingThread(0);
+	elog(log_fun, "plg_JobAppend %s %s", table, key);
+
+	unsigned int r = 0;
+	PJobHandle pJobHandle = plg_LocksGetSpecific();
+	
+	if (!pJobHandle) {
+		elog(log_error, "plg_LocksGetSpecific:pJobHandle ");
+		return 0;
+	}
+
+	sds sdsTable = plg_sdsNewLen(table, tableLen);
+	dictEntry* valueEntry = plg_dictFind(pJobHandle->tableName_cacheHandle, sdsTable);
+	if (valueEntry != 0) {
+		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
+			r = plg_CacheTableAppend(dictGetVal(valueEntry), sdsTable, key, keyLen, value, valueLen);
+			if (r) {
+				job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
+			}
+		} else {
+			short orderLen;
+			char* order = plg_JobCurrentOrder(&orderLen);
+			elog(log_error, "plg_JobAppend.No permission in <%s> to table <%s>!", order, sdsTable);
+		}
+	} else {
+		short orderLen;
+		char* order = plg_JobCurrentOrder(&orderLen);
+		elog(log_error, "in order <%s>.plg_JobAppend. Cannot access table <%s>!", order, sdsTable);
+	}
+	plg_sdsFree(sdsTable);
+
+	return r;
+}
+
+unsigned int plg_JobIsKeyExist(void* table, short tableLen, void* key, unsigned int keyLen) {
 
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobIsKeyExist %s %s", table, key);
@@ -1516,7 +2062,7 @@ unsigned int plg_JobIsKeyExist(void* table, short tableLen, void* key, short key
 	return r;
 }
 
-unsigned int plg_JobRename(void* table, short tableLen, void* key, short keyLen, void* newKey, short newKeyLen) {
+unsigned int plg_JobRename(void* table, short tableLen, void* key, unsigned int keyLen, void* newKey, unsigned int newKeyLen) {
 
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobRename %s %s %s", table, key, newKey);
@@ -1534,7 +2080,7 @@ unsigned int plg_JobRename(void* table, short tableLen, void* key, short keyLen,
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			r = plg_CacheTableRename(dictGetVal(valueEntry), sdsTable, key, keyLen, newKey, newKeyLen);
 			if (r) {
-				plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+				job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 			}
 		} else {
 			short orderLen;
@@ -1550,7 +2096,7 @@ unsigned int plg_JobRename(void* table, short tableLen, void* key, short keyLen,
 	return r;
 }
 
-void plg_JobLimite(void* table, short tableLen, void* key, short keyLen, unsigned int left, unsigned int right, void* pDictExten) {
+void plg_JobLimite(void* table, short tableLen, void* key, unsigned int keyLen, unsigned int left, unsigned int right, void* pDictExten) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobLimite %s %s", table, key);
@@ -1598,7 +2144,7 @@ void plg_JobOrder(void* table, short tableLen, short order, unsigned int limite,
 	plg_sdsFree(sdsTable);
 }
 
-void plg_JobRang(void* table, short tableLen, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pDictExten) {
+void plg_JobRang(void* table, short tableLen, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pDictExten) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobRang %s %s %s", table, beginKey, endKey);
@@ -1622,7 +2168,36 @@ void plg_JobRang(void* table, short tableLen, void* beginKey, short beginKeyLen,
 
 }
 
-void plg_JobPoint(void* table, short tableLen, void* beginKey, short beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten) {
+/*
+Read the range in batches of limit keys, the next batch begins with the last key of the previous one and afterBegin.
+Return 1 when the range is finished
+*/
+unsigned int plg_JobRangBatch(void* table, short tableLen, void* beginKey, unsigned int beginKeyLen, short afterBegin, void* endKey, unsigned int endKeyLen, unsigned int limit, void* pDictExten) {
+
+	CheckUsingThread(1);
+	elog(log_fun, "plg_JobRangBatch %s %s %s", table, beginKey, endKey);
+	PJobHandle pJobHandle = plg_LocksGetSpecific();
+	
+	if (!pJobHandle) {
+		elog(log_error, "plg_LocksGetSpecific:pJobHandle ");
+		return 1;
+	}
+
+	unsigned int r = 1;
+	sds sdsTable = plg_sdsNewLen(table, tableLen);
+	dictEntry* valueEntry = plg_dictFind(pJobHandle->tableName_cacheHandle, sdsTable);
+	if (valueEntry != 0) {
+		r = plg_CacheTableRangBatch(dictGetVal(valueEntry), sdsTable, beginKey, beginKeyLen, afterBegin, endKey, endKeyLen, limit, pDictExten, job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)));
+	} else {
+		short orderLen;
+		char* order = plg_JobCurrentOrder(&orderLen);
+		elog(log_error, "in order <%s>.plg_JobRangBatch. Cannot access table <%s>!", order, sdsTable);
+	}
+	plg_sdsFree(sdsTable);
+	return r;
+}
+
+void plg_JobPoint(void* table, short tableLen, void* beginKey, unsigned int beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobPoint %s %s", table, beginKey);
@@ -1646,7 +2221,7 @@ void plg_JobPoint(void* table, short tableLen, void* beginKey, short beginKeyLen
 
 }
 
-void plg_JobPattern(void* table, short tableLen, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pattern, short patternLen, void* pDictExten) {
+void plg_JobPattern(void* table, short tableLen, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pattern, short patternLen, void* pDictExten) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobPattern %s %s %s", table, beginKey, endKey);
@@ -1713,7 +2288,7 @@ unsigned int plg_JobMultiSet(void* table, short tableLen, void* pDictExten) {
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			r = plg_CacheTableMultiAdd(dictGetVal(valueEntry), sdsTable, pDictExten);
 			if (r) {
-				plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+				job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 			}
 		} else {
 			short orderLen;
@@ -1754,6 +2329,34 @@ void plg_JobMultiGet(void* table, short tableLen, void* pKeyDictExten, void* pVa
 	plg_sdsFree(sdsTable);
 }
 
+/*
+A hint that the keys will be used soon, the pages on their path are read ahead by the file thread
+*/
+void plg_JobPrefetch(void* table, short tableLen, void* pKeyDictExten) {
+
+	CheckUsingThread(NORET);
+	elog(log_fun, "plg_JobPrefetch %s", table);
+
+	PJobHandle pJobHandle = plg_LocksGetSpecific();
+	
+	if (!pJobHandle) {
+		elog(log_error, "plg_LocksGetSpecific:pJobHandle ");
+		return;
+	}
+
+	sds sdsTable = plg_sdsNewLen(table, tableLen);
+
+	dictEntry* valueEntry = plg_dictFind(pJobHandle->tableName_cacheHandle, sdsTable);
+	if (valueEntry != 0) {
+		plg_CacheTablePrefetch(dictGetVal(valueEntry), sdsTable, pKeyDictExten, job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)));
+	} else {
+		short orderLen;
+		char* order = plg_JobCurrentOrder(&orderLen);
+		elog(log_error, "in order <%s>.plg_JobPrefetch. Cannot access table <%s>!", order, sdsTable);
+	}
+	plg_sdsFree(sdsTable);
+}
+
 void* plg_JobRand(void* table, short tableLen, unsigned int* valueLen) {
 
 	CheckUsingThread(0);
@@ -1814,7 +2417,9 @@ void plg_JobTableClear(void* table, short tableLen) {
 	if (valueEntry != 0) {
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			plg_CacheTableClear(dictGetVal(valueEntry), sdsTable);
-			plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+			//the clear sets the table back to TT_Byte
+			plg_dictDelete(pJobHandle->tableName_tableType, sdsTable);
+			job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 		} else {
 			short orderLen;
 			char* order = plg_JobCurrentOrder(&orderLen);
@@ -1828,7 +2433,7 @@ void plg_JobTableClear(void* table, short tableLen) {
 	plg_sdsFree(sdsTable);
 }
 
-unsigned int plg_JobSAdd(void* table, short tableLen, void* key, short keyLen, void* value, short valueLen) {
+unsigned int plg_JobSAdd(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen) {
 
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobSAdd %s %s", table, key);
@@ -1846,7 +2451,7 @@ unsigned int plg_JobSAdd(void* table, short tableLen, void* key, short keyLen, v
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			r = plg_CacheTableSetAdd(dictGetVal(valueEntry), sdsTable, key, keyLen, value, valueLen);
 			if (r) {
-				plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+				job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 			}
 		} else {
 			short orderLen;
@@ -1863,7 +2468,7 @@ unsigned int plg_JobSAdd(void* table, short tableLen, void* key, short keyLen, v
 	return r;
 }
 
-void plg_JobSRang(void* table, short tableLen, void* key, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen, void* pDictExten) {
+void plg_JobSRang(void* table, short tableLen, void* key, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen, void* pDictExten) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobSRang %s %s", table, key);
@@ -1887,7 +2492,7 @@ void plg_JobSRang(void* table, short tableLen, void* key, short keyLen, void* be
 	plg_sdsFree(sdsTable);
 }
 
-void plg_JobSPoint(void* table, short tableLen, void* key, short keyLen, void* beginValue, short beginValueLen, unsigned int direction, unsigned int offset, void* pDictExten) {
+void plg_JobSPoint(void* table, short tableLen, void* key, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, unsigned int direction, unsigned int offset, void* pDictExten) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobSPoint %s %s", table, key);
@@ -1911,7 +2516,7 @@ void plg_JobSPoint(void* table, short tableLen, void* key, short keyLen, void* b
 	plg_sdsFree(sdsTable);
 }
 
-void plg_JobSLimite(void* table, short tableLen, void* key, short keyLen, void* value, short valueLen, unsigned int left, unsigned int right, void* pDictExten) {
+void plg_JobSLimite(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen, unsigned int left, unsigned int right, void* pDictExten) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobSLimite %s %s", table, key);
@@ -1935,7 +2540,7 @@ void plg_JobSLimite(void* table, short tableLen, void* key, short keyLen, void*
 	plg_sdsFree(sdsTable);
 }
 
-unsigned int plg_JobSLength(void* table, short tableLen, void* key, short keyLen) {
+unsigned int plg_JobSLength(void* table, short tableLen, void* key, unsigned int keyLen) {
 
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobSLength %s %s", table, key);
@@ -1961,7 +2566,7 @@ unsigned int plg_JobSLength(void* table, short tableLen, void* key, short keyLen
 	return len;
 }
 
-unsigned int plg_JobSIsKeyExist(void* table, short tableLen, void* key, short keyLen, void* value, short valueLen) {
+unsigned int plg_JobSIsKeyExist(void* table, short tableLen, void* key, unsigned int keyLen, void* value, unsigned int valueLen) {
 
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobSIsKeyExist %s %s", table, key);
@@ -1988,7 +2593,7 @@ unsigned int plg_JobSIsKeyExist(void* table, short tableLen, void* key, short ke
 	return r;
 }
 
-void plg_JobSMembers(void* table, short tableLen, void* key, short keyLen, void* pDictExten) {
+void plg_JobSMembers(void* table, short tableLen, void* key, unsigned int keyLen, void* pDictExten) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobSMembers %s %s", table, key);
@@ -2013,7 +2618,7 @@ void plg_JobSMembers(void* table, short tableLen, void* key, short keyLen, void*
 	plg_sdsFree(sdsTable);
 }
 
-void* plg_JobSRand(void* table, short tableLen, void* key, short keyLen, unsigned int* valueLen) {
+void* plg_JobSRand(void* table, short tableLen, void* key, unsigned int keyLen, unsigned int* valueLen) {
 
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobSRand %s %s", table, key);
@@ -2055,7 +2660,7 @@ void* plg_JobSRand(void* table, short tableLen, void* key, short keyLen, unsigne
 	return ptr;
 }
 
-void plg_JobSDel(void* table, short tableLen, void* key, short keyLen, void* pValueDictExten) {
+void plg_JobSDel(void* table, short tableLen, void* key, unsigned int keyLen, void* pValueDictExten) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobSDel %s %s", table, key);
@@ -2071,7 +2676,7 @@ void plg_JobSDel(void* table, short tableLen, void* key, short keyLen, void* pVa
 	if (valueEntry != 0) {
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			plg_CacheTableSetDel(dictGetVal(valueEntry), sdsTable, key, keyLen, pValueDictExten);
-			plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+			job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 		} else {
 			short orderLen;
 			char* order = plg_JobCurrentOrder(&orderLen);
@@ -2085,7 +2690,7 @@ void plg_JobSDel(void* table, short tableLen, void* key, short keyLen, void* pVa
 	plg_sdsFree(sdsTable);
 }
 
-void* plg_JobSPop(void* table, short tableLen, void* key, short keyLen, unsigned int* valueLen) {
+void* plg_JobSPop(void* table, short tableLen, void* key, unsigned int keyLen, unsigned int* valueLen) {
 
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobSPop %s %s", table, key);
@@ -2128,7 +2733,7 @@ void* plg_JobSPop(void* table, short tableLen, void* key, short keyLen, unsigned
 
 }
 
-unsigned int plg_JobSRangCount(void* table, short tableLen, void* key, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen) {
+unsigned int plg_JobSRangCount(void* table, short tableLen, void* key, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen) {
 
 	CheckUsingThread(0);
 	elog(log_fun, "plg_JobSRangCount %s %s", table, key);
@@ -2179,7 +2784,7 @@ void plg_JobSUion(void* table, short tableLen, void* pSetDictExten, void* pKeyDi
 	plg_sdsFree(sdsTable);
 }
 
-void plg_JobSUionStore(void* table, short tableLen, void* pSetDictExten, void* key, short keyLen) {
+void plg_JobSUionStore(void* table, short tableLen, void* pSetDictExten, void* key, unsigned int keyLen) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobSUionStore %s %s", table, key);
@@ -2195,7 +2800,7 @@ void plg_JobSUionStore(void* table, short tableLen, void* pSetDictExten, void* k
 	if (valueEntry != 0) {
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			plg_CacheTableSetUionStore(dictGetVal(valueEntry), sdsTable, pSetDictExten, key, keyLen);
-			plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+			job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 		} else {
 			short orderLen;
 			char* order = plg_JobCurrentOrder(&orderLen);
@@ -2233,7 +2838,7 @@ void plg_JobSInter(void* table, short tableLen, void* pSetDictExten, void* pKeyD
 	plg_sdsFree(sdsTable);
 }
 
-void plg_JobSInterStore(void* table, short tableLen, void* pSetDictExten, void* key, short keyLen) {
+void plg_JobSInterStore(void* table, short tableLen, void* pSetDictExten, void* key, unsigned int keyLen) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobSInterStore %s %s", table, key);
@@ -2250,7 +2855,7 @@ void plg_JobSInterStore(void* table, short tableLen, void* pSetDictExten, void*
 	if (valueEntry != 0) {
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			plg_CacheTableSetInterStore(dictGetVal(valueEntry), sdsTable, pSetDictExten, key, keyLen);
-			plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+			job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 		} else {
 			short orderLen;
 			char* order = plg_JobCurrentOrder(&orderLen);
@@ -2288,7 +2893,7 @@ void plg_JobSDiff(void* table, short tableLen, void* pSetDictExten, void* pKeyDi
 	plg_sdsFree(sdsTable);
 }
 
-void plg_JobSDiffStore(void* table, short tableLen, void* pSetDictExten, void* key, short keyLen) {
+void plg_JobSDiffStore(void* table, short tableLen, void* pSetDictExten, void* key, unsigned int keyLen) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobSDiff %s %s", table, key);
@@ -2305,7 +2910,7 @@ void plg_JobSDiffStore(void* table, short tableLen, void* pSetDictExten, void* k
 	if (valueEntry != 0) {
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			plg_CacheTableSetDiffStore(dictGetVal(valueEntry), sdsTable, pSetDictExten, key, keyLen);
-			plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+			job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 		} else {
 			short orderLen;
 			char* order = plg_JobCurrentOrder(&orderLen);
@@ -2319,7 +2924,7 @@ void plg_JobSDiffStore(void* table, short tableLen, void* pSetDictExten, void* k
 	plg_sdsFree(sdsTable);
 }
 
-void plg_JobSMove(void* table, short tableLen, void* srcKey, short srcKeyLen, void* desKey, short desKeyLen, void* value, short valueLen) {
+void plg_JobSMove(void* table, short tableLen, void* srcKey, unsigned int srcKeyLen, void* desKey, unsigned int desKeyLen, void* value, unsigned int valueLen) {
 
 	CheckUsingThread(NORET);
 	elog(log_fun, "plg_JobSMove %s %s %s", table, srcKey, desKey);
@@ -2336,7 +2941,7 @@ void plg_JobSMove(void* table, short tableLen, void* srcKey, short srcKeyLen, vo
 	if (valueEntry != 0) {
 		if (job_IsCacheAllowWrite(pJobHandle, dictGetKey(valueEntry)) && job_IsTableAllowWrite(pJobHandle, sdsTable)) {
 			plg_CacheTableSetMove(dictGetVal(valueEntry), sdsTable, srcKey, srcKeyLen, desKey, desKeyLen, value, valueLen);
-			plg_listAddNodeHead(pJobHandle->tranCache, dictGetVal(valueEntry));
+			job_AddTranCache(pJobHandle, dictGetVal(valueEntry));
 		} else {
 			short orderLen;
 			char* order = plg_JobCurrentOrder(&orderLen);
@@ -66,5 +66,9 @@ void plg_JobTableMembersWithJson(void* table, short tableLen, void* jsonRoot);
 int plg_JobStartRouting(void* pvJobHandle);
 void plg_JobSetStat(void* pvJobHandle, short stat, unsigned long long checkTime);
 void plg_JobSetMaxQueue(void* pvJobHandle, unsigned int maxQueue);
+void plg_JobSetGroupCommit(void* pvJobHandle, unsigned int groupCount, unsigned int groupInterval);
+void plg_JobSetPageArena(void* pvJobHandle, void* pageArena);
+void plg_JobSetPageHighWater(void* pvJobHandle, unsigned int pageHighWater);
+void plg_JobSetLuaGC(void* pvJobHandle, short mode, int pause, int stepMul, int idleStep);
 
 #endif
\ No newline at end of file
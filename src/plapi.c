@@ -157,6 +157,26 @@ static int LCommit(lua_State* L) {
 	return 0;
 }
 
+static int LSavepoint(lua_State* L) {
+
+	plg_Lvmpushnumber(_plVMHandle, L, (lua_Number)plg_JobSavepoint());
+	return 1;
+}
+
+static int LRollbackTo(lua_State* L) {
+
+	unsigned int savepoint = plg_Lvmcheckinteger(_plVMHandle, L, 1);
+	plg_Lvmpushnumber(_plVMHandle, L, (lua_Number)plg_JobRollbackTo(savepoint));
+	return 1;
+}
+
+static int LReleaseSavepoint(lua_State* L) {
+
+	unsigned int savepoint = plg_Lvmcheckinteger(_plVMHandle, L, 1);
+	plg_JobReleaseSavepoint(savepoint);
+	return 0;
+}
+
 static int LSet(lua_State* L) {
 
 	size_t tLen, kLen, vLen;
@@ -229,6 +249,63 @@ static int LSetIfNoExit(lua_State* L) {
 	return 1;
 }
 
+static int LCompareAndSet(lua_State* L) {
+
+	size_t tLen, kLen, oLen, vLen;
+	const char* t = plg_Lvmchecklstring(_plVMHandle, L, 1, &tLen);
+	const char* k = plg_Lvmchecklstring(_plVMHandle, L, 2, &kLen);
+	const char* o = plg_Lvmchecklstring(_plVMHandle, L, 3, &oLen);
+	const char* v = plg_Lvmchecklstring(_plVMHandle, L, 4, &vLen);
+
+	unsigned rtype = 0;
+	rtype = plg_JobSetTableTypeIfByte((void*)t, tLen, TT_String);
+	if (rtype != TT_String) {
+		elog(log_warn, "LCompareAndSet Current table '%s' type is '%s' to TT_String", t, plg_TT2String(rtype));
+	}
+
+	plg_Lvmpushnumber(_plVMHandle, L, (lua_Number)plg_JobCompareAndSet((void*)t, tLen, (void*)k, kLen, (void*)o, oLen, (void*)v, vLen));
+	return 1;
+}
+
+static int LIncrDouble(lua_State* L) {
+
+	size_t tLen, kLen;
+	const char* t = plg_Lvmchecklstring(_plVMHandle, L, 1, &tLen);
+	const char* k = plg_Lvmchecklstring(_plVMHandle, L, 2, &kLen);
+	double increment = plg_Lvmchecknumber(_plVMHandle, L, 3);
+
+	unsigned rtype = 0;
+	rtype = plg_JobSetTableTypeIfByte((void*)t, tLen, TT_Double);
+	if (rtype != TT_Double) {
+		elog(log_warn, "LIncrDouble Current table '%s' type is '%s' to TT_Double", t, plg_TT2String(rtype));
+	}
+
+	double result;
+	if (plg_JobIncrDouble((void*)t, tLen, (void*)k, kLen, increment, &result)) {
+		plg_Lvmpushnumber(_plVMHandle, L, result);
+	} else {
+		plg_Lvmpushnil(_plVMHandle, L);
+	}
+	return 1;
+}
+
+static int LAppend(lua_State* L) {
+
+	size_t tLen, kLen, vLen;
+	const char* t = plg_Lvmchecklstring(_plVMHandle, L, 1, &tLen);
+	const char* k = plg_Lvmchecklstring(_plVMHandle, L, 2, &kLen);
+	const char* v = plg_Lvmchecklstring(_plVMHandle, L, 3, &vLen);
+
+	unsigned rtype = 0;
+	rtype = plg_JobSetTableTypeIfByte((void*)t, tLen, TT_String);
+	if (rtype != TT_String) {
+		elog(log_warn, "LAppend Current table '%s' type is '%s' to TT_String", t, plg_TT2String(rtype));
+	}
+
+	plg_Lvmpushnumber(_plVMHandle, L, (lua_Number)plg_JobAppend((void*)t, tLen, (void*)k, kLen, (void*)v, vLen));
+	return 1;
+}
+
 static int LTableClear(lua_State* L) {
 
 	size_t tLen;
@@ -394,6 +471,183 @@ static int LRang(lua_State* L) {
 	return 1;
 }
 
+/*
+RangIter and MembersIter return an iterator for the generic for, which reads the range in batches.
+Its state is a table with the table name, the end key, the batch size, the position in the batch,
+the number of rows in the batch and whether the range is finished, followed by the keys and values of the batch.
+A batch larger than _ITERBATCHMAX_ is read as _ITERBATCHMAX_, a batch that is not positive is an error and reads nothing
+*/
+#define _ITERBATCH_ 64
+#define _ITERBATCHMAX_ 4096
+enum IterState {
+	IS_TABLE = 1,
+	IS_END,
+	IS_LIMIT,
+	IS_POS,
+	IS_COUNT,
+	IS_FINISH,
+	IS_ROW
+};
+
+static void IterSetNumber(lua_State* L, int s, int i, double n) {
+
+	plg_Lvmpushnumber(_plVMHandle, L, i);
+	plg_Lvmpushnumber(_plVMHandle, L, n);
+	plg_Lvmsettable(_plVMHandle, L, s);
+}
+
+static double IterGetNumber(lua_State* L, int s, int i) {
+
+	plg_Lvmrawgeti(_plVMHandle, L, s, i);
+	double n = plg_Lvmtonumber(_plVMHandle, L, -1);
+	plg_Lvmsettop(_plVMHandle, L, -2);
+	return n;
+}
+
+static void IterFill(lua_State* L, int s, const char* t, size_t tLen, const char* k, size_t kLen, short afterBegin, const char* ke, size_t keLen, unsigned int limit) {
+
+	void* pDictExten = plg_DictExtenCreate();
+	unsigned int finish = plg_JobRangBatch((void*)t, tLen, (void*)k, kLen, afterBegin, (void*)ke, keLen, limit, pDictExten);
+
+	//the last key read is the first one of pDictExten
+	int count = plg_DictExtenSize(pDictExten);
+	int row = IS_ROW + count * 2;
+	void* dictIter = plg_DictExtenGetIterator(pDictExten);
+	void* dictNode;
+	while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
+		unsigned int keyLen = 0, valueLen = 0;
+		void* pk = plg_DictExtenKey(dictNode, &keyLen);
+		void* pv = plg_DictExtenValue(dictNode, &valueLen);
+
+		row -= 2;
+		plg_Lvmpushnumber(_plVMHandle, L, row);
+		plg_Lvmpushlstring(_plVMHandle, L, pk, keyLen);
+		plg_Lvmsettable(_plVMHandle, L, s);
+		plg_Lvmpushnumber(_plVMHandle, L, row + 1);
+		plg_Lvmpushlstring(_plVMHandle, L, pv, valueLen);
+		plg_Lvmsettable(_plVMHandle, L, s);
+	}
+	plg_DictExtenReleaseIterator(dictIter);
+	plg_DictExtenDestroy(pDictExten);
+
+	IterSetNumber(L, s, IS_POS, 0);
+	IterSetNumber(L, s, IS_COUNT, count);
+	IterSetNumber(L, s, IS_FINISH, finish);
+}
+
+static int LRangIterNext(lua_State* L) {
+
+	int s = 1;
+	unsigned int pos = IterGetNumber(L, s, IS_POS);
+	unsigned int count = IterGetNumber(L, s, IS_COUNT);
+
+	if (pos == count) {
+		if (count == 0 || IterGetNumber(L, s, IS_FINISH)) {
+			plg_Lvmpushnil(_plVMHandle, L);
+			return 1;
+		}
+
+		//the next batch begins after the last key of this one
+		size_t tLen, kLen, keLen;
+		plg_Lvmrawgeti(_plVMHandle, L, s, IS_TABLE);
+		const char* t = plg_Lvmtolstring(_plVMHandle, L, -1, &tLen);
+		plg_Lvmrawgeti(_plVMHandle, L, s, IS_END);
+		const char* ke = plg_Lvmtolstring(_plVMHandle, L, -1, &keLen);
+		plg_Lvmrawgeti(_plVMHandle, L, s, IS_ROW + (count - 1) * 2);
+		const char* k = plg_Lvmtolstring(_plVMHandle, L, -1, &kLen);
+
+		IterFill(L, s, t, tLen, k, kLen, 1, ke, keLen, (unsigned int)IterGetNumber(L, s, IS_LIMIT));
+		plg_Lvmsettop(_plVMHandle, L, -4);
+
+		pos = 0;
+		if (IterGetNumber(L, s, IS_COUNT) == 0) {
+			plg_Lvmpushnil(_plVMHandle, L);
+			return 1;
+		}
+	}
+
+	plg_Lvmrawgeti(_plVMHandle, L, s, IS_ROW + pos * 2);
+	plg_Lvmrawgeti(_plVMHandle, L, s, IS_ROW + pos * 2 + 1);
+	IterSetNumber(L, s, IS_POS, pos + 1);
+	return 2;
+}
+
+static int IterCreate(lua_State* L, const char* t, size_t tLen, const char* k, size_t kLen, const char* ke, size_t keLen, long long batch) {
+
+	unsigned rtype = 0;
+	rtype = plg_JobGetTableType((void*)t, tLen);
+	if (rtype != TT_String) {
+		elog(log_warn, "LRangIter Current table '%s' type is '%s' to TT_String", t, plg_TT2String(rtype));
+	}
+
+	unsigned int limit = batch > _ITERBATCHMAX_ ? _ITERBATCHMAX_ : (unsigned int)batch;
+	if (batch <= 0) {
+		elog(log_error, "LRangIter batch %lld of table '%s' must be greater than 0", batch, t);
+		limit = 0;
+	}
+
+	plg_Lvmpushcclosure(_plVMHandle, L, LRangIterNext, 0);
+	plg_Lvmcreatetable(_plVMHandle, L, IS_ROW - 1 + limit * 2, 0);
+	int s = plg_Lvmgettop(_plVMHandle, L);
+
+	plg_Lvmpushnumber(_plVMHandle, L, IS_TABLE);
+	plg_Lvmpushlstring(_plVMHandle, L, t, tLen);
+	plg_Lvmsettable(_plVMHandle, L, s);
+	plg_Lvmpushnumber(_plVMHandle, L, IS_END);
+	plg_Lvmpushlstring(_plVMHandle, L, ke, keLen);
+	plg_Lvmsettable(_plVMHandle, L, s);
+	IterSetNumber(L, s, IS_LIMIT, limit);
+
+	if (limit) {
+		IterFill(L, s, t, tLen, k, kLen, 0, ke, keLen, limit);
+	} else {
+		IterSetNumber(L, s, IS_POS, 0);
+		IterSetNumber(L, s, IS_COUNT, 0);
+		IterSetNumber(L, s, IS_FINISH, 1);
+	}
+	plg_Lvmpushnil(_plVMHandle, L);
+	return 3;
+}
+
+/*
+for k, v in pelagia.RangIter(table, beginKey, endKey, batch) do
+A nil beginKey starts at the head and a nil endKey runs to the tail
+*/
+static int LRangIter(lua_State* L) {
+
+	size_t tLen, kLen = 0, keLen = 0;
+	const char* k = 0;
+	const char* ke = "";
+	long long batch = _ITERBATCH_;
+	const char* t = plg_Lvmchecklstring(_plVMHandle, L, 1, &tLen);
+	if (plg_Lvmtype(_plVMHandle, L, 2) > LUA_TNIL) {
+		k = plg_Lvmchecklstring(_plVMHandle, L, 2, &kLen);
+	}
+	if (plg_Lvmtype(_plVMHandle, L, 3) > LUA_TNIL) {
+		ke = plg_Lvmchecklstring(_plVMHandle, L, 3, &keLen);
+	}
+	if (plg_Lvmtype(_plVMHandle, L, 4) > LUA_TNIL) {
+		batch = plg_Lvmcheckinteger(_plVMHandle, L, 4);
+	}
+
+	return IterCreate(L, t, tLen, k, kLen, ke, keLen, batch);
+}
+
+/*
+for k, v in pelagia.MembersIter(table, batch) do
+*/
+static int LMembersIter(lua_State* L) {
+
+	size_t tLen;
+	long long batch = _ITERBATCH_;
+	const char* t = plg_Lvmchecklstring(_plVMHandle, L, 1, &tLen);
+	if (plg_Lvmtype(_plVMHandle, L, 2) > LUA_TNIL) {
+		batch = plg_Lvmcheckinteger(_plVMHandle, L, 2);
+	}
+
+	return IterCreate(L, t, tLen, 0, 0, "", 0, batch);
+}
+
 static int LPoint(lua_State* L) {
 
 	size_t tLen, kLen;
@@ -536,6 +790,27 @@ static int LMultiGet(lua_State* L) {
 	return 1;
 }
 
+static int LPrefetch(lua_State* L) {
+
+	size_t tLen;
+	const char* t = plg_Lvmchecklstring(_plVMHandle, L, 1, &tLen);
+
+	void* pDictKeyExten = plg_DictExtenCreate();
+	plg_Lvmpushnil(_plVMHandle, L);
+	char* arrary_k; char* v = 0;
+	double dv;
+	while (plg_LvmTableNext(_plVMHandle, L, 2, &arrary_k, &v, &dv) != 0)
+	{
+		if (v) {
+			plg_DictExtenAdd(pDictKeyExten, v, strlen(v), NULL, 0);
+		}
+	}
+
+	plg_JobPrefetch((void*)t, tLen, pDictKeyExten);
+	plg_DictExtenDestroy(pDictKeyExten);
+	return 0;
+}
+
 static int LRand(lua_State* L) {
 
 	size_t tLen;
@@ -1886,6 +2161,90 @@ static int LEventSend(lua_State* L) {
 	return 0;
 }
 
+/*
+Entry points for the luajit ffi, see pelagiaffi.lua.
+They take and return raw buffers and skip the lua stack and the table construction of the bindings above
+*/
+int plg_LffiSet(const char* t, size_t tLen, const char* k, size_t kLen, const char* v, size_t vLen) {
+
+	unsigned rtype = plg_JobSetTableTypeIfByte((void*)t, tLen, TT_String);
+	if (rtype != TT_String) {
+		elog(log_warn, "plg_LffiSet Current table '%s' type is '%s' to TT_String", t, plg_TT2String(rtype));
+	}
+	return plg_JobSet((void*)t, tLen, (void*)k, kLen, (void*)v, vLen);
+}
+
+/*
+The value is returned as it is, release it with plg_LffiFree
+*/
+char* plg_LffiGet(const char* t, size_t tLen, const char* k, size_t kLen, unsigned int* valueLen) {
+
+	unsigned rtype = plg_JobGetTableType((void*)t, tLen);
+	if (rtype != TT_String) {
+		elog(log_warn, "plg_LffiGet Current table '%s' type is '%s' to TT_String", t, plg_TT2String(rtype));
+	}
+	return plg_JobGet((void*)t, tLen, (void*)k, kLen, valueLen);
+}
+
+/*
+One batch of at most limit rows of the range, read like RangIter.
+The rows are packed in key order in one buffer, each as unsigned int key length, key, unsigned int value length, value.
+A null b starts at the head, an empty e runs to the tail and afterBegin skips b itself.
+finish is 1 when no row is left after the batch. Release the buffer with plg_LffiFree
+*/
+char* plg_LffiRang(const char* t, size_t tLen, const char* b, size_t bLen, short afterBegin, const char* e, size_t eLen, unsigned int limit, unsigned int* count, unsigned int* finish) {
+
+	unsigned rtype = plg_JobGetTableType((void*)t, tLen);
+	if (rtype != TT_String) {
+		elog(log_warn, "plg_LffiRang Current table '%s' type is '%s' to TT_String", t, plg_TT2String(rtype));
+	}
+
+	if (limit == 0) {
+		limit = _ITERBATCH_;
+	} else if (limit > _ITERBATCHMAX_) {
+		limit = _ITERBATCHMAX_;
+	}
+
+	void* pDictExten = plg_DictExtenCreate();
+	*finish = plg_JobRangBatch((void*)t, tLen, (void*)b, bLen, afterBegin, (void*)e, eLen, limit, pDictExten);
+
+	size_t bufLen = 0;
+	void* dictIter = plg_DictExtenGetIterator(pDictExten);
+	void* dictNode;
+	while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
+		unsigned int keyLen = 0, valueLen = 0;
+		plg_DictExtenKey(dictNode, &keyLen);
+		plg_DictExtenValue(dictNode, &valueLen);
+		bufLen += 2 * sizeof(unsigned int) + keyLen + valueLen;
+	}
+	plg_DictExtenReleaseIterator(dictIter);
+
+	//the last key read is the first one of pDictExten, so the buffer is filled from its end
+	char* buf = malloc(bufLen ? bufLen : 1);
+	char* cur = buf + bufLen;
+	*count = 0;
+	dictIter = plg_DictExtenGetIterator(pDictExten);
+	while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
+		unsigned int keyLen = 0, valueLen = 0;
+		void* pk = plg_DictExtenKey(dictNode, &keyLen);
+		void* pv = plg_DictExtenValue(dictNode, &valueLen);
+
+		cur -= 2 * sizeof(unsigned int) + keyLen + valueLen;
+		memcpy(cur, &keyLen, sizeof(unsigned int));
+		memcpy(cur + sizeof(unsigned int), pk, keyLen);
+		memcpy(cur + sizeof(unsigned int) + keyLen, &valueLen, sizeof(unsigned int));
+		memcpy(cur + 2 * sizeof(unsigned int) + keyLen, pv, valueLen);
+		*count += 1;
+	}
+	plg_DictExtenReleaseIterator(dictIter);
+	plg_DictExtenDestroy(pDictExten);
+	return buf;
+}
+
+void plg_LffiFree(void* ptr) {
+	free(ptr);
+}
+
 static luaL_Reg mylibs[] = {
 	{ "NVersion", L_NVersion },
 	{ "MVersion", L_MVersion },
@@ -1902,6 +2261,9 @@ static luaL_Reg mylibs[] = {
 	{ "Timer", LTimer },
 	{ "TimerWithOrderID", LTimerWithOrderID },
 	{ "Commit", LCommit },
+	{ "Savepoint", LSavepoint },
+	{ "RollbackTo", LRollbackTo },
+	{ "ReleaseSavepoint", LReleaseSavepoint },
 	{ "CreateOrderID", LCreateOrderID },
 	{ "RemoveOrderID ", LRemoveOrderID },
 
@@ -1909,6 +2271,9 @@ static luaL_Reg mylibs[] = {
 	{ "MultiSet", LMultiSet },
 	{ "Del", LDel },
 	{ "SetIfNoExit", LSetIfNoExit },
+	{ "CompareAndSet", LCompareAndSet },
+	{ "IncrDouble", LIncrDouble },
+	{ "Append", LAppend },
 	{ "TableClear", LTableClear },
 	{ "Rename", LRename },
 
@@ -1921,8 +2286,11 @@ static luaL_Reg mylibs[] = {
 	{ "Point", LPoint },
 	{ "Pattern", LPattern },
 	{ "MultiGet", LMultiGet },
+	{ "Prefetch", LPrefetch },
 	{ "Rand", LRand },
 	{ "Members", LMembers },
+	{ "RangIter", LRangIter },
+	{ "MembersIter", LMembersIter },
 
 	{ "SetAdd", LSetAdd },
 	{ "SetMove", LSetMove },
@@ -18,5 +18,14 @@
 */
 #ifndef __LAPI_H
 #define __LAPI_H
+
+#include "papidefine.h"
+
 int plg_lualapilib(void* plVMHandle);
+
+//luajit ffi
+PELAGIA_API int plg_LffiSet(const char* t, size_t tLen, const char* k, size_t kLen, const char* v, size_t vLen);
+PELAGIA_API char* plg_LffiGet(const char* t, size_t tLen, const char* k, size_t kLen, unsigned int* valueLen);
+PELAGIA_API char* plg_LffiRang(const char* t, size_t tLen, const char* b, size_t bLen, short afterBegin, const char* e, size_t eLen, unsigned int limit, unsigned int* count, unsigned int* finish);
+PELAGIA_API void plg_LffiFree(void* ptr);
 #endif
\ No newline at end of file
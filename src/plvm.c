@@ -26,6 +26,10 @@
 #include "pdict.h"
 #include "psds.h"
 #include "pfilesys.h"
+#include "ptimesys.h"
+#include "pjson.h"
+#include "pbase64.h"
+#include "pjob.h"
 
 /*
 #define LUA_VERSION_NUM 501
@@ -56,15 +60,73 @@ static unsigned long long sdsHashCallback(const void *key) {
 	return plg_dictGenHashFunction((unsigned char*)key, plg_sdsLen((char*)key));
 }
 
-static dictType SdsDictType = {
+static void luaFileFreeCallback(void *privdata, void *val) {
+	DICT_NOTUSED(privdata);
+	free(val);
+}
+
+static dictType luaFileDictType = {
 	sdsHashCallback,
 	NULL,
 	NULL,
 	sdsCompareCallback,
 	sdsFreeCallback,
-	NULL
+	luaFileFreeCallback
+};
+
+/*
+With luaHot the modification time of a loaded file is checked at most every _LUAHOTCHECK_ milliseconds,
+the file is run again only when it changed
+*/
+#define _LUAHOTCHECK_ 1000
+
+typedef struct _LuaFile
+{
+	unsigned long long mtime;
+	unsigned long long size;
+	unsigned long long checkStamp;
+	unsigned int generation;
+}*PLuaFile, LuaFile;
+
+/*
+The entry function of an order in this lua state, kept as a registry reference.
+It is resolved again when the generation of its file changes
+*/
+typedef struct _LuaFun
+{
+	PLuaFile pLuaFile;
+	int ref;
+	unsigned int generation;
+}*PLuaFun, LuaFun;
+
+static unsigned long long ptrHashCallback(const void *key) {
+	return plg_dictGenHashFunction((unsigned char*)&key, sizeof(void*));
+}
+
+static dictType luaFunDictType = {
+	ptrHashCallback,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	luaFileFreeCallback
 };
 
+//The registry pseudo index moved in lua 5.2
+#define _LUA51REGISTRY_ (-10000)
+#define _LUA52REGISTRY_ (-1000000 - 1000)
+
+//nested tables deeper than this are returned as null
+#define _LUAJSONDEPTH_ 16
+
+//lua_rawgeti takes a lua_Integer since lua 5.3
+typedef int(*lua_rawgeti53) (lua_State *L, int idx, long long n);
+
+//lua_gc takes variable arguments since lua 5.4, which also brings back the generational mode of 5.2
+typedef int(*lua_gc54) (lua_State *L, int what, ...);
+#define _LUAGCGEN_ 10
+#define _LUAGCINC_ 11
+
 enum LuaVersion {
 	lua5_1 = 1,
 	lua5_2,
@@ -76,7 +138,9 @@ typedef struct _lVMHandle
 	lua_State *luaVM;//lua handle
 	short luaVersion;
 	short luaHot;
+	short gc54;
 	dict* lua_file;
+	dict* lua_fun;
 }*PlVMHandle, lVMHandle;
 
 short plg_LvmSetLuaVersion(void* hInstance) {
@@ -97,6 +161,12 @@ short plg_LvmSetLuaVersion(void* hInstance) {
 		version = lua5_3;
 	}
 
+	//luajit has the api of 5.1, its ffi is used from lua through pelagiaffi.lua
+	fun = (void*)plg_SysLibSym(hInstance, "luaJIT_setmode");
+	if (fun) {
+		elog(log_details, "plg_LvmSetLuaVersion: LuaJIT");
+	}
+
 	return version;
 }
 
@@ -411,6 +481,17 @@ int plg_Lvmnext(void* pvlVMHandle, void *L, int idx) {
 #endif
 }
 
+int plg_Lvmcheckstack(void* pvlVMHandle, void *L, int sz) {
+
+#ifndef STATIC_LUA
+	PlVMHandle plVMHandle = pvlVMHandle;
+	FillFun(plVMHandle->hInstance, lua_checkstack, 0);
+	return plua_checkstack(L, sz);
+#else
+	return lua_checkstack(L, sz);
+#endif
+}
+
 void plg_LvmRequiref(void* pvlVMHandle, const char *modname, void* openf, int glb) {
 	PlVMHandle plVMHandle = pvlVMHandle;
 	lua_CFunction lcfun = (lua_CFunction)openf;
@@ -426,6 +507,114 @@ void plg_LvmRequiref(void* pvlVMHandle, const char *modname, void* openf, int gl
 #endif
 }
 
+int plg_LvmRegistryIndex(void* pvlVMHandle) {
+
+#ifndef STATIC_LUA
+	PlVMHandle plVMHandle = pvlVMHandle;
+	return plVMHandle->luaVersion == lua5_1 ? _LUA51REGISTRY_ : _LUA52REGISTRY_;
+#else
+	NOTUSED(pvlVMHandle);
+#if LUA_VERSION_NUM == 501
+	return _LUA51REGISTRY_;
+#else
+	return _LUA52REGISTRY_;
+#endif
+#endif
+}
+
+int plg_Lvmref(void* pvlVMHandle, void* L, int t) {
+
+#ifndef STATIC_LUA
+	PlVMHandle plVMHandle = pvlVMHandle;
+	FillFun(plVMHandle->hInstance, luaL_ref, LUA_REFNIL);
+	return pluaL_ref(L, t);
+#else
+	return luaL_ref(L, t);
+#endif
+}
+
+void plg_Lvmunref(void* pvlVMHandle, void* L, int t, int ref) {
+
+#ifndef STATIC_LUA
+	PlVMHandle plVMHandle = pvlVMHandle;
+	FillFun(plVMHandle->hInstance, luaL_unref, NORET);
+	pluaL_unref(L, t, ref);
+#else
+	luaL_unref(L, t, ref);
+#endif
+}
+
+void plg_Lvmrawgeti(void* pvlVMHandle, void* L, int idx, int n) {
+
+#ifndef STATIC_LUA
+	PlVMHandle plVMHandle = pvlVMHandle;
+	if (plVMHandle->luaVersion == lua5_3) {
+		lua_rawgeti53 plua_rawgeti53 = plg_LvmCheckSym(plVMHandle->hInstance, "lua_rawgeti");
+		if (!plua_rawgeti53) {
+			return;
+		}
+		plua_rawgeti53(L, idx, n);
+	} else {
+		FillFun(plVMHandle->hInstance, lua_rawgeti, NORET);
+		plua_rawgeti(L, idx, n);
+	}
+#else
+	lua_rawgeti(L, idx, n);
+#endif
+}
+
+int plg_Lvmgettop(void* pvlVMHandle, void* L) {
+
+#ifndef STATIC_LUA
+	PlVMHandle plVMHandle = pvlVMHandle;
+	FillFun(plVMHandle->hInstance, lua_gettop, 0);
+	return plua_gettop(L);
+#else
+	return lua_gettop(L);
+#endif
+}
+
+int plg_Lvmtoboolean(void* pvlVMHandle, void* L, int idx) {
+
+#ifndef STATIC_LUA
+	PlVMHandle plVMHandle = pvlVMHandle;
+	FillFun(plVMHandle->hInstance, lua_toboolean, 0);
+	return plua_toboolean(L, idx);
+#else
+	return lua_toboolean(L, idx);
+#endif
+}
+
+void plg_Lvmpushcclosure(void* pvlVMHandle, void* L, void* fn, int n) {
+
+#ifndef STATIC_LUA
+	PlVMHandle plVMHandle = pvlVMHandle;
+	FillFun(plVMHandle->hInstance, lua_pushcclosure, NORET);
+	plua_pushcclosure(L, fn, n);
+#else
+	lua_pushcclosure(L, fn, n);
+#endif
+}
+
+int plg_Lvmgc(void* pvlVMHandle, void* L, int what, int data) {
+
+#ifndef STATIC_LUA
+	PlVMHandle plVMHandle = pvlVMHandle;
+	if (plVMHandle->gc54) {
+		lua_gc54 plua_gc = plg_LvmCheckSym(plVMHandle->hInstance, "lua_gc");
+		if (!plua_gc) {
+			return 0;
+		}
+		return plua_gc(L, what, data);
+	} else {
+		FillFun(plVMHandle->hInstance, lua_gc, 0);
+		return plua_gc(L, what, data);
+	}
+#else
+	return lua_gc(L, what, data);
+#endif
+}
+
 lua_State * plg_Lvmnewstate(void* pvlVMHandle) {
 
 #ifndef STATIC_LUA
@@ -490,8 +679,15 @@ void* plg_LvmLoad(const char *path, short luaHot) {
 	PlVMHandle plVMHandle = malloc(sizeof(lVMHandle));
 	plVMHandle->hInstance = hInstance;
 	plVMHandle->luaVersion = version;
-	plVMHandle->lua_file = plg_dictCreate(&SdsDictType, NULL, DICT_MIDDLE);
+	plVMHandle->lua_file = plg_dictCreate(&luaFileDictType, NULL, DICT_MIDDLE);
+	plVMHandle->lua_fun = plg_dictCreate(&luaFunDictType, NULL, DICT_MIDDLE);
 	plVMHandle->luaHot = luaHot;
+	plVMHandle->gc54 = 0;
+#ifndef STATIC_LUA
+	if (plg_SysLibSym(hInstance, "lua_newuserdatauv")) {
+		plVMHandle->gc54 = 1;
+	}
+#endif
 	plVMHandle->luaVM = plg_Lvmnewstate(plVMHandle);
 
 	plg_Lvmopenlibs(plVMHandle);
@@ -513,53 +709,355 @@ void plg_LvmDestory(void* pvlVMHandle) {
 	plg_SysLibUnload(plVMHandle->hInstance);
 #endif
 
+	plg_dictRelease(plVMHandle->lua_fun);
 	plg_dictRelease(plVMHandle->lua_file);
 	free(plVMHandle);
 }
 
-int plg_LvmCallFile(void* pvlVMHandle, char* sdsFile, char* fun, void* value, short len) {
+/*
+Set the collector of the vm, a pause or stepMul of 0 keeps the value of the lua version.
+Lua 5.1 and 5.3 have only the incremental mode, the generational mode needs 5.2 or 5.4
+*/
+void plg_LvmSetGC(void* pvlVMHandle, short mode, int pause, int stepMul) {
 
 	PlVMHandle plVMHandle = pvlVMHandle;
+	if (mode == LGC_Generational || mode == LGC_Incremental) {
+		int what = mode == LGC_Generational ? _LUAGCGEN_ : _LUAGCINC_;
+		if (plVMHandle->gc54) {
+			lua_gc54 plua_gc = plg_LvmCheckSym(plVMHandle->hInstance, "lua_gc");
+			if (plua_gc) {
+				//5.4 takes the parameters of the mode, 0 keeps the current value
+				if (mode == LGC_Generational) {
+					plua_gc(plVMHandle->luaVM, what, 0, 0);
+				} else {
+					plua_gc(plVMHandle->luaVM, what, pause, stepMul, 0);
+				}
+			}
+		} else if (plVMHandle->luaVersion == lua5_2) {
+			plg_Lvmgc(plVMHandle, plVMHandle->luaVM, what, 0);
+		} else if (mode == LGC_Generational) {
+			elog(log_warn, "plg_LvmSetGC: The generational mode needs lua 5.2 or 5.4, keep the incremental mode");
+		}
+	}
 
-	if (plVMHandle->luaHot) {
-		if (plg_Lvmloadfile(plVMHandle, plVMHandle->luaVM, sdsFile)){
-			elog(log_error, "plg_LvmCallFile.pluaL_loadfilex:%s", plg_Lvmtolstring(pvlVMHandle, plVMHandle->luaVM, -1, NULL));
-			plg_Lvmsettop(plVMHandle, plVMHandle->luaVM, 0);
-			return 0;
+	if (pause) {
+		plg_Lvmgc(plVMHandle, plVMHandle->luaVM, LUA_GCSETPAUSE, pause);
+	}
+
+	if (stepMul) {
+		plg_Lvmgc(plVMHandle, plVMHandle->luaVM, LUA_GCSETSTEPMUL, stepMul);
+	}
+}
+
+/*
+Run one step of the collector of about stepSize KB, return 1 when the step finished a cycle
+*/
+int plg_LvmGCStep(void* pvlVMHandle, int stepSize) {
+
+	PlVMHandle plVMHandle = pvlVMHandle;
+	return plg_Lvmgc(plVMHandle, plVMHandle->luaVM, LUA_GCSTEP, stepSize);
+}
+
+/*
+Run the file so that its functions are defined in the lua state
+*/
+static int lvm_RunFile(PlVMHandle plVMHandle, char* sdsFile) {
+
+	if (plg_Lvmloadfile(plVMHandle, plVMHandle->luaVM, sdsFile)){
+		elog(log_error, "plg_LvmCallFile.pluaL_loadfilex:%s", plg_Lvmtolstring(plVMHandle, plVMHandle->luaVM, -1, NULL));
+		plg_Lvmsettop(plVMHandle, plVMHandle->luaVM, 0);
+		return 0;
+	}
+
+	//load fun
+	if (plg_Lvmpcall(plVMHandle, plVMHandle->luaVM, 0, LUA_MULTRET, 0)) {
+		elog(log_error, "plg_LvmCallFile.plua_pcall:%s lua:%s", sdsFile, plg_Lvmtolstring(plVMHandle, plVMHandle->luaVM, -1, NULL));
+		plg_Lvmsettop(plVMHandle, plVMHandle->luaVM, 0);
+		return 0;
+	}
+	plg_Lvmsettop(plVMHandle, plVMHandle->luaVM, 0);
+	return 1;
+}
+
+/*
+Reload a changed file between two orders of the job.
+If the new file fails the old functions stay, it is tried again when the file changes again
+*/
+static void lvm_HotFile(PlVMHandle plVMHandle, char* sdsFile, PLuaFile pLuaFile) {
+
+	unsigned long long stamp = plg_GetCurrentMilli();
+	if (stamp - pLuaFile->checkStamp < _LUAHOTCHECK_) {
+		return;
+	}
+	pLuaFile->checkStamp = stamp;
+
+	unsigned long long size;
+	unsigned long long mtime = plg_SysFileMTime(sdsFile, &size);
+	if (mtime == 0 || (mtime == pLuaFile->mtime && size == pLuaFile->size)) {
+		return;
+	}
+	pLuaFile->mtime = mtime;
+	pLuaFile->size = size;
+	pLuaFile->generation += 1;
+
+	elog(log_details, "plg_LvmCallFile.reload:%s", sdsFile);
+	lvm_RunFile(plVMHandle, sdsFile);
+}
+
+static pJSON* lvm_ToJson(PlVMHandle plVMHandle, void* L, int idx, int depth);
+
+/*
+A table whose keys are exactly 1..n becomes an array, any other table an object.
+Each level keeps a key and a value on the stack, a level the stack cannot grow for is null
+*/
+static pJSON* lvm_TableToJson(PlVMHandle plVMHandle, void* L, int idx, int depth) {
+
+	if (!plg_Lvmcheckstack(plVMHandle, L, 3)) {
+		elog(log_error, "lvm_TableToJson.plg_Lvmcheckstack at depth %i", depth);
+		return pJson_CreateNull();
+	}
+
+	unsigned int count = 0;
+	double maxKey = 0;
+	short isArray = 1;
+	plg_Lvmpushnil(plVMHandle, L);
+	while (plg_Lvmnext(plVMHandle, L, idx)) {
+		count += 1;
+		if (plg_Lvmtype(plVMHandle, L, -2) == LUA_TNUMBER) {
+			double key = plg_Lvmtonumber(plVMHandle, L, -2);
+			if (key < 1 || key != (double)(unsigned int)key) {
+				isArray = 0;
+			} else if (key > maxKey) {
+				maxKey = key;
+			}
+		} else {
+			isArray = 0;
 		}
+		plg_Lvmsettop(plVMHandle, L, -2);
+	}
 
-		//load fun
-		if (plg_Lvmpcall(pvlVMHandle, plVMHandle->luaVM, 0, LUA_MULTRET, 0)) {
-			elog(log_error, "plg_LvmCallFile.plua_pcall:%s lua:%s", sdsFile, plg_Lvmtolstring(pvlVMHandle, plVMHandle->luaVM, -1, NULL));
-			plg_Lvmsettop(plVMHandle, plVMHandle->luaVM, 0);
-			return 0;
+	if (isArray && count && maxKey == count) {
+		pJSON** items = calloc(count, sizeof(pJSON*));
+		plg_Lvmpushnil(plVMHandle, L);
+		while (plg_Lvmnext(plVMHandle, L, idx)) {
+			unsigned int key = (unsigned int)plg_Lvmtonumber(plVMHandle, L, -2);
+			items[key - 1] = lvm_ToJson(plVMHandle, L, plg_Lvmgettop(plVMHandle, L), depth);
+			plg_Lvmsettop(plVMHandle, L, -2);
+		}
+
+		pJSON* array = pJson_CreateArray();
+		for (unsigned int l = 0; l < count; l++) {
+			pJson_AddItemToArray(array, items[l]);
+		}
+		free(items);
+		return array;
+	}
+
+	pJSON* object = pJson_CreateObject();
+	plg_Lvmpushnil(plVMHandle, L);
+	while (plg_Lvmnext(plVMHandle, L, idx)) {
+		//lua_tolstring must not convert the key in place, it would break lua_next
+		char buf[32];
+		const char* key = 0;
+		size_t keyLen = 0;
+		if (plg_Lvmtype(plVMHandle, L, -2) == LUA_TSTRING) {
+			key = plg_Lvmtolstring(plVMHandle, L, -2, &keyLen);
+		} else if (plg_Lvmtype(plVMHandle, L, -2) == LUA_TNUMBER) {
+			keyLen = snprintf(buf, sizeof(buf), "%.17g", plg_Lvmtonumber(plVMHandle, L, -2));
+			key = buf;
+		}
+
+		if (key) {
+			pJson_AddItemToObjectWithLen(object, key, keyLen, lvm_ToJson(plVMHandle, L, plg_Lvmgettop(plVMHandle, L), depth));
+		}
+		plg_Lvmsettop(plVMHandle, L, -2);
+	}
+	return object;
+}
+
+/*
+idx must be an absolute index of the stack
+*/
+static pJSON* lvm_ToJson(PlVMHandle plVMHandle, void* L, int idx, int depth) {
+
+	switch (plg_Lvmtype(plVMHandle, L, idx)) {
+	case LUA_TNUMBER:
+		return pJson_CreateNumber(plg_Lvmtonumber(plVMHandle, L, idx));
+	case LUA_TBOOLEAN:
+		return pJson_CreateBool(plg_Lvmtoboolean(plVMHandle, L, idx));
+	case LUA_TSTRING: {
+		size_t len;
+		const char* str = plg_Lvmtolstring(plVMHandle, L, idx, &len);
+		return pJson_CreateStringWihtLen(str, len);
+	}
+	case LUA_TTABLE:
+		if (depth < _LUAJSONDEPTH_) {
+			return lvm_TableToJson(plVMHandle, L, idx, depth + 1);
+		}
+	}
+	return pJson_CreateNull();
+}
+
+/*
+Send the results of a lua order to the caller.
+The order value is the json of plg_MngRemoteCallWithJson or plg_MngRemoteCallWithArg,
+its "event" gets the results like EventSend and its "reply" is called as an order with them.
+A single string is sent as it is, other results as json, several results as a json array.
+A lone number or nil is only the result of the order and is not sent.
+An order that returns 0 is rolled back and sends nothing.
+*/
+static void lvm_Reply(PlVMHandle plVMHandle, void* value, short len, int nres) {
+
+	void* L = plVMHandle->luaVM;
+	if (nres == 0) {
+		return;
+	} else if (nres == 1) {
+		int type = plg_Lvmtype(plVMHandle, L, 1);
+		if (type == LUA_TNUMBER || type == LUA_TNIL) {
+			return;
 		}
+	}
+
+	sds sdsValue = plg_sdsNewLen(value, len);
+	pJSON* root = pJson_Parse(sdsValue);
+	plg_sdsFree(sdsValue);
+	if (!root) {
+		return;
+	}
+
+	pJSON* event = pJson_GetObjectItem(root, "event");
+	pJSON* reply = pJson_GetObjectItem(root, "reply");
+	if (event && event->type != pJson_String) {
+		event = 0;
+	}
+	if (reply && reply->type != pJson_String) {
+		reply = 0;
+	}
+	if (!event && !reply) {
+		pJson_Delete(root);
+		return;
+	}
+
+	const char* out;
+	size_t outLen;
+	char* print = 0;
+	if (nres == 1 && plg_Lvmtype(plVMHandle, L, 1) == LUA_TSTRING) {
+		out = plg_Lvmtolstring(plVMHandle, L, 1, &outLen);
 	} else {
-		dictEntry* entry = plg_dictFind(plVMHandle->lua_file, sdsFile);
-		if (!entry) {
-			if (plg_Lvmloadfile(plVMHandle, plVMHandle->luaVM, sdsFile)){
-				elog(log_error, "plg_LvmCallFile.pluaL_loadfilex:%s", plg_Lvmtolstring(pvlVMHandle, plVMHandle->luaVM, -1, NULL));
-				plg_Lvmsettop(plVMHandle, plVMHandle->luaVM, 0);
-				return 0;
+		pJSON* result;
+		if (nres == 1) {
+			result = lvm_ToJson(plVMHandle, L, 1, 0);
+		} else {
+			result = pJson_CreateArray();
+			for (int l = 1; l <= nres; l++) {
+				pJson_AddItemToArray(result, lvm_ToJson(plVMHandle, L, l, 0));
 			}
+		}
+		print = pJson_PrintUnformatted(result);
+		pJson_Delete(result);
+		out = print;
+		outLen = strlen(print);
+	}
 
-			//load fun
-			if (plg_Lvmpcall(pvlVMHandle, plVMHandle->luaVM, 0, LUA_MULTRET, 0)) {
-				elog(log_error, "plg_LvmCallFile.plua_pcall:%s lua:%s", sdsFile, plg_Lvmtolstring(pvlVMHandle, plVMHandle->luaVM, -1, NULL));
-				plg_Lvmsettop(plVMHandle, plVMHandle->luaVM, 0);
-				return 0;
-			}
-			sds newFile = plg_sdsNew(sdsFile);
-			plg_dictAdd(plVMHandle->lua_file, newFile, 0);
+	if (event) {
+		unsigned int decsize;
+		unsigned char* buff = plg_B64DecodeEx(event->valuestring, strlen(event->valuestring), &decsize);
+		void* p = 0;
+		if (decsize == sizeof(void*)) {
+			memcpy(&p, buff, decsize);
+		}
+
+		if ((unsigned long long)p == 101021) {
+			printf("%.*s\n", (int)outLen, out);
+		} else if (p) {
+			plg_EventSendWithMax(p, out, outLen, job_MaxQueue());
 		}
+		free(buff);
 	}
 
-	//call fun
-	if (plVMHandle->luaVersion == lua5_1) {
-		plg_Lvmgetfield(pvlVMHandle, plVMHandle->luaVM, LUA_GLOBALSINDEX, fun);
+	if (reply) {
+		if (outLen > SHRT_MAX) {
+			elog(log_error, "plg_LvmCallFile.reply:%s result of %u bytes is too long", reply->valuestring, (unsigned int)outLen);
+		} else {
+			plg_JobRemoteCall(reply->valuestring, strlen(reply->valuestring), (void*)out, outLen);
+		}
+	}
+
+	free(print);
+	pJson_Delete(root);
+}
+
+/*
+The loaded file, it is run on first use
+*/
+static PLuaFile lvm_File(PlVMHandle plVMHandle, char* sdsFile) {
+
+	dictEntry* entry = plg_dictFind(plVMHandle->lua_file, sdsFile);
+	if (entry) {
+		if (plVMHandle->luaHot) {
+			lvm_HotFile(plVMHandle, sdsFile, dictGetVal(entry));
+		}
+		return dictGetVal(entry);
+	}
+
+	unsigned long long size = 0;
+	unsigned long long mtime = plg_SysFileMTime(sdsFile, &size);
+	if (!lvm_RunFile(plVMHandle, sdsFile)) {
+		return 0;
+	}
+
+	PLuaFile pLuaFile = malloc(sizeof(LuaFile));
+	pLuaFile->mtime = mtime;
+	pLuaFile->size = size;
+	pLuaFile->checkStamp = plg_GetCurrentMilli();
+	pLuaFile->generation = 0;
+	plg_dictAdd(plVMHandle->lua_file, plg_sdsNew(sdsFile), pLuaFile);
+	return pLuaFile;
+}
+
+/*
+order identifies the registered order, its entry function is looked up by name once
+and then called through its registry reference
+*/
+int plg_LvmCallFile(void* pvlVMHandle, void* order, char* sdsFile, char* fun, void* value, short len) {
+
+	PlVMHandle plVMHandle = pvlVMHandle;
+	int registry = plg_LvmRegistryIndex(plVMHandle);
+
+	PLuaFun pLuaFun;
+	dictEntry* entry = plg_dictFind(plVMHandle->lua_fun, order);
+	if (entry) {
+		pLuaFun = dictGetVal(entry);
+		if (plVMHandle->luaHot) {
+			lvm_HotFile(plVMHandle, sdsFile, pLuaFun->pLuaFile);
+		}
 	} else {
-		plg_Lvmgetglobal(pvlVMHandle, plVMHandle->luaVM, fun);
+		PLuaFile pLuaFile = lvm_File(plVMHandle, sdsFile);
+		if (!pLuaFile) {
+			return 0;
+		}
+
+		pLuaFun = malloc(sizeof(LuaFun));
+		pLuaFun->pLuaFile = pLuaFile;
+		pLuaFun->ref = LUA_REFNIL;
+		pLuaFun->generation = pLuaFile->generation;
+		plg_dictAdd(plVMHandle->lua_fun, order, pLuaFun);
+	}
+
+	//A function that is not defined yet or a file that was loaded again is looked up by name
+	if (pLuaFun->ref == LUA_REFNIL || pLuaFun->generation != pLuaFun->pLuaFile->generation) {
+		plg_Lvmunref(pvlVMHandle, plVMHandle->luaVM, registry, pLuaFun->ref);
+		if (plVMHandle->luaVersion == lua5_1) {
+			plg_Lvmgetfield(pvlVMHandle, plVMHandle->luaVM, LUA_GLOBALSINDEX, fun);
+		} else {
+			plg_Lvmgetglobal(pvlVMHandle, plVMHandle->luaVM, fun);
+		}
+		pLuaFun->ref = plg_Lvmref(pvlVMHandle, plVMHandle->luaVM, registry);
+		pLuaFun->generation = pLuaFun->pLuaFile->generation;
 	}
+
+	//call fun
+	plg_Lvmrawgeti(pvlVMHandle, plVMHandle->luaVM, registry, pLuaFun->ref);
 	plg_Lvmpushlstring(pvlVMHandle, plVMHandle->luaVM, value, len);
 
 	if (plg_Lvmpcall(pvlVMHandle, plVMHandle->luaVM, 1, LUA_MULTRET, 0)) {
@@ -568,9 +1066,14 @@ int plg_LvmCallFile(void* pvlVMHandle, char* sdsFile, char* fun, void* value, sh
 		return 0;
 	}
 
+	//the first result, if it is a number, is the result of the order
+	int nres = plg_Lvmgettop(pvlVMHandle, plVMHandle->luaVM);
 	double ret = 1;
-	if (plg_Lvmisnumber(pvlVMHandle, plVMHandle->luaVM, -1)) {
-		ret = plg_Lvmtonumber(pvlVMHandle, plVMHandle->luaVM, -1);
+	if (nres && plg_Lvmisnumber(pvlVMHandle, plVMHandle->luaVM, 1)) {
+		ret = plg_Lvmtonumber(pvlVMHandle, plVMHandle->luaVM, 1);
+	}
+	if (ret != 0) {
+		lvm_Reply(plVMHandle, value, len, nres);
 	}
 
 	//clear lua --lua_pop(L,1) lua_settop(L, -(n)-1)
@@ -23,7 +23,9 @@
 
 void* plg_LvmLoad(const char *path, short luaHot);
 void plg_LvmDestory(void* plVMHandle);
-int plg_LvmCallFile(void* plVMHandle, char* sdsFile, char* fun, void* value, short len);
+void plg_LvmSetGC(void* pvlVMHandle, short mode, int pause, int stepMul);
+int plg_LvmGCStep(void* pvlVMHandle, int stepSize);
+int plg_LvmCallFile(void* plVMHandle, void* order, char* sdsFile, char* fun, void* value, short len);
 void* plg_LvmCheckSym(void *lib, const char *sym);
 void* plg_LvmGetInstance(void* plVMHandle);
 void* plg_LvmGetL(void* plVMHandle);
@@ -32,6 +34,7 @@ void plg_Lvmregister(void* pvlVMHandle, void* L, const char *libname, void* l);
 short plg_LvmGetV(void* plVMHandle);
 void plg_Lvmcreatetable(void* pvlVMHandle, void *L, int narr, int nrec);
 int plg_Lvmnext(void* pvlVMHandle, void *L, int idx);
+int plg_Lvmcheckstack(void* pvlVMHandle, void *L, int sz);
 
 int plg_LvmTableNext(void* plVMHandle, void* L, int i, char **k, char **sv, double *dv);
 
@@ -54,6 +57,14 @@ void plg_Lvmsettable(void* pvlVMHandle, void* L, int idx);
 void plg_Lvmpushnumber(void* pvlVMHandle, void* L, double n);
 long long plg_Lvmcheckinteger(void* pvlVMHandle, void* L, int numArg);
 void plg_Lvmpushnil(void* pvlVMHandle, void* L);
+int plg_Lvmgettop(void* pvlVMHandle, void* L);
+int plg_Lvmtoboolean(void* pvlVMHandle, void* L, int idx);
+int plg_Lvmgc(void* pvlVMHandle, void* L, int what, int data);
+void plg_Lvmpushcclosure(void* pvlVMHandle, void* L, void* fn, int n);
+int plg_LvmRegistryIndex(void* pvlVMHandle);
+int plg_Lvmref(void* pvlVMHandle, void* L, int t);
+void plg_Lvmunref(void* pvlVMHandle, void* L, int t, int ref);
+void plg_Lvmrawgeti(void* pvlVMHandle, void* L, int idx, int n);
 
 void plg_LvmRequiref(void* pvlVMHandle, const char *modname, void* openf, int glb);
 
@@ -28,6 +28,7 @@
 #include "pjob.h"
 #include "pfile.h"
 #include "pdisk.h"
+#include "pcache.h"
 #include "pinterface.h"
 #include "pmanage.h"
 #include "plocks.h"
@@ -39,6 +40,7 @@
 #include "pbase64.h"
 #include "pstart.h"
 #include "plibsys.h"
+#include "pmemorylist.h"
 
 #define NORET
 #define CheckUsingThread(r) if (plg_MngCheckUsingThread()) {elog(log_error, "Cannot run management interface in non user environment");return r;}
@@ -114,6 +116,23 @@ typedef struct _Manage
 
 	//
 	unsigned int maxQueue;
+
+	//group commit
+	unsigned int groupCount;
+	unsigned int groupInterval;
+
+	//page frame arena shared by all caches, in MB
+	unsigned int pageArena;
+	void* memoryArena;
+
+	//free page frames kept by each cache
+	unsigned int pageHighWater;
+
+	//lua collector of each job
+	short luaGCMode;
+	int luaGCPause;
+	int luaGCStepMul;
+	int luaGCIdleStep;
 } *PManage, Manage;
 
 static void listSdsFree(void *ptr) {
@@ -213,7 +232,7 @@ static void manage_InitLoadFile(void* pvManage) {
 			break;
 		}
 
-		if (1 == plg_DiskFileOpen(plg_JobEqueueHandle(pManage->pJobHandle), fullPath, &pDiskHandle, 0, pManage->noSave)) {
+		if (1 == plg_DiskFileOpen(plg_JobEqueueHandle(pManage->pJobHandle), fullPath, &pDiskHandle, 0, pManage->noSave, 0)) {
 			plg_listAddNodeHead(pManage->listDisk, pDiskHandle);
 		} else {
 			plg_sdsFree(fullPath);
@@ -229,9 +248,14 @@ static void manage_DestroyDisk(void* pvManage) {
 	plg_listEmpty(pManage->listDisk);
 }
 
+/*
+A table goes to the file of its parent, otherwise to the least loaded file with its page size.
+A new file is created when those are full
+*/
 static void manage_AddTableToDisk(void* pvManage, PTableName pTableName, sds tableName) {
 
 	PManage pManage = pvManage;
+	unsigned short pageSize = pTableName->pageSize ? pTableName->pageSize : _PAGESIZE_;
 	unsigned int count = UINT_MAX;
 	void* countLost = 0;
 
@@ -244,6 +268,9 @@ static void manage_AddTableToDisk(void* pvManage, PTableName pTableName, sds tab
 
 		//Already exists in the file
 		if (plg_DiskTableFind(listNodeValue(node), tableName, NULL)) {
+			if (plg_DiskGetPageSize(listNodeValue(node)) != pageSize) {
+				elog(log_warn, "manage_AddTableToDisk.Table %s stays in its file with page size %i!", tableName, (int)plg_DiskGetPageSize(listNodeValue(node)));
+			}
 			plg_dictAdd(pManage->tableName_diskHandle, tableName, listNodeValue(node));
 			plg_listReleaseIterator(iter);
 			return;
@@ -257,6 +284,11 @@ static void manage_AddTableToDisk(void* pvManage, PTableName pTableName, sds tab
 			return;
 		}
 
+		//Only the files with the page size of the table
+		if (plg_DiskGetPageSize(listNodeValue(node)) != pageSize) {
+			continue;
+		}
+
 		//no save file
 		if (plg_DiskIsNoSave(listNodeValue(node)) && plg_DiskGetTableAllWeight(listNodeValue(node)) < noSaveCount) {
 			noSaveCountLost = listNodeValue(node);
@@ -275,7 +307,7 @@ static void manage_AddTableToDisk(void* pvManage, PTableName pTableName, sds tab
 		if (noSaveCount > pManage->maxTableWeight) {
 			sds fullPath = plg_sdsCatFmt(plg_sdsEmpty(), "%spnosave", pManage->dbPath);
 			void* pDiskHandle;
-			if (1 == plg_DiskFileOpen(plg_JobEqueueHandle(pManage->pJobHandle), fullPath, &pDiskHandle, 1, pTableName->noSave)) {
+			if (1 == plg_DiskFileOpen(plg_JobEqueueHandle(pManage->pJobHandle), fullPath, &pDiskHandle, 1, pTableName->noSave, pageSize)) {
 				plg_listAddNodeHead(pManage->listDisk, pDiskHandle);
 				plg_DiskAddTableWeight(pDiskHandle, pTableName->weight);
 				plg_dictAdd(pManage->tableName_diskHandle, tableName, pDiskHandle);
@@ -290,7 +322,7 @@ static void manage_AddTableToDisk(void* pvManage, PTableName pTableName, sds tab
 			plg_MkDirs(pManage->dbPath);
 			sds fullPath = plg_sdsCatFmt(plg_sdsEmpty(), "%sp%i", pManage->dbPath, listLength(pManage->listDisk));
 			void* pDiskHandle;
-			if (1 == plg_DiskFileOpen(plg_JobEqueueHandle(pManage->pJobHandle), fullPath, &pDiskHandle, 1, pTableName->noSave)) {
+			if (1 == plg_DiskFileOpen(plg_JobEqueueHandle(pManage->pJobHandle), fullPath, &pDiskHandle, 1, pTableName->noSave, pageSize)) {
 				plg_listAddNodeHead(pManage->listDisk, pDiskHandle);
 				plg_DiskAddTableWeight(pDiskHandle, pTableName->weight);
 				plg_dictAdd(pManage->tableName_diskHandle, tableName, pDiskHandle);
@@ -313,6 +345,7 @@ static void pFillTableNameCB(void* pDiskHandle, void* ptr, char* tableName) {
 	pTableName->weight = 1;
 	pTableName->noShare = 0;
 	pTableName->noSave = pManage->noSave;
+	pTableName->pageSize = plg_DiskGetPageSize(pDiskHandle);
 	plg_dictAdd(pManage->dictTableName, tableName, pTableName);
 	plg_dictAdd(pManage->tableName_diskHandle, tableName, pDiskHandle);
 }
@@ -332,7 +365,7 @@ static void manage_CreateDiskWithFileName(void* pvManage,char* FileName) {
 		return;
 	}
 
-	if (1 == plg_DiskFileOpen(plg_JobEqueueHandle(pManage->pJobHandle), fullPath, &pDiskHandle, 0, pManage->noSave)) {
+	if (1 == plg_DiskFileOpen(plg_JobEqueueHandle(pManage->pJobHandle), fullPath, &pDiskHandle, 0, pManage->noSave, 0)) {
 		plg_listAddNodeHead(pManage->listDisk, pDiskHandle);
 	} else {
 		elog(log_error, "manage_CreateDiskWithFileName.plg_DiskFileOpen:%s", fullPath);
@@ -413,8 +446,9 @@ static void manage_AddTableToJob(void* pvManage, void* pJobHandle, dict * table)
 		}
 
 		PTableName pTableName = dictGetVal(tableEntry);
-		//only add to current job
+		//only add to current job, the cache is private to the job and runs without lock
 		if (pTableName->noShare) {
+			plg_CacheSetShare(pCacheHandle, 0);
 			plg_JobAddTableCache(pJobHandle, dictGetKey(tableNode), pCacheHandle);
 		} else {
 			//listjob
@@ -451,12 +485,20 @@ int plg_MngInterAllocJob(void* pvManage, unsigned int core, char* fileName) {
 	}
 	
 	CheckUsingThread(0);
+	if (pManage->pageArena && pManage->memoryArena == 0) {
+		pManage->memoryArena = plg_MemArenaCreate((size_t)pManage->pageArena * MB);
+	}
+
 	//Create n jobs
 	for (unsigned int l = 0; l < core; l++) {
 		void* pJobHandle = plg_JobCreateHandle(plg_JobEqueueHandle(pManage->pJobHandle), TT_PROCESS, pManage->luaLIBPath, pManage->luaHot, l + 1);
 		plg_JobSetStat(pJobHandle, pManage->isOpenStat, pManage->checkTime);
 		plg_JobSetPrivate(pJobHandle, pvManage);
 		plg_JobSetMaxQueue(pJobHandle, pManage->maxQueue);
+		plg_JobSetGroupCommit(pJobHandle, pManage->groupCount, pManage->groupInterval);
+		plg_JobSetPageArena(pJobHandle, pManage->memoryArena);
+		plg_JobSetPageHighWater(pJobHandle, pManage->pageHighWater);
+		plg_JobSetLuaGC(pJobHandle, pManage->luaGCMode, pManage->luaGCPause, pManage->luaGCStepMul, pManage->luaGCIdleStep);
 		plg_listAddNodeHead(pManage->listJob, pJobHandle);
 	}
 
@@ -682,6 +724,7 @@ int plg_MngAddTable(void* pvManage, char* nameOrder, short nameOrderLen, char* n
 		pTableName->weight = 1;
 		pTableName->noShare = 0;
 		pTableName->noSave = pManage->noSave;
+		pTableName->pageSize = 0;
 		plg_dictAdd(pManage->dictTableName, sdsTableName, pTableName);
 
 		if (!plg_DictSetIn(pManage->order_tableName, sdsnameOrder, sdsTableName)) {
@@ -781,6 +824,35 @@ int plg_MngSetNoShare(void* pvManage, char* nameTable, short nameTableLen, unsig
 	return ret;
 }
 
+/*
+Page size in KB of the file that keeps a new table, a power of two from _PAGESIZEMIN_ to _PAGESIZEMAX_.
+A table already in a file stays there with the page size of the file
+*/
+int plg_MngSetPageSize(void* pvManage, char* nameTable, short nameTableLen, unsigned short pageSize) {
+
+	PManage pManage = pvManage;
+	if (pManage->runStatus) {
+		elog(log_error, "Changes are not allowed during system runing!");
+		return 0;
+	}
+
+	if (!plg_DiskCheckPageSize(pageSize)) {
+		elog(log_error, "plg_MngSetPageSize.Page size %i must be a power of two from %i to %i!", pageSize, _PAGESIZEMIN_, _PAGESIZEMAX_);
+		return 0;
+	}
+
+	int ret = 0;
+	sds sdsNameTable = plg_sdsNewLen(nameTable, nameTableLen);
+	dictEntry* tableNameNode = plg_dictFind(pManage->dictTableName, sdsNameTable);
+	if (tableNameNode != NULL) {
+		PTableName pTableName = dictGetVal(tableNameNode);
+		pTableName->pageSize = pageSize;
+		ret = 1;
+	}
+	plg_sdsFree(sdsNameTable);
+	return ret;
+}
+
 /*
 Because of the check mode, create and star are separated
 Users can adjust the number of cores according to the results. If they are not satisfied, they can
@@ -1089,6 +1161,9 @@ static void manage_InternalDestoryHandle(void* pvManage) {
 	plg_sdsFree(pManage->objName);
 	plg_sdsFree(pManage->luaLIBPath);
 	plg_dictRelease(pManage->libFun);
+	if (pManage->memoryArena) {
+		plg_MemArenaDestroy(pManage->memoryArena);
+	}
 	
 	free(pManage);
 }
@@ -1151,6 +1226,46 @@ void plg_MngSetMaxQueue(void* pvManage, unsigned int maxQueue) {
 	pManage->maxQueue = maxQueue;
 }
 
+void plg_MngSetGroupCount(void* pvManage, unsigned int groupCount) {
+	PManage pManage = pvManage;
+	pManage->groupCount = groupCount;
+}
+
+void plg_MngSetGroupInterval(void* pvManage, unsigned int groupInterval) {
+	PManage pManage = pvManage;
+	pManage->groupInterval = groupInterval;
+}
+
+void plg_MngSetPageArena(void* pvManage, unsigned int pageArena) {
+	PManage pManage = pvManage;
+	pManage->pageArena = pageArena;
+}
+
+void plg_MngSetPageHighWater(void* pvManage, unsigned int pageHighWater) {
+	PManage pManage = pvManage;
+	pManage->pageHighWater = pageHighWater;
+}
+
+void plg_MngSetLuaGCMode(void* pvManage, short luaGCMode) {
+	PManage pManage = pvManage;
+	pManage->luaGCMode = luaGCMode;
+}
+
+void plg_MngSetLuaGCPause(void* pvManage, int luaGCPause) {
+	PManage pManage = pvManage;
+	pManage->luaGCPause = luaGCPause;
+}
+
+void plg_MngSetLuaGCStepMul(void* pvManage, int luaGCStepMul) {
+	PManage pManage = pvManage;
+	pManage->luaGCStepMul = luaGCStepMul;
+}
+
+void plg_MngSetLuaGCIdleStep(void* pvManage, int luaGCIdleStep) {
+	PManage pManage = pvManage;
+	pManage->luaGCIdleStep = luaGCIdleStep;
+}
+
 void plg_MngSetStatCheckTime(void* pvManage, short checkTime) {
 	PManage pManage = pvManage;
 	pManage->checkTime = checkTime;
@@ -1185,6 +1300,15 @@ void* plg_MngCreateHandle(char* dbPath, short dbPahtLen) {
 	pManage->dictTableName = plg_dictCreate(&SdsDictType, NULL, DICT_MIDDLE);
 	
 	pManage->maxQueue = 0;
+	pManage->groupCount = 0;
+	pManage->groupInterval = 0;
+	pManage->pageArena = 0;
+	pManage->memoryArena = 0;
+	pManage->pageHighWater = 0;
+	pManage->luaGCMode = LGC_Default;
+	pManage->luaGCPause = 0;
+	pManage->luaGCStepMul = 0;
+	pManage->luaGCIdleStep = 0;
 	pManage->isOpenStat = 0;
 	pManage->checkTime = 5000;
 	pManage->order_tableName = plg_DictSetCreate(plg_DefaultSdsDictPtr(), DICT_MIDDLE, plg_DefaultSdsDictPtr(), DICT_MIDDLE);
@@ -1403,6 +1527,9 @@ char* plg_MngPrintAllStatusJson(void* pvManage) {
 	pJson_AddNumberToObject(root, "fileCount", pManage->fileCount);
 	pJson_AddNumberToObject(root, "jobDestroyCount", pManage->jobDestroyCount);
 	pJson_AddNumberToObject(root, "fileDestroyCount", pManage->fileDestroyCount);
+	if (pManage->memoryArena) {
+		pJson_AddNumberToObject(root, "pageArenaUsed", plg_MemArenaUsed(pManage->memoryArena));
+	}
 
 	char* ps = pJson_Print(root);
 	pJson_Delete(root);
@@ -20,29 +20,63 @@
 #include "plateform.h"
 #include <pthread.h>
 #include "pmemorylist.h"
-#include "plateform.h"
 #include "plocks.h"
 #include "pelog.h"
 #include "psds.h"
-#include "pdict.h"
 #include "ptimesys.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+/*
+Buffers are cached in magazines of _MAGAZINESIZE_.
+Each thread owns one magazine and pushes and pops it without a lock,
+a full or an empty magazine is swapped with the depot, which is the only place that locks.
+A handle without lock is used by one thread and its magazine is kept in the handle.
+*/
+#define _MAGAZINESIZE_ 16
+
+/*
+An arena is one mapping shared by the lists of a manager, its size is the limit of all of them.
+Buffers are carved in order and a freed buffer goes to the free list of its size.
+*/
+#define _ARENASIZES_ 8
+
+typedef struct _MemoryArena
+{
+	unsigned char* base;
+	size_t arenaSize;
+	size_t arenaUsed;
+	unsigned char isHuge;
+	unsigned int sizes[_ARENASIZES_];
+	void* free[_ARENASIZES_];
+	void* mutexLock;
+	sds objName;
+}*PMemoryArena, MemoryArena;
 
-typedef struct _MemoryListNode
+typedef struct _MemoryMagazine
 {
-	unsigned long long stamp;
-	void* next;
-}*PMemoryListNode, MemoryListNode;
+	struct _MemoryMagazine* next;
+	struct _MemoryMagazine* nextAll;
+	unsigned int length;
+	void* rounds[_MAGAZINESIZE_];
+}*PMemoryMagazine, MemoryMagazine;
 
 typedef struct _MemoryListHandle
 {
-	PMemoryListNode head;
-	dict* dictPop;
+	PMemoryMagazine full;
+	PMemoryMagazine empty;
+	PMemoryMagazine all;
+	PMemoryMagazine local;
+	unsigned int fullLength;
+	unsigned int minFull;
+	unsigned int highWater;
 	unsigned int sec;
 	unsigned int size;
-	unsigned int length;
-	unsigned int lastFree;
+	unsigned long long lastTrim;
 	unsigned char isLock;
-	unsigned int percent;
+	PMemoryArena arena;
+	pthread_key_t magazineKey;
 	void* mutexLock;
 	sds objName;
 }*PMemoryListHandle, MemoryListHandle;
@@ -50,20 +84,216 @@ typedef struct _MemoryListHandle
 void* plg_MemListCreate(unsigned int sec, unsigned int size, unsigned char isLock) {
 	PMemoryListHandle pMemoryListHandle = malloc(sizeof(MemoryListHandle));
 	pMemoryListHandle->sec = sec;
-	pMemoryListHandle->percent = 5;
 	pMemoryListHandle->size = size;
-	pMemoryListHandle->lastFree = 0;
 	pMemoryListHandle->isLock = isLock;
-	pMemoryListHandle->head = 0;
-	pMemoryListHandle->dictPop = plg_dictCreate(plg_DefaultPtrDictPtr(), NULL, DICT_MIDDLE);
-	pMemoryListHandle->length = 0;
+	pMemoryListHandle->full = 0;
+	pMemoryListHandle->empty = 0;
+	pMemoryListHandle->all = 0;
+	pMemoryListHandle->local = 0;
+	pMemoryListHandle->fullLength = 0;
+	pMemoryListHandle->minFull = 0;
+	pMemoryListHandle->highWater = 0;
+	pMemoryListHandle->lastTrim = plg_GetCurrentSec();
+	pMemoryListHandle->arena = 0;
 	if (pMemoryListHandle->isLock) {
 		pMemoryListHandle->mutexLock = plg_MutexCreateHandle(LockLevel_4);
+		pthread_key_create(&pMemoryListHandle->magazineKey, NULL);
 	}
 	pMemoryListHandle->objName = plg_sdsNew("MemoryList");
 	return pMemoryListHandle;
 }
 
+/*
+Keep at most highWater buffers in the full magazines of the depot, 0 means no limit.
+The limit is rounded up to whole magazines, so a small one still keeps one magazine.
+*/
+void plg_MemListSetHighWater(void* pvMemoryListHandle, unsigned int highWater) {
+
+	PMemoryListHandle pMemoryListHandle = pvMemoryListHandle;
+	pMemoryListHandle->highWater = highWater / _MAGAZINESIZE_ + (highWater % _MAGAZINESIZE_ != 0);
+}
+
+static PMemoryMagazine list_NewMagazine(PMemoryListHandle pMemoryListHandle) {
+
+	PMemoryMagazine pMemoryMagazine = malloc(sizeof(MemoryMagazine));
+	pMemoryMagazine->next = 0;
+	pMemoryMagazine->length = 0;
+	pMemoryMagazine->nextAll = pMemoryListHandle->all;
+	pMemoryListHandle->all = pMemoryMagazine;
+	return pMemoryMagazine;
+}
+
+/*
+Reserve arenaSize bytes in one mapping, backed by huge pages when the system has them.
+Explicit huge pages are tried first, then the mapping is advised for transparent huge pages.
+Returns 0 if the mapping fails and the lists keep malloc
+*/
+void* plg_MemArenaCreate(size_t arenaSize) {
+
+	//round to the huge page
+	arenaSize = (arenaSize + 2 * MB - 1) & ~((size_t)2 * MB - 1);
+	unsigned char isHuge = 0;
+
+#ifdef _WIN32
+	void* base = VirtualAlloc(NULL, arenaSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+	void* arena = MAP_FAILED;
+#ifdef MAP_HUGETLB
+	arena = mmap(NULL, arenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (arena != MAP_FAILED) {
+		isHuge = 1;
+	}
+#endif
+	if (arena == MAP_FAILED) {
+		arena = mmap(NULL, arenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+		if (arena != MAP_FAILED) {
+			madvise(arena, arenaSize, MADV_HUGEPAGE);
+		}
+#endif
+	}
+	void* base = arena == MAP_FAILED ? 0 : arena;
+#endif
+
+	if (base == 0) {
+		elog(log_warn, "plg_MemArenaCreate.map %llu bytes!", (unsigned long long)arenaSize);
+		return 0;
+	}
+
+	PMemoryArena pMemoryArena = malloc(sizeof(MemoryArena));
+	pMemoryArena->base = base;
+	pMemoryArena->arenaSize = arenaSize;
+	pMemoryArena->arenaUsed = 0;
+	pMemoryArena->isHuge = isHuge;
+	memset(pMemoryArena->sizes, 0, sizeof(pMemoryArena->sizes));
+	memset(pMemoryArena->free, 0, sizeof(pMemoryArena->free));
+	pMemoryArena->mutexLock = plg_MutexCreateHandle(LockLevel_4);
+	pMemoryArena->objName = plg_sdsNew("MemoryArena");
+	elog(log_details, "plg_MemArenaCreate %llu bytes huge:%i", (unsigned long long)arenaSize, isHuge);
+	return pMemoryArena;
+}
+
+/*
+After the lists that use it are destroyed
+*/
+void plg_MemArenaDestroy(void* pvMemoryArena) {
+
+	PMemoryArena pMemoryArena = pvMemoryArena;
+#ifdef _WIN32
+	VirtualFree(pMemoryArena->base, 0, MEM_RELEASE);
+#else
+	munmap(pMemoryArena->base, pMemoryArena->arenaSize);
+#endif
+	plg_MutexDestroyHandle(pMemoryArena->mutexLock);
+	plg_sdsFree(pMemoryArena->objName);
+	free(pMemoryArena);
+}
+
+/*
+Bytes of the arena carved into buffers so far, the memory taken by the arena is exact
+*/
+size_t plg_MemArenaUsed(void* pvMemoryArena) {
+
+	PMemoryArena pMemoryArena = pvMemoryArena;
+	MutexLock(pMemoryArena->mutexLock, pMemoryArena->objName);
+	size_t arenaUsed = pMemoryArena->arenaUsed;
+	MutexUnlock(pMemoryArena->mutexLock, pMemoryArena->objName);
+	return arenaUsed;
+}
+
+/*
+The free list of the size, a size that finds no slot has none and its buffers are not taken back
+*/
+static void** arena_FreeList(PMemoryArena pMemoryArena, unsigned int size) {
+
+	for (int l = 0; l < _ARENASIZES_; l++) {
+		if (pMemoryArena->sizes[l] == size) {
+			return &pMemoryArena->free[l];
+		} else if (pMemoryArena->sizes[l] == 0) {
+			pMemoryArena->sizes[l] = size;
+			return &pMemoryArena->free[l];
+		}
+	}
+	return 0;
+}
+
+static void* arena_Alloc(PMemoryArena pMemoryArena, unsigned int size) {
+
+	MutexLock(pMemoryArena->mutexLock, pMemoryArena->objName);
+
+	void* ptr = 0;
+	void** freeList = arena_FreeList(pMemoryArena, size);
+	if (freeList && *freeList) {
+		ptr = *freeList;
+		*freeList = *(void**)ptr;
+	} else if (freeList && pMemoryArena->arenaSize - pMemoryArena->arenaUsed >= size) {
+		ptr = pMemoryArena->base + pMemoryArena->arenaUsed;
+		pMemoryArena->arenaUsed += size;
+	}
+
+	MutexUnlock(pMemoryArena->mutexLock, pMemoryArena->objName);
+	return ptr;
+}
+
+/*
+Buffers of the arena go back to the free list of their size, the others to the system.
+*/
+static void list_FreeRounds(PMemoryListHandle pMemoryListHandle, PMemoryMagazine pMemoryMagazine) {
+
+	PMemoryArena pMemoryArena = pMemoryListHandle->arena;
+	if (pMemoryArena) {
+		MutexLock(pMemoryArena->mutexLock, pMemoryArena->objName);
+	}
+
+	for (unsigned int l = 0; l < pMemoryMagazine->length; l++) {
+		unsigned char* ptr = pMemoryMagazine->rounds[l];
+		if (pMemoryArena && ptr >= pMemoryArena->base && ptr < pMemoryArena->base + pMemoryArena->arenaSize) {
+			void** freeList = arena_FreeList(pMemoryArena, pMemoryListHandle->size);
+			*(void**)ptr = *freeList;
+			*freeList = ptr;
+		} else {
+			free(ptr);
+		}
+	}
+	pMemoryMagazine->length = 0;
+
+	if (pMemoryArena) {
+		MutexUnlock(pMemoryArena->mutexLock, pMemoryArena->objName);
+	}
+}
+
+/*
+A buffer that is in no magazine, from the arena while it has room, else from the system
+*/
+static void* list_Alloc(PMemoryListHandle pMemoryListHandle) {
+
+	void* ptr = 0;
+	if (pMemoryListHandle->arena) {
+		ptr = arena_Alloc(pMemoryListHandle->arena, pMemoryListHandle->size);
+	}
+
+	if (ptr == 0) {
+		ptr = malloc(pMemoryListHandle->size);
+	}
+	return ptr;
+}
+
+/*
+Take the buffers from the arena shared with other lists.
+Only a list without lock, the lock of the arena is at the level of the depot.
+Must be called before the first pop, returns 0 if the list has buffers already
+*/
+unsigned int plg_MemListSetArena(void* pvMemoryListHandle, void* pvMemoryArena) {
+
+	PMemoryListHandle pMemoryListHandle = pvMemoryListHandle;
+	if (pMemoryListHandle->isLock || pMemoryListHandle->arena || pMemoryListHandle->all) {
+		return 0;
+	}
+
+	pMemoryListHandle->arena = pvMemoryArena;
+	return 1;
+}
+
 /*
 Messages that are not processed in the queue will be discarded, including pages that are not saved.
 If the program exits abnormally, the data will be lost.
@@ -73,103 +303,159 @@ void plg_MemListDestory(void* pvMemoryListHandle) {
 	PMemoryListHandle pMemoryListHandle = pvMemoryListHandle;
 	plg_sdsFree(pMemoryListHandle->objName);
 	if (pMemoryListHandle->isLock) {
+		pthread_key_delete(pMemoryListHandle->magazineKey);
 		plg_MutexDestroyHandle(pMemoryListHandle->mutexLock);
 	}
 
-	PMemoryListNode node = pMemoryListHandle->head;
-	do {
-		if (node == 0) {
-			break;
-		}
-		PMemoryListNode next = node->next;
-		free(node);
-		node = next;
-	} while (1);
-
-	plg_dictRelease(pMemoryListHandle->dictPop);
+	PMemoryMagazine pMemoryMagazine = pMemoryListHandle->all;
+	while (pMemoryMagazine) {
+		PMemoryMagazine next = pMemoryMagazine->nextAll;
+		list_FreeRounds(pMemoryListHandle, pMemoryMagazine);
+		free(pMemoryMagazine);
+		pMemoryMagazine = next;
+	}
 	free(pMemoryListHandle);
 }
 
-void plg_MemListPush(void* pvMemoryListHandle, void* ptr) {
+/*
+The full magazines that stayed in the depot for a whole interval were not needed,
+they are freed at the end of the interval.
+*/
+static void list_Trim(PMemoryListHandle pMemoryListHandle) {
+
+	unsigned long long stamp = plg_GetCurrentSec();
+	if (stamp - pMemoryListHandle->lastTrim < pMemoryListHandle->sec) {
+		return;
+	}
+
+	pMemoryListHandle->lastTrim = stamp;
+	for (unsigned int l = 0; l < pMemoryListHandle->minFull && pMemoryListHandle->full; l++) {
+		PMemoryMagazine pMemoryMagazine = pMemoryListHandle->full;
+		pMemoryListHandle->full = pMemoryMagazine->next;
+		pMemoryListHandle->fullLength -= 1;
+		list_FreeRounds(pMemoryListHandle, pMemoryMagazine);
+		pMemoryMagazine->next = pMemoryListHandle->empty;
+		pMemoryListHandle->empty = pMemoryMagazine;
+	}
+	pMemoryListHandle->minFull = pMemoryListHandle->fullLength;
+}
+
+/*
+Give a full magazine to the depot and take an empty one.
+Over the high water the buffers are freed instead.
+*/
+static PMemoryMagazine list_DepotPush(PMemoryListHandle pMemoryListHandle, PMemoryMagazine pMemoryMagazine) {
 
-	PMemoryListHandle pMemoryListHandle = pvMemoryListHandle;
 	if (pMemoryListHandle->isLock) {
 		MutexLock(pMemoryListHandle->mutexLock, pMemoryListHandle->objName);
 	}
-	unsigned long long stamp = plg_GetCurrentSec();
 
-	//add to hesdlist
-	PMemoryListNode pMemoryListNode = (PMemoryListNode)((char*)ptr - sizeof(MemoryListNode));
-	plg_assert(plg_dictFind(pMemoryListHandle->dictPop, pMemoryListNode));
-
-	pMemoryListNode->stamp = stamp;
-	pMemoryListNode->next = pMemoryListHandle->head;
-	pMemoryListHandle->head = pMemoryListNode;
-	pMemoryListHandle->length += 1;
-	plg_dictDelete(pMemoryListHandle->dictPop, pMemoryListNode);
-
-	//check time for del
-	if ((stamp - pMemoryListHandle->lastFree) > pMemoryListHandle->sec) {
-		pMemoryListHandle->lastFree = stamp;
-		unsigned int freeMemCount = pMemoryListHandle->length * pMemoryListHandle->percent / 100;
-		unsigned int limite = pMemoryListHandle->sec * 3;
-		unsigned int count = 0;
-		PMemoryListNode node = pMemoryListHandle->head;
-		PMemoryListNode prev = 0;
-		do {
-			if (node == 0) {
-				break;
-			}
-			if (stamp - node->stamp < limite) {
-				prev = node;
-				node = node->next;
-				continue;
-			}
-
-			if (prev == 0) {
-				pMemoryListHandle->head = node->next;
-				free(node);
-				node = pMemoryListHandle->head;
-			} else {
-				prev->next = node->next;
-				free(node);
-				node = prev->next;
-			}
-
-			pMemoryListHandle->length -= 1;
-			if (++count > freeMemCount) {
-				break;
-			}
-		} while (1);
+	if (pMemoryListHandle->highWater && pMemoryListHandle->fullLength >= pMemoryListHandle->highWater) {
+		list_FreeRounds(pMemoryListHandle, pMemoryMagazine);
+	} else {
+		pMemoryMagazine->next = pMemoryListHandle->full;
+		pMemoryListHandle->full = pMemoryMagazine;
+		pMemoryListHandle->fullLength += 1;
+
+		if (pMemoryListHandle->empty) {
+			pMemoryMagazine = pMemoryListHandle->empty;
+			pMemoryListHandle->empty = pMemoryMagazine->next;
+		} else {
+			pMemoryMagazine = list_NewMagazine(pMemoryListHandle);
+		}
 	}
+	list_Trim(pMemoryListHandle);
 
 	if (pMemoryListHandle->isLock) {
 		MutexUnlock(pMemoryListHandle->mutexLock, pMemoryListHandle->objName);
 	}
+	return pMemoryMagazine;
 }
 
-void* plg_MemListPop(void* pvMemoryListHandle) {
+/*
+Give an empty magazine to the depot and take a full one,
+if the depot has no full magazine the empty one is kept.
+*/
+static PMemoryMagazine list_DepotPop(PMemoryListHandle pMemoryListHandle, PMemoryMagazine pMemoryMagazine) {
 
-	PMemoryListHandle pMemoryListHandle = pvMemoryListHandle;
 	if (pMemoryListHandle->isLock) {
 		MutexLock(pMemoryListHandle->mutexLock, pMemoryListHandle->objName);
 	}
 
-	PMemoryListNode pMemoryListNode;
-	if (pMemoryListHandle->length > 0) {
-		pMemoryListNode = pMemoryListHandle->head;
-		pMemoryListHandle->head = pMemoryListHandle->head->next;
-		pMemoryListHandle->length -= 1;
-	} else {
-		pMemoryListNode = malloc(pMemoryListHandle->size + sizeof(MemoryListNode));	
-		pMemoryListNode->next = 0;
+	if (pMemoryListHandle->full) {
+		pMemoryMagazine->next = pMemoryListHandle->empty;
+		pMemoryListHandle->empty = pMemoryMagazine;
+
+		pMemoryMagazine = pMemoryListHandle->full;
+		pMemoryListHandle->full = pMemoryMagazine->next;
+		pMemoryListHandle->fullLength -= 1;
+		if (pMemoryListHandle->fullLength < pMemoryListHandle->minFull) {
+			pMemoryListHandle->minFull = pMemoryListHandle->fullLength;
+		}
 	}
-	plg_dictAdd(pMemoryListHandle->dictPop, pMemoryListNode, NULL);
 
 	if (pMemoryListHandle->isLock) {
 		MutexUnlock(pMemoryListHandle->mutexLock, pMemoryListHandle->objName);
 	}
-	
-	return ((char*)pMemoryListNode + sizeof(MemoryListNode));
+	return pMemoryMagazine;
+}
+
+/*
+The magazine of the calling thread, created and registered in the depot on first use
+*/
+static PMemoryMagazine list_Magazine(PMemoryListHandle pMemoryListHandle) {
+
+	if (!pMemoryListHandle->isLock) {
+		if (pMemoryListHandle->local == 0) {
+			pMemoryListHandle->local = list_NewMagazine(pMemoryListHandle);
+		}
+		return pMemoryListHandle->local;
+	}
+
+	PMemoryMagazine pMemoryMagazine = pthread_getspecific(pMemoryListHandle->magazineKey);
+	if (pMemoryMagazine == 0) {
+		MutexLock(pMemoryListHandle->mutexLock, pMemoryListHandle->objName);
+		pMemoryMagazine = list_NewMagazine(pMemoryListHandle);
+		MutexUnlock(pMemoryListHandle->mutexLock, pMemoryListHandle->objName);
+		pthread_setspecific(pMemoryListHandle->magazineKey, pMemoryMagazine);
+	}
+	return pMemoryMagazine;
+}
+
+static void list_SetMagazine(PMemoryListHandle pMemoryListHandle, PMemoryMagazine pMemoryMagazine) {
+
+	if (pMemoryListHandle->isLock) {
+		pthread_setspecific(pMemoryListHandle->magazineKey, pMemoryMagazine);
+	} else {
+		pMemoryListHandle->local = pMemoryMagazine;
+	}
+}
+
+void plg_MemListPush(void* pvMemoryListHandle, void* ptr) {
+
+	PMemoryListHandle pMemoryListHandle = pvMemoryListHandle;
+	PMemoryMagazine pMemoryMagazine = list_Magazine(pMemoryListHandle);
+
+	if (pMemoryMagazine->length == _MAGAZINESIZE_) {
+		pMemoryMagazine = list_DepotPush(pMemoryListHandle, pMemoryMagazine);
+		list_SetMagazine(pMemoryListHandle, pMemoryMagazine);
+	}
+
+	pMemoryMagazine->rounds[pMemoryMagazine->length++] = ptr;
 }
 
+void* plg_MemListPop(void* pvMemoryListHandle) {
+
+	PMemoryListHandle pMemoryListHandle = pvMemoryListHandle;
+	PMemoryMagazine pMemoryMagazine = list_Magazine(pMemoryListHandle);
+
+	if (pMemoryMagazine->length == 0) {
+		pMemoryMagazine = list_DepotPop(pMemoryListHandle, pMemoryMagazine);
+		list_SetMagazine(pMemoryListHandle, pMemoryMagazine);
+		if (pMemoryMagazine->length == 0) {
+			return list_Alloc(pMemoryListHandle);
+		}
+	}
+
+	return pMemoryMagazine->rounds[--pMemoryMagazine->length];
+}
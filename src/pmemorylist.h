@@ -24,5 +24,10 @@ void* plg_MemListCreate(unsigned int sec, unsigned int size, unsigned char isLoc
 void plg_MemListDestory(void* pMemoryListHandle);
 void plg_MemListPush(void* pMemoryListHandle, void* ptr);
 void* plg_MemListPop(void* pMemoryListHandle);
+void plg_MemListSetHighWater(void* pMemoryListHandle, unsigned int highWater);
+unsigned int plg_MemListSetArena(void* pMemoryListHandle, void* pMemoryArena);
+void* plg_MemArenaCreate(size_t arenaSize);
+void plg_MemArenaDestroy(void* pMemoryArena);
+size_t plg_MemArenaUsed(void* pMemoryArena);
 
 #endif
\ No newline at end of file
@@ -19,139 +19,252 @@
 
 #include "plateform.h"
 #include "pmemorypool.h"
-#include "pbitarray.h"
 
+/*
+Every chunk is aligned to its own size, which is a power of two,
+so the chunk of a pointer is found by masking the low bits of its address.
+Free slots are linked through their first bytes and chunks with free slots are linked in the partial list,
+both malloc and free are O(1).
+*/
 typedef struct _MemoryPoolHead
 {
-	void* next;
+	struct _MemoryPoolHead* next;
+	struct _MemoryPoolHead* prev;
+	struct _MemoryPoolHead* nextPartial;
+	struct _MemoryPoolHead* prevPartial;
+	void* freeSlot;
 	unsigned int length;
-	unsigned char bit[];
+	unsigned int bump;
 }*PMemoryPoolHead, MemoryPoolHead;
 
 typedef struct _MemoryPoolHandle
 {
 	PMemoryPoolHead head;
+	PMemoryPoolHead partial;
+	PMemoryPoolHead spare;
 	unsigned int size;
 	unsigned int count;
+	size_t chunkSize;
+	unsigned int headLength;
 }*PMemoryPoolHandle, MemoryPoolHandle;
 
+#define POOL_ALIGN sizeof(void*)
+#define POOL_ROUND(S) (((S) + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1))
+
+static void* pool_AlignedMalloc(size_t size) {
+
+#ifdef _WIN32
+	return _aligned_malloc(size, size);
+#else
+	void* ptr;
+	if (posix_memalign(&ptr, size, size) != 0) {
+		return NULL;
+	}
+	return ptr;
+#endif
+}
+
+static void pool_AlignedFree(void* ptr) {
+
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
 void* plg_MemPoolCreate(unsigned int size, unsigned int count) {
+
 	PMemoryPoolHandle pMemoryPoolHandle = (PMemoryPoolHandle)calloc(1, sizeof(MemoryPoolHandle));
-	pMemoryPoolHandle->size = size;
-	pMemoryPoolHandle->count = count;
+	pMemoryPoolHandle->size = POOL_ROUND(size < sizeof(void*) ? sizeof(void*) : size);
+	pMemoryPoolHandle->headLength = POOL_ROUND(sizeof(MemoryPoolHead));
+
+	//Round the chunk up to a power of two and fill the rounding with slots
+	size_t need = pMemoryPoolHandle->headLength + (size_t)pMemoryPoolHandle->size * (count ? count : 1);
+	pMemoryPoolHandle->chunkSize = 4 * KB;
+	while (pMemoryPoolHandle->chunkSize < need) {
+		pMemoryPoolHandle->chunkSize <<= 1;
+	}
+	pMemoryPoolHandle->count = (unsigned int)((pMemoryPoolHandle->chunkSize - pMemoryPoolHandle->headLength) / pMemoryPoolHandle->size);
 	return pMemoryPoolHandle;
 }
 
 void plg_MemPoolDestroy(void* pvMemoryPoolHandle) {
 
 	PMemoryPoolHandle pMemoryPoolHandle = pvMemoryPoolHandle;
-	PMemoryPoolHead pMemoryPoolHead = (PMemoryPoolHead)pMemoryPoolHandle->head;
-	do {
-		if (pMemoryPoolHead == 0) {
-			break;
-		}
-		void* next = pMemoryPoolHead->next;
-		free(pMemoryPoolHead);
-		pMemoryPoolHead = (PMemoryPoolHead)next;
-	} while (1);
+	PMemoryPoolHead pMemoryPoolHead = pMemoryPoolHandle->head;
+	while (pMemoryPoolHead) {
+		PMemoryPoolHead next = pMemoryPoolHead->next;
+		pool_AlignedFree(pMemoryPoolHead);
+		pMemoryPoolHead = next;
+	}
+
+	if (pMemoryPoolHandle->spare) {
+		pool_AlignedFree(pMemoryPoolHandle->spare);
+	}
 	free(pMemoryPoolHandle);
 }
 
-void* plg_MemPoolMalloc(void* pvMemoryPoolHandle) {
+static void pool_PartialAdd(PMemoryPoolHandle pMemoryPoolHandle, PMemoryPoolHead pMemoryPoolHead) {
 
-	//find
-	PMemoryPoolHandle pMemoryPoolHandle = pvMemoryPoolHandle;
-	PMemoryPoolHead pMemoryPoolHead = (PMemoryPoolHead)pMemoryPoolHandle->head;
-	unsigned int headLength = sizeof(MemoryPoolHead) + pMemoryPoolHandle->count / 8 + (pMemoryPoolHandle->count % 8 ? 1 : 0);
-	unsigned int bitSize = pMemoryPoolHandle->count / 8 + (pMemoryPoolHandle->count % 8 ? 1 : 0);
-	unsigned int bitLength;
-	if (pMemoryPoolHead != 0) {
-		bitLength = pMemoryPoolHead->length / 8 + (pMemoryPoolHead->length % 8 ? 1 : 0);
+	pMemoryPoolHead->prevPartial = NULL;
+	pMemoryPoolHead->nextPartial = pMemoryPoolHandle->partial;
+	if (pMemoryPoolHandle->partial) {
+		pMemoryPoolHandle->partial->prevPartial = pMemoryPoolHead;
 	}
+	pMemoryPoolHandle->partial = pMemoryPoolHead;
+}
 
-	do {
-		if (pMemoryPoolHead == 0) {
-			break;
-		}
+static void pool_PartialDel(PMemoryPoolHandle pMemoryPoolHandle, PMemoryPoolHead pMemoryPoolHead) {
 
-		if (pMemoryPoolHandle->count - pMemoryPoolHead->length > 0) {
-			for (unsigned int i = bitLength; i < bitSize; i++) {
-				if (pMemoryPoolHead->bit[i] != UCHAR_MAX) {
-					for (unsigned int l = i * 8; l < (i + 1) * 8; l++) {
-						if (l < pMemoryPoolHandle->count && plg_BitArrayIsIn(pMemoryPoolHead->bit, l) == 0) {
-							void* cur = (unsigned char*)pMemoryPoolHead + headLength;
-							plg_BitArrayAdd(pMemoryPoolHead->bit, l);
-							pMemoryPoolHead->length += 1;
-							return (unsigned char*)cur + pMemoryPoolHandle->size * l;
-						}
-					}
-				}
-			}
+	if (pMemoryPoolHead->prevPartial) {
+		pMemoryPoolHead->prevPartial->nextPartial = pMemoryPoolHead->nextPartial;
+	} else {
+		pMemoryPoolHandle->partial = pMemoryPoolHead->nextPartial;
+	}
 
-			for (unsigned int i = 0; i < bitLength; i++) {
-				if (pMemoryPoolHead->bit[i] != UCHAR_MAX) {
-					for (unsigned int l = i * 8; l < (i + 1) * 8; l++) {
-						if (l < pMemoryPoolHandle->count && plg_BitArrayIsIn(pMemoryPoolHead->bit, l) == 0) {
-							void* cur = (unsigned char*)pMemoryPoolHead + headLength;
-							plg_BitArrayAdd(pMemoryPoolHead->bit, l);
-							pMemoryPoolHead->length += 1;
-							return (unsigned char*)cur + pMemoryPoolHandle->size * l;
-						}
-					}
-				}
+	if (pMemoryPoolHead->nextPartial) {
+		pMemoryPoolHead->nextPartial->prevPartial = pMemoryPoolHead->prevPartial;
+	}
+	pMemoryPoolHead->nextPartial = pMemoryPoolHead->prevPartial = NULL;
+}
+
+void* plg_MemPoolMalloc(void* pvMemoryPoolHandle) {
+
+	PMemoryPoolHandle pMemoryPoolHandle = pvMemoryPoolHandle;
+	PMemoryPoolHead pMemoryPoolHead = pMemoryPoolHandle->partial;
+
+	//create, reuse the spare chunk kept by free first
+	if (pMemoryPoolHead == NULL) {
+		if (pMemoryPoolHandle->spare) {
+			pMemoryPoolHead = pMemoryPoolHandle->spare;
+			pMemoryPoolHandle->spare = NULL;
+		} else {
+			pMemoryPoolHead = pool_AlignedMalloc(pMemoryPoolHandle->chunkSize);
+			if (pMemoryPoolHead == NULL) {
+				return NULL;
 			}
 		}
 
-		pMemoryPoolHead = (PMemoryPoolHead)pMemoryPoolHead->next;
-	} while (1);
+		pMemoryPoolHead->freeSlot = NULL;
+		pMemoryPoolHead->length = 0;
+		pMemoryPoolHead->bump = 0;
+		pMemoryPoolHead->prev = NULL;
+		pMemoryPoolHead->next = pMemoryPoolHandle->head;
+		if (pMemoryPoolHandle->head) {
+			pMemoryPoolHandle->head->prev = pMemoryPoolHead;
+		}
+		pMemoryPoolHandle->head = pMemoryPoolHead;
+		pool_PartialAdd(pMemoryPoolHandle, pMemoryPoolHead);
+	}
 
-	//create
-	unsigned int pageLength = headLength + pMemoryPoolHandle->count * pMemoryPoolHandle->size;
-	pMemoryPoolHead = malloc(pageLength);
-	PMemoryPoolHead ptrHead = pMemoryPoolHandle->head;
-	pMemoryPoolHead->next = ptrHead;
-	pMemoryPoolHead->length = 0;
-	pMemoryPoolHandle->head = pMemoryPoolHead;
+	//take a freed slot, or the next slot never used
+	void* ptr;
+	if (pMemoryPoolHead->freeSlot) {
+		ptr = pMemoryPoolHead->freeSlot;
+		pMemoryPoolHead->freeSlot = *(void**)ptr;
+	} else {
+		ptr = (unsigned char*)pMemoryPoolHead + pMemoryPoolHandle->headLength + (size_t)pMemoryPoolHandle->size * pMemoryPoolHead->bump;
+		pMemoryPoolHead->bump += 1;
+	}
 
-	void* ptr = (unsigned char*)pMemoryPoolHead + headLength;
-	plg_BitArrayAdd(pMemoryPoolHead->bit, 0);
 	pMemoryPoolHead->length += 1;
-	return (unsigned char*)ptr;
+	if (pMemoryPoolHead->length == pMemoryPoolHandle->count) {
+		pool_PartialDel(pMemoryPoolHandle, pMemoryPoolHead);
+	}
+	return ptr;
 }
 
 void plg_MemPoolFree(void* pvMemoryPoolHandle, void* ptr) {
 
-	//find
 	PMemoryPoolHandle pMemoryPoolHandle = pvMemoryPoolHandle;
-	PMemoryPoolHead pMemoryPoolHead = (PMemoryPoolHead)pMemoryPoolHandle->head;
-	unsigned int headLength = sizeof(MemoryPoolHead) + pMemoryPoolHandle->count / 8 + (pMemoryPoolHandle->count % 8 ? 1 : 0);
-	unsigned int pageLength = headLength + pMemoryPoolHandle->size * pMemoryPoolHandle->count;
-	PMemoryPoolHead ptrPrev = 0;
-	do {
-		if (pMemoryPoolHead == 0) {
-			break;
-		}
+	PMemoryPoolHead pMemoryPoolHead = (PMemoryPoolHead)((size_t)ptr & ~(pMemoryPoolHandle->chunkSize - 1));
+	plg_assert(ptr >= (void*)((unsigned char*)pMemoryPoolHead + pMemoryPoolHandle->headLength));
 
-		void* pageEnd = (unsigned char*)pMemoryPoolHead + pageLength;
-		if (ptr >= (void*)pMemoryPoolHead && ptr < pageEnd) {
-			unsigned int cur = ((unsigned char*)ptr - (unsigned char*)pMemoryPoolHead - headLength) / pMemoryPoolHandle->size;
-			plg_BitArrayClear(pMemoryPoolHead->bit, cur);
-			pMemoryPoolHead->length -= 1;
-			break;
-		}
-		ptrPrev = pMemoryPoolHead;
-		pMemoryPoolHead = (PMemoryPoolHead)pMemoryPoolHead->next;
-	} while (1);
-
-	if (pMemoryPoolHead) {
-		if (pMemoryPoolHead->length == 0) {
-			if (ptrPrev != 0) {
-				ptrPrev->next = pMemoryPoolHead->next;
-			} else {
-				pMemoryPoolHandle->head = pMemoryPoolHead->next;
-			}
+	if (pMemoryPoolHead->length == pMemoryPoolHandle->count) {
+		pool_PartialAdd(pMemoryPoolHandle, pMemoryPoolHead);
+	}
 
-			free(pMemoryPoolHead);
-		}
+	*(void**)ptr = pMemoryPoolHead->freeSlot;
+	pMemoryPoolHead->freeSlot = ptr;
+	pMemoryPoolHead->length -= 1;
+	if (pMemoryPoolHead->length != 0) {
+		return;
+	}
+
+	//An empty chunk leaves the pool. While other chunks are in use one is kept,
+	//so that a list swinging around a boundary does not thrash, an empty pool keeps none
+	pool_PartialDel(pMemoryPoolHandle, pMemoryPoolHead);
+	if (pMemoryPoolHead->prev) {
+		pMemoryPoolHead->prev->next = pMemoryPoolHead->next;
+	} else {
+		pMemoryPoolHandle->head = pMemoryPoolHead->next;
+	}
+	if (pMemoryPoolHead->next) {
+		pMemoryPoolHead->next->prev = pMemoryPoolHead->prev;
+	}
+
+	if (pMemoryPoolHandle->head == NULL && pMemoryPoolHandle->spare) {
+		pool_AlignedFree(pMemoryPoolHandle->spare);
+		pMemoryPoolHandle->spare = NULL;
+	}
+
+	if (pMemoryPoolHandle->spare == NULL && pMemoryPoolHandle->head) {
+		pMemoryPoolHandle->spare = pMemoryPoolHead;
+	} else {
+		pool_AlignedFree(pMemoryPoolHead);
+	}
+}
+
+/* ------------------------------- Benchmark ---------------------------------*/
+
+#ifdef MEMPOOL_BENCHMARK_MAIN
+
+#include "ptimesys.h"
+
+#define start_benchmark() start = plg_GetCurrentMilli()
+#define end_benchmark(msg) do { \
+	elapsed = plg_GetCurrentMilli() - start; \
+	printf(msg ": %d items in %lld ms\n", count, elapsed); \
+} while(0);
+
+/* mempool-benchmark [count] */
+int main(int argc, char **argv) {
+
+	long long start, elapsed;
+	int count = 5000000;
+	if (argc == 2) {
+		count = strtol(argv[1], NULL, 10);
 	}
-}
\ No newline at end of file
+
+	void** ptr = malloc(sizeof(void*) * count);
+	void* pool = plg_MemPoolCreate(24, 10000);
+
+	start_benchmark();
+	for (int j = 0; j < count; j++) ptr[j] = plg_MemPoolMalloc(pool);
+	end_benchmark("Pool malloc");
+
+	start_benchmark();
+	for (int j = 0; j < count; j++) plg_MemPoolFree(pool, ptr[j]);
+	end_benchmark("Pool free in order");
+
+	for (int j = 0; j < count; j++) ptr[j] = plg_MemPoolMalloc(pool);
+	for (int j = count - 1; j > 0; j--) { int r = rand() % (j + 1); void* t = ptr[j]; ptr[j] = ptr[r]; ptr[r] = t; }
+	start_benchmark();
+	for (int j = 0; j < count; j++) plg_MemPoolFree(pool, ptr[j]);
+	end_benchmark("Pool free at random");
+	plg_MemPoolDestroy(pool);
+
+	start_benchmark();
+	for (int j = 0; j < count; j++) ptr[j] = malloc(24);
+	end_benchmark("System malloc");
+
+	for (int j = count - 1; j > 0; j--) { int r = rand() % (j + 1); void* t = ptr[j]; ptr[j] = ptr[r]; ptr[r] = t; }
+	start_benchmark();
+	for (int j = 0; j < count; j++) free(ptr[j]);
+	end_benchmark("System free at random");
+
+	free(ptr);
+	return 0;
+}
+#endif
@@ -40,6 +40,8 @@ static void EnumTableJson(pJSON * root, void* pManage, char* order)
 				plg_MngSetNoSave(pManage, root->string, strlen(root->string), item->valueint);
 			} else if (strcmp(item->string, "noshare") == 0) {
 				plg_MngSetNoShare(pManage, root->string, strlen(root->string), item->valueint);
+			} else if (strcmp(item->string, "pagesize") == 0) {
+				plg_MngSetPageSize(pManage, root->string, strlen(root->string), item->valueint);
 			} else {
 				elog(log_error, "Unable to process Tags %s.", item->string);
 			}
@@ -180,6 +182,28 @@ static void EnumJson(pJSON * root, void* pManage, int isInclude)
 					plg_MngSetStatCheckTime(pManage, item->valueint);
 				} else 	if (strcmp(item->string, "maxQueue") == 0) {
 					plg_MngSetMaxQueue(pManage, item->valueint);
+				} else 	if (strcmp(item->string, "groupCount") == 0) {
+					plg_MngSetGroupCount(pManage, item->valueint);
+				} else 	if (strcmp(item->string, "groupInterval") == 0) {
+					plg_MngSetGroupInterval(pManage, item->valueint);
+				} else 	if (strcmp(item->string, "pageArena") == 0) {
+					plg_MngSetPageArena(pManage, item->valueint);
+				} else 	if (strcmp(item->string, "pageHighWater") == 0) {
+					plg_MngSetPageHighWater(pManage, item->valueint);
+				} else 	if (strcmp(item->string, "luaGCMode") == 0) {
+					if (item->valuestring && strcmp(item->valuestring, "generational") == 0) {
+						plg_MngSetLuaGCMode(pManage, LGC_Generational);
+					} else if (item->valuestring && strcmp(item->valuestring, "incremental") == 0) {
+						plg_MngSetLuaGCMode(pManage, LGC_Incremental);
+					} else {
+						elog(log_warn, "luaGCMode must be 'incremental' or 'generational'");
+					}
+				} else 	if (strcmp(item->string, "luaGCPause") == 0) {
+					plg_MngSetLuaGCPause(pManage, item->valueint);
+				} else 	if (strcmp(item->string, "luaGCStepMul") == 0) {
+					plg_MngSetLuaGCStepMul(pManage, item->valueint);
+				} else 	if (strcmp(item->string, "luaGCIdleStep") == 0) {
+					plg_MngSetLuaGCIdleStep(pManage, item->valueint);
 				} else 	if (strcmp(item->string, "logOutput") == 0) {
 
 				} else 	if (strcmp(item->string, "logLevel") == 0) {
@@ -33,14 +33,25 @@
 #include "pjson.h"
 #include "pbase64.h"
 #include "prandomlevel.h"
+#include "pdict.h"
 #include "pelagia.h"
 
+//Size classes of the free space index double from _FREESPACEMIN_ bytes, each keeps up to _FREESPACESLOT_ pages
+#define _FREESPACECLASS_ 8
+#define _FREESPACESLOT_ 16
+#define _FREESPACEMIN_ 64
+
 /*
 PTableInFile pTableInFile: disk table
 void* pageOperateHandle:Leader
 unsigned int pageSize: disk page size
 sds nameaTable: for pTableInFile
 unsigned int hitStamp: for pTableInFile
+dict* setHead: set key to resolved nested TableInFile, kept until the transaction writes it back
+short isSetHeadCache: the set operations may use setHead
+unsigned int compactPage: page being emptied by compaction, no key is added to it
+unsigned int compactTarget: page that takes the keys of compactPage first
+freeSpace: pages of the table by size class of their free space, a hint for placing new keys. Pages of sets are not kept
 */
 typedef struct _TableHandle
 {
@@ -50,6 +61,11 @@ typedef struct _TableHandle
 	sds nameaTable;
 	unsigned long long hitStamp;
 	PTableHandleCallBack pTableHandleCallBack;
+	dict* setHead;
+	short isSetHeadCache;
+	unsigned int compactPage;
+	unsigned int compactTarget;
+	unsigned int freeSpace[_FREESPACECLASS_][_FREESPACESLOT_];
 }*PTableHandle, TableHandle;
 
 typedef struct _SkipListPoint
@@ -75,11 +91,19 @@ void* plg_TableCreateHandle(void* pTableInFile, void* pageOperateHandle, unsigne
 	pTableHandle->nameaTable = nameaTable;
 	pTableHandle->pTableInFile = pTableInFile;
 	pTableHandle->pTableHandleCallBack = pTableHandleCallBack;
+	pTableHandle->setHead = NULL;
+	pTableHandle->isSetHeadCache = 0;
+	pTableHandle->compactPage = 0;
+	pTableHandle->compactTarget = 0;
+	memset(pTableHandle->freeSpace, 0, sizeof(pTableHandle->freeSpace));
 	return pTableHandle;
 }
 
 void plg_TableDestroyHandle(void* pvTableHandle) {
 	PTableHandle pTableHandle = pvTableHandle;
+	if (pTableHandle->setHead) {
+		plg_dictRelease(pTableHandle->setHead);
+	}
 	free(pTableHandle);
 }
 
@@ -88,8 +112,62 @@ typedef struct _TableIterator
 	PTableHandle pTableHandle;
 	unsigned int elementPage;
 	unsigned short elementOffset;
+	unsigned int readAheadPage;
+	short readAhead;
 }*PTableIterator, TableIterator;
 
+//Maximum number of pages read ahead when an iterator enters a page
+#define _READAHEADPAGE_ 8
+
+/*
+The elements of a page link to the pages that the scan will visit soon,
+Higher levels link further ahead, so they are read ahead by the file thread
+*/
+static void table_ReadAhead(PTableHandle pTableHandle, unsigned int pageAddr, void* page, short isPrev) {
+
+	if (pTableHandle->pTableHandleCallBack->prefetchPage == 0) {
+		return;
+	}
+
+	PDiskTablePage pDiskTablePage = (PDiskTablePage)((unsigned char*)page + sizeof(DiskPageHead));
+	unsigned int readAheadAddr[_READAHEADPAGE_];
+	unsigned int count = 0;
+	for (unsigned short l = 0; l < pDiskTablePage->tableSize && count < _READAHEADPAGE_; l++) {
+		PDiskTableElement pDiskTableElement = &pDiskTablePage->element[l];
+		if (pDiskTableElement->keyOffset == 0) {
+			continue;
+		}
+
+		unsigned int addr;
+		if (isPrev) {
+			if (pDiskTableElement->currentLevel != 0) {
+				continue;
+			}
+			addr = ((PDiskTableKey)POINTER(page, pDiskTableElement->keyOffset))->prevElementPage;
+		} else {
+			addr = pDiskTableElement->nextElementPage;
+		}
+
+		if (addr == 0 || addr == pageAddr) {
+			continue;
+		}
+
+		unsigned int f = 0;
+		for (; f < count; f++) {
+			if (readAheadAddr[f] == addr) {
+				break;
+			}
+		}
+		if (f == count) {
+			readAheadAddr[count++] = addr;
+		}
+	}
+
+	if (count) {
+		pTableHandle->pTableHandleCallBack->prefetchPage(pTableHandle, readAheadAddr, count);
+	}
+}
+
 /*
 Ϊɾ,رɾǰһ.
 find table name in skip list
@@ -121,6 +199,8 @@ void* plg_TableGetIteratorToTail(void* pvTableHandle) {
 	pTableIterator->pTableHandle = pTableHandle;
 	pTableIterator->elementPage = skipListPoint[0].skipListAddr;
 	pTableIterator->elementOffset = skipListPoint[0].skipListOffset;
+	pTableIterator->readAheadPage = 0;
+	pTableIterator->readAhead = 0;
 
 	return pTableIterator;
 }
@@ -128,7 +208,7 @@ void* plg_TableGetIteratorToTail(void* pvTableHandle) {
 /*
 key or head
 */
-void* plg_TableGetIteratorWithKey(void* pvTableHandle, void* vKey, short keyLen) {
+void* plg_TableGetIteratorWithKey(void* pvTableHandle, void* vKey, unsigned int keyLen) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	PTableIterator pTableIterator = malloc(sizeof(TableIterator));
@@ -152,6 +232,8 @@ void* plg_TableGetIteratorWithKey(void* pvTableHandle, void* vKey, short keyLen)
 	pTableIterator->pTableHandle = pTableHandle;
 	pTableIterator->elementPage = skipListPoint[0].pDiskTableElement->nextElementPage;
 	pTableIterator->elementOffset = skipListPoint[0].pDiskTableElement->nextElementOffset;
+	pTableIterator->readAheadPage = 0;
+	pTableIterator->readAhead = 0;
 
 	return pTableIterator;
 }
@@ -167,6 +249,11 @@ void* plg_TablePrevIterator(void* pvTableIterator) {
 	if (pTableIterator->pTableHandle->pTableHandleCallBack->findPage(pTableIterator->pTableHandle, pTableIterator->elementPage, &nextPage) == 0){
 		return 0;
 	}
+
+	if (pTableIterator->readAhead && pTableIterator->readAheadPage != pTableIterator->elementPage) {
+		pTableIterator->readAheadPage = pTableIterator->elementPage;
+		table_ReadAhead(pTableIterator->pTableHandle, pTableIterator->elementPage, nextPage, 1);
+	}
 		
 	//get PDiskTableKey
 	PDiskTableElement pDiskTableElement = (PDiskTableElement)POINTER(nextPage, pTableIterator->elementOffset);
@@ -198,6 +285,11 @@ void* plg_TableNextIterator(void* pvTableIterator) {
 		return 0;
 	}
 
+	if (pTableIterator->readAhead && pTableIterator->readAheadPage != pTableIterator->elementPage) {
+		pTableIterator->readAheadPage = pTableIterator->elementPage;
+		table_ReadAhead(pTableIterator->pTableHandle, pTableIterator->elementPage, nextPage, 0);
+	}
+
 	//get PDiskTableKey
 	PDiskTableElement pDiskTableElement = (PDiskTableElement)POINTER(nextPage, pTableIterator->elementOffset);
 	PDiskTableKey pDiskTableKey = (PDiskTableKey)POINTER(nextPage, pDiskTableElement->keyOffset);
@@ -209,6 +301,18 @@ void* plg_TableNextIterator(void* pvTableIterator) {
 	return pDiskTableKey;
 }
 
+/*
+Iterator of range, pattern and member scans, only these read ahead.
+Point lookups, clear and set merge walk few or scattered pages.
+*/
+static void* table_ScanIterator(PTableHandle pTableHandle, void* vKey, unsigned int keyLen) {
+	PTableIterator pTableIterator = plg_TableGetIteratorWithKey(pTableHandle, vKey, keyLen);
+	if (pTableIterator) {
+		pTableIterator->readAhead = 1;
+	}
+	return pTableIterator;
+}
+
 static void* table_DupIterator(void* pvTableIterator) {
 	PTableIterator pTableIterator = pvTableIterator;
 	PTableIterator pRetTableIterator = malloc(sizeof(TableIterator));
@@ -379,21 +483,9 @@ int plg_TableTailFindCmpFun(void* key1, unsigned int key1Len, void* key2, unsign
 	return 0;
 }
 
-unsigned int plg_TableFindWithName(void* pvTableHandle, char* key, short keyLen, void* vskipListPoint, FindCmpFun pFindCmpFun) {
+static unsigned int table_FindFrom(PTableHandle pTableHandle, PTableInFile pTableInFile, char* key, unsigned int keyLen, ARRAY_SKIPLISTPOINT* skipListPoint, FindCmpFun pFindCmpFun,
+	unsigned int pageAddr, void* page, PDiskTableElement tableElement) {
 
-	//init from pCacheHandle
-	ARRAY_SKIPLISTPOINT* skipListPoint = vskipListPoint;
-	PTableHandle pTableHandle = pvTableHandle;
-	unsigned int pageAddr = 0;
-	void* page = 0;
-	PTableInFile pTableInFile;
-	if (pTableHandle->pTableInFile->isSetHead) {
-		pTableInFile = pTableHandle->pTableInFile;
-	} else {
-		pTableInFile = pTableHandle->pTableHandleCallBack->findTableInFile(pTableHandle, pTableHandle->nameaTable, pTableHandle->pTableInFile);
-	}
-	PDiskTableElement tableElement = &pTableInFile->tableHead[SKIPLIST_MAXLEVEL - 1];
-	pTableHandle->hitStamp = plg_GetCurrentSec();
 	do {
 		//If the next level is not equal to zero, load the next level and compare. If it is greater than or equal to, switch to the next level
 		if (tableElement->nextElementPage != 0) {
@@ -442,6 +534,223 @@ unsigned int plg_TableFindWithName(void* pvTableHandle, char* key, short keyLen,
 		
 	} while (1);
 }
+
+unsigned int plg_TableFindWithName(void* pvTableHandle, char* key, unsigned int keyLen, void* vskipListPoint, FindCmpFun pFindCmpFun) {
+
+	//init from pCacheHandle
+	ARRAY_SKIPLISTPOINT* skipListPoint = vskipListPoint;
+	PTableHandle pTableHandle = pvTableHandle;
+	PTableInFile pTableInFile;
+	if (pTableHandle->pTableInFile->isSetHead) {
+		pTableInFile = pTableHandle->pTableInFile;
+	} else {
+		pTableInFile = pTableHandle->pTableHandleCallBack->findTableInFile(pTableHandle, pTableHandle->nameaTable, pTableHandle->pTableInFile);
+	}
+	pTableHandle->hitStamp = plg_GetCurrentSec();
+	return table_FindFrom(pTableHandle, pTableInFile, key, keyLen, skipListPoint, pFindCmpFun, 0, 0, &pTableInFile->tableHead[SKIPLIST_MAXLEVEL - 1]);
+}
+
+/*
+Search a key not less than the key of the previous search, starting from the link points that search left in skipListPoint.
+The points are read again by address because a write in between may have copied their pages.
+Climb while the next element of the level is still before the key, then walk down as usual,
+So a batch of sorted keys does not walk the upper levels from the head for every key
+*/
+static unsigned int table_FingerFindWithName(PTableHandle pTableHandle, char* key, unsigned int keyLen, ARRAY_SKIPLISTPOINT* skipListPoint, FindCmpFun pFindCmpFun) {
+
+	PTableInFile pTableInFile;
+	if (pTableHandle->pTableInFile->isSetHead) {
+		pTableInFile = pTableHandle->pTableInFile;
+	} else {
+		pTableInFile = pTableHandle->pTableHandleCallBack->findTableInFile(pTableHandle, pTableHandle->nameaTable, pTableHandle->pTableInFile);
+	}
+	pTableHandle->hitStamp = plg_GetCurrentSec();
+
+	for (unsigned short l = 0; l < SKIPLIST_MAXLEVEL; l++) {
+		if ((*skipListPoint)[l].skipListAddr == 0) {
+			(*skipListPoint)[l].page = 0;
+			(*skipListPoint)[l].pDiskTableElement = &pTableInFile->tableHead[l];
+			continue;
+		}
+
+		void* page;
+		if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, (*skipListPoint)[l].skipListAddr, &page) == 0) {
+			return 0;
+		}
+		PDiskTableElement pDiskTableElement = (PDiskTableElement)POINTER(page, (*skipListPoint)[l].skipListOffset);
+		if (pDiskTableElement->keyOffset == 0 || pDiskTableElement->currentLevel != l) {
+			return plg_TableFindWithName(pTableHandle, key, keyLen, skipListPoint, pFindCmpFun);
+		}
+		(*skipListPoint)[l].page = page;
+		(*skipListPoint)[l].pDiskTableElement = pDiskTableElement;
+	}
+
+	unsigned short l = 0;
+	for (; l < SKIPLIST_MAXLEVEL - 1; l++) {
+		PDiskTableElement tableElement = (*skipListPoint)[l].pDiskTableElement;
+		if (tableElement->nextElementPage == 0) {
+			break;
+		}
+
+		void* nextPage;
+		if (tableElement->nextElementPage == (*skipListPoint)[l].skipListAddr) {
+			nextPage = (*skipListPoint)[l].page;
+		} else if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, tableElement->nextElementPage, &nextPage) == 0) {
+			return 0;
+		}
+
+		PDiskTableElement nextItem = (PDiskTableElement)POINTER(nextPage, tableElement->nextElementOffset);
+		PDiskTableKey pDiskTableKey = (PDiskTableKey)POINTER(nextPage, nextItem->keyOffset);
+		if (!pFindCmpFun(key, keyLen, pDiskTableKey->keyStr, pDiskTableKey->keyStrSize)) {
+			break;
+		}
+	}
+
+	return table_FindFrom(pTableHandle, pTableInFile, key, keyLen, skipListPoint, pFindCmpFun,
+		(*skipListPoint)[l].skipListAddr, (*skipListPoint)[l].page, (*skipListPoint)[l].pDiskTableElement);
+}
+static unsigned int table_FreeSpaceClass(unsigned int spaceLength) {
+
+	unsigned int c = 0;
+	while (c < _FREESPACECLASS_ - 1 && spaceLength >= ((unsigned int)_FREESPACEMIN_ << (c + 1))) {
+		c++;
+	}
+	return c;
+}
+
+static void table_FreeSpaceDel(PTableHandle pTableHandle, unsigned int pageAddr) {
+
+	for (unsigned int c = 0; c < _FREESPACECLASS_; c++) {
+		for (unsigned int l = 0; l < _FREESPACESLOT_; l++) {
+			if (pTableHandle->freeSpace[c][l] == pageAddr) {
+				pTableHandle->freeSpace[c][l] = 0;
+			}
+		}
+	}
+}
+
+/*
+File the page under the size class of its free space.
+A full class gives up one of its pages, it is found again by the scan of the using pages
+*/
+static void table_FreeSpaceSet(PTableHandle pTableHandle, unsigned int pageAddr, unsigned int spaceLength) {
+
+	if (pTableHandle->pTableInFile->isSetHead) {
+		return;
+	}
+
+	table_FreeSpaceDel(pTableHandle, pageAddr);
+	if (spaceLength < _FREESPACEMIN_) {
+		return;
+	}
+
+	unsigned int* slot = pTableHandle->freeSpace[table_FreeSpaceClass(spaceLength)];
+	for (unsigned int l = 0; l < _FREESPACESLOT_; l++) {
+		if (slot[l] == 0) {
+			slot[l] = pageAddr;
+			return;
+		}
+	}
+	slot[pageAddr % _FREESPACESLOT_] = pageAddr;
+}
+
+/*
+Forget the free space index, its pages may have left the table.
+Called when the table is cleared and when the transaction rolls back
+*/
+void plg_TableResetFreeSpace(void* pvTableHandle) {
+
+	PTableHandle pTableHandle = pvTableHandle;
+	memset(pTableHandle->freeSpace, 0, sizeof(pTableHandle->freeSpace));
+}
+
+/*
+Find a page with requireLegth bytes in the smallest size class that has one,
+pages filed under a wrong class are moved to the right one on the way
+*/
+static unsigned int table_FreeSpaceFind(PTableHandle pTableHandle, unsigned short requireLegth, void** page) {
+
+	if (pTableHandle->pTableInFile->isSetHead) {
+		return 0;
+	}
+
+	for (unsigned int c = table_FreeSpaceClass(requireLegth); c < _FREESPACECLASS_; c++) {
+		for (unsigned int l = 0; l < _FREESPACESLOT_; l++) {
+			unsigned int pageAddr = pTableHandle->freeSpace[c][l];
+			if (pageAddr == 0 || pageAddr == pTableHandle->compactPage) {
+				continue;
+			}
+
+			if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, pageAddr, page) == 0) {
+				pTableHandle->freeSpace[c][l] = 0;
+				continue;
+			}
+
+			PDiskPageHead pDiskPageHead = (PDiskPageHead)*page;
+			PDiskTablePage pDiskTablePage = (PDiskTablePage)((unsigned char*)*page + sizeof(DiskPageHead));
+			if (pDiskPageHead->type != TABLEPAGE) {
+				pTableHandle->freeSpace[c][l] = 0;
+				continue;
+			}
+
+			if (pDiskTablePage->spaceLength >= requireLegth) {
+				*page = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, pageAddr, *page);
+				return 1;
+			}
+
+			if (table_FreeSpaceClass(pDiskTablePage->spaceLength) != c) {
+				table_FreeSpaceSet(pTableHandle, pageAddr, pDiskTablePage->spaceLength);
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+The page of a neighbour of the new key in the skip list, if it has requireLegth bytes
+*/
+static unsigned int table_NearPage(PTableHandle pTableHandle, unsigned int pageAddr, unsigned short requireLegth, void** page) {
+
+	if (pageAddr == 0 || pageAddr == pTableHandle->compactPage) {
+		return 0;
+	}
+
+	if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, pageAddr, page) == 0) {
+		return 0;
+	}
+
+	PDiskTablePage pDiskTablePage = (PDiskTablePage)((unsigned char*)*page + sizeof(DiskPageHead));
+	if (pDiskTablePage->spaceLength < requireLegth) {
+		return 0;
+	}
+
+	*page = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, pageAddr, *page);
+	return 1;
+}
+
+/*
+Write the spaceLength of the table page to its entry of the using page
+*/
+static unsigned int table_UpdateUsingSpace(PTableHandle pTableHandle, void* page) {
+
+	PDiskTablePage pDiskTablePage = (PDiskTablePage)((unsigned char*)page + sizeof(DiskPageHead));
+	void* usingPage;
+	if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, pDiskTablePage->usingPageAddr, &usingPage) == 0) {
+		plg_assert(0);
+		return 0;
+	}
+
+	usingPage = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, pDiskTablePage->usingPageAddr, usingPage);
+	PDiskTableUsingPage pDiskTableUsingPage = (PDiskTableUsingPage)((unsigned char*)usingPage + sizeof(DiskPageHead));
+	PDiskTableUsing pDiskTableUsing = (PDiskTableUsing)POINTER(usingPage, pDiskTablePage->usingPageOffset);
+
+	pDiskTableUsingPage->allSpace += (int)pDiskTablePage->spaceLength - pDiskTableUsing->usingSpaceLength;
+	pDiskTableUsing->usingSpaceLength = pDiskTablePage->spaceLength;
+	pTableHandle->pTableHandleCallBack->addDirtyPage(pTableHandle, pDiskTablePage->usingPageAddr);
+	table_FreeSpaceSet(pTableHandle, ((PDiskPageHead)page)->addr, pDiskTablePage->spaceLength);
+	return 1;
+}
+
 /*
 To create a page, you must synchronize the operation and get the page number
 The page number is the basis for the next step
@@ -450,10 +759,31 @@ Otherwise, memory leak will occur. Therefore, the page created by the current tr
 If the created page is not submitted successfully, submitting the page modification data will result in serious page address corruption
 But the creation succeeds, but the page data is not modified, only the page address is damaged
 */
-static unsigned int table_FindOrNewPage(void* pvTableHandle, unsigned short requireLegth, void** page) {
+static unsigned int table_FindOrNewPage(void* pvTableHandle, unsigned short requireLegth, ARRAY_SKIPLISTPOINT* pSkipListPoint, void** page) {
 
 	//Special handling if tableusingpage is zero
 	PTableHandle pTableHandle = pvTableHandle;
+
+	//Keys moved by compaction go to the page chosen for them while it has room
+	if (pTableHandle->compactTarget) {
+		if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, pTableHandle->compactTarget, page) == 0) {
+			return 0;
+		}
+
+		PDiskTablePage pDiskTablePage = (PDiskTablePage)((unsigned char*)*page + sizeof(DiskPageHead));
+		if (pDiskTablePage->spaceLength >= requireLegth) {
+			*page = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, pTableHandle->compactTarget, *page);
+			return 1;
+		}
+	}
+
+	//Keep the key beside the keys before and after it, then take the smallest free space that fits
+	if (table_NearPage(pTableHandle, (*pSkipListPoint)[0].skipListAddr, requireLegth, page) ||
+		table_NearPage(pTableHandle, (*pSkipListPoint)[0].pDiskTableElement->nextElementPage, requireLegth, page) ||
+		table_FreeSpaceFind(pTableHandle, requireLegth, page)) {
+		return 1;
+	}
+
 	PTableInFile pTableInFile;
 	if (pTableHandle->pTableInFile->isSetHead) {
 		pTableInFile = pTableHandle->pTableInFile;
@@ -533,7 +863,7 @@ static unsigned int table_FindOrNewPage(void* pvTableHandle, unsigned short requ
 				}
 
 				//Return table page if the requirements are met
-				if (pDiskTableUsingPage->element[cur].usingSpaceLength >= requireLegth) {
+				if (pDiskTableUsingPage->element[cur].usingSpaceLength >= requireLegth && pDiskTableUsingPage->element[cur].pageAddr != pTableHandle->compactPage) {
 				
 					int r = pTableHandle->pTableHandleCallBack->findPage(pTableHandle, pDiskTableUsingPage->element[cur].pageAddr, page);
 					*page = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, pDiskTableUsingPage->element[cur].pageAddr, *page);
@@ -701,6 +1031,7 @@ static unsigned int table_DelPage(void* pvTableHandle, unsigned int pageAddr) {
 	PDiskTableUsing pDiskTableUsing = (PDiskTableUsing)POINTER(usingPage, pDiskTablePage->usingPageOffset);
 
 	//clear in using page
+	table_FreeSpaceDel(pTableHandle, pageAddr);
 	pDiskTableUsingPage->allSpace -= pDiskTableUsing->usingSpaceLength;
 	pDiskTableUsing->pageAddr = 0;
 	pDiskTableUsing->usingSpaceLength = 0;
@@ -894,18 +1225,27 @@ create using page and create table page.
 If you create up to 6 new ones, at least 4 new ones
 If no more than 2 are created
 */
-static unsigned int table_InsideNew(void* pvTableHandle, char* key, unsigned short keySize, char valueType, void* value, unsigned short length, void* vskipListPoint) {
+static unsigned int table_InsideNew(void* pvTableHandle, char* key, unsigned int keySize, char valueType, void* value, unsigned short length, void* vskipListPoint) {
 
 	//variable
 	ARRAY_SKIPLISTPOINT* skipListPoint = vskipListPoint;
 	void* tablePage;
 	PTableHandle pTableHandle = pvTableHandle;
+
+	//The key is never split, so it must fit in an empty page with the highest level
+	unsigned int maxKeySize = FULLSIZE(pTableHandle->pageSize) - sizeof(DiskPageHead) - sizeof(DiskTablePage) -
+		sizeof(DiskTableElement) * SKIPLIST_MAXLEVEL - sizeof(DiskTableKey) - length;
+	if (keySize > maxKeySize) {
+		elog(log_error, "table_InsideNew.keySize:%u > %u", keySize, maxKeySize);
+		return 0;
+	}
+
 	unsigned short level = plg_RandomLevel();
 	unsigned short kvLength = sizeof(DiskTableKey) + keySize + length;
 	unsigned short requireLength = sizeof(DiskTableElement) * level + kvLength;
 
 	//get table page can put requireLength
-	if (table_FindOrNewPage(pTableHandle, requireLength, &tablePage) == 0) {
+	if (table_FindOrNewPage(pTableHandle, requireLength, skipListPoint, &tablePage) == 0) {
 		return 0;
 	}
 
@@ -1012,18 +1352,9 @@ static unsigned int table_InsideNew(void* pvTableHandle, char* key, unsigned sho
 			if (curLevel == 0) {
 
 				//To update TableUsing
-				void* usingPage;
-				if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, pDiskTablePage->usingPageAddr, &usingPage) == 0) {
-					plg_assert(0);
+				if (table_UpdateUsingSpace(pTableHandle, tablePage) == 0) {
 					return 0;
 				}
-				usingPage = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, pDiskTablePage->usingPageAddr, usingPage);
-				PDiskTableUsingPage pDiskTableUsingPage = (PDiskTableUsingPage)((unsigned char*)usingPage + sizeof(DiskPageHead));
-				PDiskTableUsing pDiskTableUsing = (PDiskTableUsing)POINTER(usingPage, pDiskTablePage->usingPageOffset);
-
-				pDiskTableUsingPage->allSpace += (int)pDiskTablePage->spaceLength - pDiskTableUsing->usingSpaceLength;
-				pDiskTableUsing->usingSpaceLength = pDiskTablePage->spaceLength;
-				pTableHandle->pTableHandleCallBack->addDirtyPage(pTableHandle, pDiskTablePage->usingPageAddr);
 
 				plg_assert(table_CheckElement(pvTableHandle, tablePage, &pDiskTablePage->element[l]));
 				plg_assert(plg_TableCheckSpace(tablePage));
@@ -1117,19 +1448,9 @@ static unsigned int table_InsideNew(void* pvTableHandle, char* key, unsigned sho
 	}
 
 	//To update TableUsing
-	void* usingPage;
-	if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, pDiskTablePage->usingPageAddr, &usingPage) == 0) {
-		plg_assert(0);
+	if (table_UpdateUsingSpace(pTableHandle, tablePage) == 0) {
 		return 0;
 	}
-		
-	usingPage = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, pDiskTablePage->usingPageAddr, usingPage);
-	PDiskTableUsingPage pDiskTableUsingPage = (PDiskTableUsingPage)((unsigned char*)usingPage + sizeof(DiskPageHead));
-	PDiskTableUsing pDiskTableUsing = (PDiskTableUsing)POINTER(usingPage, pDiskTablePage->usingPageOffset);
-
-	pDiskTableUsingPage->allSpace += (int)pDiskTablePage->spaceLength - pDiskTableUsing->usingSpaceLength;
-	pDiskTableUsing->usingSpaceLength = pDiskTablePage->spaceLength;
-	pTableHandle->pTableHandleCallBack->addDirtyPage(pTableHandle, pDiskTablePage->usingPageAddr);
 
 	plg_assert(plg_TableCheckLength(tablePage, pTableHandle->pageSize));
 	plg_assert(plg_TableCheckSpace(tablePage));
@@ -1829,7 +2150,7 @@ void plg_TableArrangmentBigValue(unsigned int pageSize, void* page){
 /*
 ɹ1ҳ
 */
-static unsigned int table_InsideAlter(void* pvTableHandle, char* key, short keyLen, ARRAY_SKIPLISTPOINT* pSkipListPoint, char valueType, void* value, unsigned short length) {
+static unsigned int table_InsideAlter(void* pvTableHandle, char* key, unsigned int keyLen, ARRAY_SKIPLISTPOINT* pSkipListPoint, char valueType, void* value, unsigned short length) {
 
 	//load table page retrun PDiskTableKey
 	PTableHandle pTableHandle = pvTableHandle;
@@ -1871,14 +2192,40 @@ static unsigned int table_InsideAlter(void* pvTableHandle, char* key, short keyL
 
 	if (pDiskTableKey->valueType == VALUE_NORMAL)  {
 
-		if (pDiskTableKey->valueSize != length) {
+		//A value that is not larger keeps the slot of the key, only a larger one is deleted and added again
+		if (pDiskTableKey->valueSize < length) {
 			return 0;
 		}
 
+		PDiskPageHead pDiskPageHead = (PDiskPageHead)((unsigned char*)page);
+		PDiskTablePage pDiskTablePage = (PDiskTablePage)((unsigned char*)page + sizeof(DiskPageHead));
+		unsigned short freeSize = pDiskTableKey->valueSize - length;
+		unsigned short spaceLength = pDiskTablePage->spaceLength;
+
 		pDiskTableKey->valueSize = length;
 		memcpy(vluePtr, value, length);
 
-		PDiskPageHead pDiskPageHead = (PDiskPageHead)((unsigned char*)page);
+		if (freeSize) {
+			pDiskTablePage->usingLength -= freeSize;
+			if (pDiskTableElement->keyOffset == pDiskTablePage->spaceAddr + pDiskTablePage->spaceLength) {
+				//The lowest key moves up so the bytes it frees join the space of the page
+				unsigned short keyVlaueSize = sizeof(DiskTableKey) + pDiskTableKey->keyStrSize + length;
+				memmove((unsigned char*)pDiskTableKey + freeSize, pDiskTableKey, keyVlaueSize);
+				memset(pDiskTableKey, 0, freeSize);
+				table_SetElementKeyOffset(page, pDiskTableElement, pDiskTableElement->keyOffset + freeSize);
+				pDiskTablePage->spaceLength += freeSize;
+			} else {
+				memset((unsigned char*)vluePtr + length, 0, freeSize);
+				pDiskTablePage->delSize += freeSize;
+				pTableHandle->pTableHandleCallBack->arrangementCheck(pTableHandle, page);
+			}
+		}
+
+		if (pDiskTablePage->spaceLength != spaceLength && table_UpdateUsingSpace(pTableHandle, page) == 0) {
+			return 0;
+		}
+
+		plg_assert(plg_TableCheckLength(page, pTableHandle->pageSize));
 		pTableHandle->pTableHandleCallBack->addDirtyPage(pTableHandle, pDiskPageHead->addr);
 		return 1;
 	}
@@ -1886,7 +2233,7 @@ static unsigned int table_InsideAlter(void* pvTableHandle, char* key, short keyL
 	return 0;
 }
 
-static unsigned int table_InsideAlterFroSet(void* pvTableHandle, char* key, short keyLen, ARRAY_SKIPLISTPOINT* pSkipListPoint, char valueType, void* value, unsigned short length) {
+static unsigned int table_InsideAlterFroSet(void* pvTableHandle, char* key, unsigned int keyLen, ARRAY_SKIPLISTPOINT* pSkipListPoint, char valueType, void* value, unsigned short length) {
 
 	//load table page retrun PDiskTableKey
 	PTableHandle pTableHandle = pvTableHandle;
@@ -1944,7 +2291,7 @@ static unsigned int table_InsideAlterFroSet(void* pvTableHandle, char* key, shor
 	return 0;
 }
 
-unsigned int plg_InsideTableAlterFroSet(void* pvTableHandle, char* key, short keyLen, char valueType, void* value, unsigned short length) {
+unsigned int plg_InsideTableAlterFroSet(void* pvTableHandle, char* key, unsigned int keyLen, char valueType, void* value, unsigned short length) {
 
 	//find skip list point
 	PTableHandle pTableHandle = pvTableHandle;
@@ -1960,7 +2307,7 @@ unsigned int plg_InsideTableAlterFroSet(void* pvTableHandle, char* key, short ke
 /*
 ɹ1ҳ
 */
-static unsigned int table_InsideIsKeyExist(void* pvTableHandle, void* vKey, short keyLen, ARRAY_SKIPLISTPOINT* pSkipListPoint) {
+static unsigned int table_InsideIsKeyExist(void* pvTableHandle, void* vKey, unsigned int keyLen, ARRAY_SKIPLISTPOINT* pSkipListPoint) {
 
 	//load table page retrun PDiskTableKey
 	PTableHandle pTableHandle = pvTableHandle;
@@ -1995,7 +2342,7 @@ static unsigned int table_InsideIsKeyExist(void* pvTableHandle, void* vKey, shor
 
 /*
 If you delete and modify at most 6, at least 1
-noSet:Prevent nesting caused by deleting collections
+noSet:Prevent nesting caused by deleting collections, only the key is removed and the set or big value it points to is kept
 */
 static unsigned int table_InsideDel(void* pvTableHandle, char* key, unsigned short keySize, ARRAY_SKIPLISTPOINT* pSkipListPoint, unsigned int noSet) {
 
@@ -2077,7 +2424,7 @@ static unsigned int table_InsideDel(void* pvTableHandle, char* key, unsigned sho
 			break;
 		}
 
-		if (pDiskTableKey->valueType == VALUE_BIGVALUE) {
+		if (!noSet && pDiskTableKey->valueType == VALUE_BIGVALUE) {
 			PDiskKeyBigValue pDiskKeyBigValue = (PDiskKeyBigValue)vluePtr;
 			table_DelBigValue(pTableHandle, pDiskKeyBigValue);
 		} else if (!noSet && pDiskTableKey->valueType == VALUE_SETHEAD) {
@@ -2159,25 +2506,15 @@ static unsigned int table_InsideDel(void* pvTableHandle, char* key, unsigned sho
 		if (pDiskTablePage->tableLength != 0) {
 
 			//To updat PDiskTableUsing
-			void* usingPage;
-			if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, pDiskTablePage->usingPageAddr, &usingPage) == 0) {
+			if (table_UpdateUsingSpace(pTableHandle, nextPage) == 0) {
 				return 0;
 			}
-				
-			usingPage = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, pDiskTablePage->usingPageAddr, usingPage);
 
-			PDiskTableUsingPage pDiskTableUsingPage = (PDiskTableUsingPage)((unsigned char*)usingPage + sizeof(DiskPageHead));
-			PDiskTableUsing pDiskTableUsing = (PDiskTableUsing)POINTER(usingPage, pDiskTablePage->usingPageOffset);
-			
-			pDiskTableUsingPage->allSpace += (int)pDiskTablePage->spaceLength - pDiskTableUsing->usingSpaceLength;
-			pDiskTableUsing->usingSpaceLength = pDiskTablePage->spaceLength;
-			pTableHandle->pTableHandleCallBack->addDirtyPage(pTableHandle, pDiskTablePage->usingPageAddr);
+			plg_assert(plg_TableCheckSpace(nextPage));
+			plg_assert(plg_TableCheckLength(nextPage, pTableHandle->pageSize));
 		} else {
 			table_DelPage(pTableHandle, curPageAddr);
 		}
-
-		plg_assert(plg_TableCheckSpace(nextPage));
-		plg_assert(plg_TableCheckLength(nextPage, pTableHandle->pageSize));
 	} while (1);
 
 	if (isBreak) {
@@ -2230,7 +2567,7 @@ static unsigned int table_InsideDel(void* pvTableHandle, char* key, unsigned sho
 	return 1;
 }
 
-static unsigned int plg_InsideTableAdd(void* pvTableHandle, void* vKey, short keyLen, char valueType, void* value, unsigned short length) {
+static unsigned int plg_InsideTableAdd(void* pvTableHandle, void* vKey, unsigned int keyLen, char valueType, void* value, unsigned short length) {
 
 	//find skip list point
 	PTableHandle pTableHandle = pvTableHandle;
@@ -2243,14 +2580,14 @@ static unsigned int plg_InsideTableAdd(void* pvTableHandle, void* vKey, short ke
 	return table_InsideNew(pTableHandle, vKey, keyLen, valueType, value, length, &skipListPoint);
 }
 
-unsigned int plg_TableAdd(void* pvTableHandle, void* vKey, short keyLen, void* value, unsigned short length) {
+unsigned int plg_TableAdd(void* pvTableHandle, void* vKey, unsigned int keyLen, void* value, unsigned short length) {
 
 	//add new
 	PTableHandle pTableHandle = pvTableHandle;
 	return plg_InsideTableAdd(pTableHandle, vKey, keyLen, VALUE_NORMAL, value, length);
 }
 
-unsigned int plg_TableDelForSet(void* pvTableHandle, void* vKey, short keyLen) {
+unsigned int plg_TableDelForSet(void* pvTableHandle, void* vKey, unsigned int keyLen) {
 
 	//find skip list point
 	PTableHandle pTableHandle = pvTableHandle;
@@ -2269,7 +2606,7 @@ unsigned int plg_TableDelForSet(void* pvTableHandle, void* vKey, short keyLen) {
 Note that this is only table deletion, not cache deletion.
 Deleting a table without deleting the cahce will cause the cache to fail to delete
 */
-unsigned int plg_TableDel(void* pvTableHandle, void* vKey, short keyLen) {
+unsigned int plg_TableDel(void* pvTableHandle, void* vKey, unsigned int keyLen) {
 
 	//find skip list point
 	PTableHandle pTableHandle = pvTableHandle;
@@ -2284,7 +2621,7 @@ unsigned int plg_TableDel(void* pvTableHandle, void* vKey, short keyLen) {
 	return 1;
 }
 
-unsigned int plg_TableAlter(void* pvTableHandle, void* vKey, short keyLen, void* value, unsigned short length) {
+unsigned int plg_TableAlter(void* pvTableHandle, void* vKey, unsigned int keyLen, void* value, unsigned short length) {
 
 	//find skip list point
 	PTableHandle pTableHandle = pvTableHandle;
@@ -2300,24 +2637,339 @@ unsigned int plg_TableAlter(void* pvTableHandle, void* vKey, short keyLen, void*
 	return 1;
 }
 
-int plg_TableFind(void* pvTableHandle, void* vKey, short keyLen, void* pDictExten, short isSet) {
+static unsigned int table_CompactArrange(PTableHandle pTableHandle, unsigned int pageAddr, void** page) {
+
+	PDiskTablePage pDiskTablePage = (PDiskTablePage)((unsigned char*)*page + sizeof(DiskPageHead));
+	if (pDiskTablePage->delSize == 0) {
+		return 1;
+	}
+
+	*page = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, pageAddr, *page);
+	plg_TableArrangementPage(pTableHandle->pageSize, *page);
+	pTableHandle->pTableHandleCallBack->addDirtyPage(pTableHandle, pageAddr);
+	return table_UpdateUsingSpace(pTableHandle, *page);
+}
+
+/*
+Compact one table page in the idle time of the job.
+The page is arranged first. If its keys fill less than _COMPACTSPARSE_ percent of it,
+they move to the neighbour page in the page chain with the most room.
+The page is deleted with its last key and goes back to the disk when the transaction commits.
+Returns 0 if a key could not be moved, the transaction must then be rolled back
+*/
+unsigned int plg_TableCompactPage(void* pvTableHandle, unsigned int pageAddr) {
 
-	//find skip list point
 	PTableHandle pTableHandle = pvTableHandle;
-	SkipListPoint skipListPoint[SKIPLIST_MAXLEVEL] = {{ 0 }};
-	if (plg_TableFindWithName(pTableHandle,vKey, keyLen, &skipListPoint, plg_TableTailFindCmpFun) == 0) {
-		return -1;
+	void* page;
+	if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, pageAddr, &page) == 0) {
+		return 1;
 	}
 
-	if (skipListPoint[0].skipListAddr == 0) {
+	PDiskPageHead pDiskPageHead = (PDiskPageHead)page;
+	PDiskTablePage pDiskTablePage = (PDiskTablePage)((unsigned char*)page + sizeof(DiskPageHead));
+	if (pDiskPageHead->type != TABLEPAGE || pDiskTablePage->tableLength == 0) {
+		return 1;
+	}
+
+	if (table_CompactArrange(pTableHandle, pageAddr, &page) == 0) {
 		return 0;
 	}
+	pDiskPageHead = (PDiskPageHead)page;
+	pDiskTablePage = (PDiskTablePage)((unsigned char*)page + sizeof(DiskPageHead));
 
-	//load table page retrun PDiskTableKey
-	void *prevPage = skipListPoint[0].page;
+	unsigned int pageSize = FULLSIZE(pTableHandle->pageSize) - sizeof(DiskPageHead) - sizeof(DiskTablePage);
+	if (((float)pDiskTablePage->usingLength / pageSize * 100) >= _COMPACTSPARSE_) {
+		return 1;
+	}
 
-	//get PDiskTableKey
-	PDiskTableElement pDiskTableElement = skipListPoint[0].pDiskTableElement;
+	unsigned int target = 0, targetSpace = 0;
+	unsigned int neighbour[2] = { pDiskPageHead->prevPage, pDiskPageHead->nextPage };
+	for (int l = 0; l < 2; l++) {
+		void* neighbourPage;
+		if (neighbour[l] == 0 || pTableHandle->pTableHandleCallBack->findPage(pTableHandle, neighbour[l], &neighbourPage) == 0) {
+			continue;
+		}
+
+		PDiskTablePage pNeighbourTablePage = (PDiskTablePage)((unsigned char*)neighbourPage + sizeof(DiskPageHead));
+		if (pNeighbourTablePage->spaceLength + pNeighbourTablePage->delSize > targetSpace) {
+			target = neighbour[l];
+			targetSpace = pNeighbourTablePage->spaceLength + pNeighbourTablePage->delSize;
+		}
+	}
+
+	if (target == 0 || targetSpace < pDiskTablePage->usingLength) {
+		return 1;
+	}
+
+	void* targetPage;
+	if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, target, &targetPage) == 0) {
+		return 1;
+	}
+	if (table_CompactArrange(pTableHandle, target, &targetPage) == 0) {
+		return 0;
+	}
+
+	//The keys are copied out first, the page changes with every key that leaves it
+	unsigned int count = 0;
+	sds* pKey = malloc(sizeof(sds) * pDiskTablePage->tableLength);
+	sds* pValue = malloc(sizeof(sds) * pDiskTablePage->tableLength);
+	char* pValueType = malloc(pDiskTablePage->tableLength);
+	for (unsigned short l = 0; l < pDiskTablePage->tableSize; l++) {
+		PDiskTableElement pDiskTableElement = &pDiskTablePage->element[l];
+		if (pDiskTableElement->currentLevel != 0 || pDiskTableElement->keyOffset == 0) {
+			continue;
+		}
+
+		PDiskTableKey pDiskTableKey = (PDiskTableKey)POINTER(page, pDiskTableElement->keyOffset);
+		pKey[count] = plg_sdsNewLen(pDiskTableKey->keyStr, pDiskTableKey->keyStrSize);
+		pValue[count] = plg_sdsNewLen((unsigned char*)pDiskTableKey + sizeof(DiskTableKey) + pDiskTableKey->keyStrSize, pDiskTableKey->valueSize);
+		pValueType[count] = pDiskTableKey->valueType;
+		count++;
+	}
+
+	//The set or big value of a key stays where it is, only the key moves
+	unsigned int r = 1;
+	pTableHandle->compactPage = pageAddr;
+	pTableHandle->compactTarget = target;
+	for (unsigned int l = 0; l < count; l++) {
+		SkipListPoint skipListPoint[SKIPLIST_MAXLEVEL] = {{ 0 }};
+		if (plg_TableFindWithName(pTableHandle, pKey[l], plg_sdsLen(pKey[l]), &skipListPoint, plg_TablePrevFindCmpFun) == 0 ||
+			table_InsideDel(pTableHandle, pKey[l], plg_sdsLen(pKey[l]), &skipListPoint, 1) == 0 ||
+			table_InsideNew(pTableHandle, pKey[l], plg_sdsLen(pKey[l]), pValueType[l], pValue[l], plg_sdsLen(pValue[l]), &skipListPoint) == 0) {
+			elog(log_error, "plg_TableCompactPage.Failed to move key of page %i!", pageAddr);
+			r = 0;
+			break;
+		}
+	}
+	pTableHandle->compactPage = 0;
+	pTableHandle->compactTarget = 0;
+
+	for (unsigned int l = 0; l < count; l++) {
+		plg_sdsFree(pKey[l]);
+		plg_sdsFree(pValue[l]);
+	}
+	free(pKey);
+	free(pValue);
+	free(pValueType);
+	return r;
+}
+
+/*
+Write the key at the link points of plg_TablePrevFindCmpFun whether or not it exists.
+A value of the same size is written in place, otherwise the key is deleted and added again at the same link points
+*/
+static unsigned int table_InsideAlterOrNew(PTableHandle pTableHandle, char* key, unsigned int keyLen, ARRAY_SKIPLISTPOINT* pSkipListPoint, char valueType, void* value, unsigned short length) {
+
+	if (table_InsideAlter(pTableHandle, key, keyLen, pSkipListPoint, valueType, value, length) == 1) {
+		return 1;
+	}
+
+	//del
+	if (table_InsideDel(pTableHandle, key, keyLen, pSkipListPoint, 0) == 0) {
+		return 0;
+	}
+
+	//add new
+	return table_InsideNew(pTableHandle, key, keyLen, valueType, value, length, pSkipListPoint);
+}
+
+static unsigned int table_InsideSetValue(PTableHandle pTableHandle, char* key, unsigned int keyLen, ARRAY_SKIPLISTPOINT* pSkipListPoint, void* value, unsigned int length) {
+
+	if (length > plg_TableBigValueSize()) {
+		DiskKeyBigValue diskKeyBigValue;
+		if (0 == plg_TableNewBigValue(pTableHandle, value, length, &diskKeyBigValue)) {
+			return 0;
+		}
+		return table_InsideAlterOrNew(pTableHandle, key, keyLen, pSkipListPoint, VALUE_BIGVALUE, &diskKeyBigValue, sizeof(DiskKeyBigValue));
+	} else {
+		return table_InsideAlterOrNew(pTableHandle, key, keyLen, pSkipListPoint, VALUE_NORMAL, value, length);
+	}
+}
+
+/*
+Return the key after the link points of plg_TablePrevFindCmpFun, or NULL if the table does not have it.
+The key is in the page as read, nothing may be written through it
+*/
+static PDiskTableKey table_InsideGetKey(PTableHandle pTableHandle, char* key, unsigned int keyLen, ARRAY_SKIPLISTPOINT* pSkipListPoint) {
+
+	PDiskTableElement pDiskTableElement = (*pSkipListPoint)[0].pDiskTableElement;
+	if (pDiskTableElement->nextElementPage == 0) {
+		return NULL;
+	}
+
+	void* page;
+	if ((*pSkipListPoint)[0].skipListAddr == pDiskTableElement->nextElementPage) {
+		page = (*pSkipListPoint)[0].page;
+	} else {
+		if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, pDiskTableElement->nextElementPage, &page) == 0)
+			return NULL;
+	}
+
+	PDiskTableElement nextItem = (PDiskTableElement)POINTER(page, pDiskTableElement->nextElementOffset);
+	PDiskTableKey pDiskTableKey = (PDiskTableKey)POINTER(page, nextItem->keyOffset);
+	if (keyLen != pDiskTableKey->keyStrSize || memcmp(pDiskTableKey->keyStr, key, keyLen) != 0) {
+		return NULL;
+	}
+	return pDiskTableKey;
+}
+
+/*
+Copy the value of pDiskTableKey, big values included. Need free
+*/
+static void* table_InsideGetValue(PTableHandle pTableHandle, PDiskTableKey pDiskTableKey, unsigned int* length) {
+
+	void* vluePtr = (unsigned char*)pDiskTableKey + sizeof(DiskTableKey) + pDiskTableKey->keyStrSize;
+	if (pDiskTableKey->valueType == VALUE_NORMAL) {
+		*length = pDiskTableKey->valueSize;
+		void* value = malloc(*length + 1);
+		memcpy(value, vluePtr, *length);
+		return value;
+	} else if (pDiskTableKey->valueType == VALUE_BIGVALUE) {
+		PDiskKeyBigValue pDiskKeyBigValue = (PDiskKeyBigValue)vluePtr;
+		*length = pDiskKeyBigValue->allSize;
+		return table_GetBigValue(pTableHandle, pDiskKeyBigValue);
+	}
+
+	elog(log_error, "WRONGTYPE Operation against a key holding the wrong kind of value!");
+	return NULL;
+}
+
+/*
+Set the key to value only if it holds oldValue, an oldValue of zero length means the key must not exist.
+Returns 1 if the value was set
+*/
+unsigned int plg_TableCompareAndSet(void* pvTableHandle, void* vKey, unsigned int keyLen, void* oldValue, unsigned int oldLength, void* value, unsigned int length) {
+
+	//find skip list point
+	PTableHandle pTableHandle = pvTableHandle;
+	SkipListPoint skipListPoint[SKIPLIST_MAXLEVEL] = {{ 0 }};
+	if (plg_TableFindWithName(pTableHandle, vKey, keyLen, &skipListPoint, plg_TablePrevFindCmpFun) == 0) {
+		return 0;
+	}
+
+	PDiskTableKey pDiskTableKey = table_InsideGetKey(pTableHandle, vKey, keyLen, &skipListPoint);
+	if (pDiskTableKey == NULL) {
+		if (oldLength != 0) {
+			return 0;
+		}
+	} else {
+		if (oldLength == 0) {
+			return 0;
+		}
+
+		if (pDiskTableKey->valueType == VALUE_NORMAL) {
+			void* vluePtr = (unsigned char*)pDiskTableKey + sizeof(DiskTableKey) + pDiskTableKey->keyStrSize;
+			if (pDiskTableKey->valueSize != oldLength || memcmp(vluePtr, oldValue, oldLength) != 0) {
+				return 0;
+			}
+		} else {
+			unsigned int currentLength;
+			void* currentValue = table_InsideGetValue(pTableHandle, pDiskTableKey, &currentLength);
+			if (currentValue == NULL) {
+				return 0;
+			}
+
+			int isSame = currentLength == oldLength && memcmp(currentValue, oldValue, oldLength) == 0;
+			free(currentValue);
+			if (!isSame) {
+				return 0;
+			}
+		}
+	}
+
+	return table_InsideSetValue(pTableHandle, vKey, keyLen, &skipListPoint, value, length);
+}
+
+/*
+Add increment to the double held by the key, a key that does not exist starts from zero.
+The value keeps its size so it is changed in place
+*/
+unsigned int plg_TableIncrDouble(void* pvTableHandle, void* vKey, unsigned int keyLen, double increment, double* result) {
+
+	//find skip list point
+	PTableHandle pTableHandle = pvTableHandle;
+	SkipListPoint skipListPoint[SKIPLIST_MAXLEVEL] = {{ 0 }};
+	if (plg_TableFindWithName(pTableHandle, vKey, keyLen, &skipListPoint, plg_TablePrevFindCmpFun) == 0) {
+		return 0;
+	}
+
+	double dv = 0;
+	PDiskTableKey pDiskTableKey = table_InsideGetKey(pTableHandle, vKey, keyLen, &skipListPoint);
+	if (pDiskTableKey != NULL) {
+		if (pDiskTableKey->valueType != VALUE_NORMAL || pDiskTableKey->valueSize != sizeof(double)) {
+			elog(log_error, "plg_TableIncrDouble.The value of the key is not a double!");
+			return 0;
+		}
+		memcpy(&dv, (unsigned char*)pDiskTableKey + sizeof(DiskTableKey) + pDiskTableKey->keyStrSize, sizeof(double));
+	}
+
+	dv += increment;
+	if (table_InsideAlterOrNew(pTableHandle, vKey, keyLen, &skipListPoint, VALUE_NORMAL, &dv, sizeof(double)) == 0) {
+		return 0;
+	}
+
+	if (result) {
+		*result = dv;
+	}
+	return 1;
+}
+
+/*
+Append value to the end of the value held by the key, a key that does not exist is added
+*/
+unsigned int plg_TableAppend(void* pvTableHandle, void* vKey, unsigned int keyLen, void* value, unsigned int length) {
+
+	//find skip list point
+	PTableHandle pTableHandle = pvTableHandle;
+	SkipListPoint skipListPoint[SKIPLIST_MAXLEVEL] = {{ 0 }};
+	if (plg_TableFindWithName(pTableHandle, vKey, keyLen, &skipListPoint, plg_TablePrevFindCmpFun) == 0) {
+		return 0;
+	}
+
+	PDiskTableKey pDiskTableKey = table_InsideGetKey(pTableHandle, vKey, keyLen, &skipListPoint);
+	if (pDiskTableKey == NULL) {
+		return table_InsideSetValue(pTableHandle, vKey, keyLen, &skipListPoint, value, length);
+	}
+
+	unsigned int currentLength;
+	void* currentValue = table_InsideGetValue(pTableHandle, pDiskTableKey, &currentLength);
+	if (currentValue == NULL) {
+		return 0;
+	}
+
+	char* newValue = malloc(currentLength + length);
+	memcpy(newValue, currentValue, currentLength);
+	memcpy(newValue + currentLength, value, length);
+	free(currentValue);
+
+	unsigned int r = table_InsideSetValue(pTableHandle, vKey, keyLen, &skipListPoint, newValue, currentLength + length);
+	free(newValue);
+	return r;
+}
+
+/*
+With isFinger the search resumes from the link points the previous key left in skipListPoint
+*/
+static int table_InsideFind(PTableHandle pTableHandle, void* vKey, unsigned int keyLen, void* pDictExten, short isSet, ARRAY_SKIPLISTPOINT* skipListPoint, short isFinger) {
+
+	//find skip list point
+	if (isFinger) {
+		if (table_FingerFindWithName(pTableHandle, vKey, keyLen, skipListPoint, plg_TableTailFindCmpFun) == 0) {
+			return -1;
+		}
+	} else if (plg_TableFindWithName(pTableHandle, vKey, keyLen, skipListPoint, plg_TableTailFindCmpFun) == 0) {
+		return -1;
+	}
+
+	if ((*skipListPoint)[0].skipListAddr == 0) {
+		return 0;
+	}
+
+	//load table page retrun PDiskTableKey
+	void *prevPage = (*skipListPoint)[0].page;
+
+	//get PDiskTableKey
+	PDiskTableElement pDiskTableElement = (*skipListPoint)[0].pDiskTableElement;
 	PDiskTableKey pDiskTableKey = (PDiskTableKey)POINTER(prevPage, pDiskTableElement->keyOffset);
 	void* vluePtr = (unsigned char*)pDiskTableKey + sizeof(DiskTableKey) + pDiskTableKey->keyStrSize;
 
@@ -2362,36 +3014,41 @@ int plg_TableFind(void* pvTableHandle, void* vKey, short keyLen, void* pDictExte
 	return 1;
 }
 
-//Keep only one correct add
-unsigned int table_InsideAddWithAlter(void* pvTableHandle, char* Key, short keyLen, char valueType, void* value, unsigned short length) {
+int plg_TableFind(void* pvTableHandle, void* vKey, unsigned int keyLen, void* pDictExten, short isSet) {
 
-	//find skip list point
-	PTableHandle pTableHandle = pvTableHandle;
 	SkipListPoint skipListPoint[SKIPLIST_MAXLEVEL] = {{ 0 }};
-	if (plg_TableFindWithName(pTableHandle, Key, keyLen, &skipListPoint, plg_TablePrevFindCmpFun) == 0) {
-		return 0;
-	}
+	return table_InsideFind(pvTableHandle, vKey, keyLen, pDictExten, isSet, &skipListPoint, 0);
+}
 
-	if (table_InsideAlter(pTableHandle, Key, keyLen, &skipListPoint, valueType, value, length) == 1) {
-		return 1;
-	}
+//Keep only one correct add, with isFinger the search resumes from the link points of the previous smaller key
+static unsigned int table_FingerAddWithAlter(PTableHandle pTableHandle, char* Key, unsigned int keyLen, char valueType, void* value, unsigned short length, ARRAY_SKIPLISTPOINT* skipListPoint, short isFinger) {
 
-	//del
-	if (table_InsideDel(pTableHandle, Key, keyLen, &skipListPoint, 0) == 0) {
+	//find skip list point
+	if (isFinger) {
+		if (table_FingerFindWithName(pTableHandle, Key, keyLen, skipListPoint, plg_TablePrevFindCmpFun) == 0) {
+			return 0;
+		}
+	} else if (plg_TableFindWithName(pTableHandle, Key, keyLen, skipListPoint, plg_TablePrevFindCmpFun) == 0) {
 		return 0;
 	}
 
-	//add new
-	return table_InsideNew(pTableHandle, Key, keyLen, valueType, value, length, &skipListPoint);
+	return table_InsideAlterOrNew(pTableHandle, Key, keyLen, skipListPoint, valueType, value, length);
 }
 
 //Keep only one correct add
-unsigned int plg_TableAddWithAlter(void* pvTableHandle, void* vKey, short keyLen, char valueType, void* value, unsigned short length) {
+unsigned int table_InsideAddWithAlter(void* pvTableHandle, char* Key, unsigned int keyLen, char valueType, void* value, unsigned short length) {
+
+	SkipListPoint skipListPoint[SKIPLIST_MAXLEVEL] = {{ 0 }};
+	return table_FingerAddWithAlter(pvTableHandle, Key, keyLen, valueType, value, length, &skipListPoint, 0);
+}
+
+//Keep only one correct add
+unsigned int plg_TableAddWithAlter(void* pvTableHandle, void* vKey, unsigned int keyLen, char valueType, void* value, unsigned short length) {
 	return table_InsideAddWithAlter(pvTableHandle, vKey, keyLen, valueType, value, length);
 }
 
 //Keep only one correct add
-unsigned int plg_TableAddIfNoExist(void* pvTableHandle, void* vKey, short keyLen, char valueType, void* value, unsigned short length) {
+unsigned int plg_TableAddIfNoExist(void* pvTableHandle, void* vKey, unsigned int keyLen, char valueType, void* value, unsigned short length) {
 
 	//find skip list point
 	PTableHandle pTableHandle = pvTableHandle;
@@ -2408,7 +3065,7 @@ unsigned int plg_TableAddIfNoExist(void* pvTableHandle, void* vKey, short keyLen
 	return table_InsideNew(pTableHandle,vKey, keyLen, valueType, value, length, &skipListPoint);
 }
 
-unsigned int plg_TableIsKeyExist(void* pvTableHandle, void* vKey, short keyLen) {
+unsigned int plg_TableIsKeyExist(void* pvTableHandle, void* vKey, unsigned int keyLen) {
 
 	//find skip list point
 	PTableHandle pTableHandle = pvTableHandle;
@@ -2420,7 +3077,7 @@ unsigned int plg_TableIsKeyExist(void* pvTableHandle, void* vKey, short keyLen)
 	return table_InsideIsKeyExist(pTableHandle, vKey, keyLen, &skipListPoint);
 }
 
-unsigned int plg_TableRename(void* pvTableHandle, void* vKey, short keyLen, void* vNewKey, short newKeyLen) {
+unsigned int plg_TableRename(void* pvTableHandle, void* vKey, unsigned int keyLen, void* vNewKey, unsigned int newKeyLen) {
 
 	//find skip list point
 	PTableHandle pTableHandle = pvTableHandle;
@@ -2490,7 +3147,7 @@ unsigned int plg_TableRename(void* pvTableHandle, void* vKey, short keyLen, void
 	return 1;
 }
 
-void plg_TableLimite(void* pvTableHandle, void* vKey, short keyLen, unsigned int left, unsigned int right, void* pDictExten) {
+void plg_TableLimite(void* pvTableHandle, void* vKey, unsigned int keyLen, unsigned int left, unsigned int right, void* pDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	void* iter = plg_TableGetIteratorWithKey(pTableHandle, vKey, keyLen);
@@ -2598,10 +3255,10 @@ void plg_TableOrder(void* pvTableHandle, short order, unsigned int limite, void*
 /*
 If the PLG_Tablegetiteratorwithkey search fails, will it return invalid results?
 */
-void plg_TableRang(void* pvTableHandle, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pDictExten) {
+void plg_TableRang(void* pvTableHandle, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
-	void* iter = plg_TableGetIteratorWithKey(pTableHandle, beginKey, beginKeyLen);
+	void* iter = table_ScanIterator(pTableHandle, beginKey, beginKeyLen);
 	PDiskTableKey pDiskTableKey;
 	while ((pDiskTableKey = plg_TableNextIterator(iter)) != NULL) {
 
@@ -2626,7 +3283,7 @@ void plg_TableRang(void* pvTableHandle, void* beginKey, short beginKeyLen, void*
 	plg_TableReleaseIterator(iter);
 }
 
-void plg_TablePoint(void* pvTableHandle, void* beginKey, short beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten) {
+void plg_TablePoint(void* pvTableHandle, void* beginKey, unsigned int beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	void* iter = plg_TableGetIteratorWithKey(pTableHandle, beginKey, beginKeyLen);
@@ -2677,7 +3334,7 @@ void plg_TablePoint(void* pvTableHandle, void* beginKey, short beginKeyLen, unsi
 	plg_TableReleaseIterator(iter);
 }
 
-static unsigned int table_RangCount(void* pvTableHandle, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen) {
+static unsigned int table_RangCount(void* pvTableHandle, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	void* iter = plg_TableGetIteratorWithKey(pTableHandle, beginKey, beginKeyLen);
@@ -2698,7 +3355,7 @@ static unsigned int table_RangCount(void* pvTableHandle, void* beginKey, short b
 void plg_TableMembers(void* pvTableHandle, void* pDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
-	void* iter = plg_TableGetIteratorWithKey(pTableHandle, NULL, 0);
+	void* iter = table_ScanIterator(pTableHandle, NULL, 0);
 	PDiskTableKey pDiskTableKey;
 	while ((pDiskTableKey = plg_TableNextIterator(iter)) != NULL) {
 
@@ -2719,71 +3376,244 @@ void plg_TableMembers(void* pvTableHandle, void* pDictExten) {
 	plg_TableReleaseIterator(iter);
 }
 
-void plg_TablePattern(void* pvTableHandle, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pattern, short patternLen, void* pDictExten) {
+static void table_PatternAddValue(void* pvTableHandle, PDiskTableKey pDiskTableKey, void* pDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
-	void* iter = plg_TableGetIteratorWithKey(pTableHandle, beginKey, beginKeyLen);
+	void* vluePtr = (unsigned char*)pDiskTableKey + sizeof(DiskTableKey) + pDiskTableKey->keyStrSize;
+	if (pDiskTableKey->valueType == VALUE_NORMAL) {
+		plg_DictExtenAdd(pDictExten, pDiskTableKey->keyStr, pDiskTableKey->keyStrSize, vluePtr, pDiskTableKey->valueSize);
+	} else if (pDiskTableKey->valueType == VALUE_BIGVALUE) {
+		PDiskKeyBigValue pDiskKeyBigValue = (PDiskKeyBigValue)vluePtr;
+		void* bigValuePtr = table_GetBigValue(pTableHandle, pDiskKeyBigValue);
+
+		if (bigValuePtr == 0) {
+			return;
+		}
+		plg_DictExtenAdd(pDictExten, pDiskTableKey->keyStr, pDiskTableKey->keyStrSize, bigValuePtr, pDiskKeyBigValue->allSize);
+		free(bigValuePtr);
+	}
+}
+
+/*
+The literal characters before the first wildcard of a glob pattern
+*/
+static short table_PatternPrefix(char* pattern, short patternLen, char* prefix) {
+
+	short prefixLen = 0;
+	for (short l = 0; l < patternLen; l++) {
+		if (pattern[l] == '*' || pattern[l] == '?' || pattern[l] == '[') {
+			break;
+		} else if (pattern[l] == '\\') {
+			if (l + 1 == patternLen) {
+				break;
+			}
+			l++;
+		}
+		prefix[prefixLen++] = pattern[l];
+	}
+	return prefixLen;
+}
+
+/*
+Keys are ordered by length and then by memcmp, so the keys with the same prefix are
+one run inside each key length. Only these runs are visited, the iterator seeks from
+one run to the next with the prefix padded by zero to the next key length.
+*/
+void plg_TablePattern(void* pvTableHandle, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pattern, short patternLen, void* pDictExten) {
+
+	PTableHandle pTableHandle = pvTableHandle;
+	char* prefix = malloc(patternLen + 1);
+	short prefixLen = table_PatternPrefix(pattern, patternLen, prefix);
+
+	//The scan stops at endKey only when it exists, seeking must not jump over it
+	short hasEnd = 0;
+	if (prefixLen && endKeyLen && !plg_TablePrevFindCmpFun(beginKey, beginKeyLen, endKey, endKeyLen)) {
+		hasEnd = plg_TableIsKeyExist(pTableHandle, endKey, endKeyLen);
+	}
+	void* iter = table_ScanIterator(pTableHandle, beginKey, beginKeyLen);
 	PDiskTableKey pDiskTableKey;
 	while ((pDiskTableKey = plg_TableNextIterator(iter)) != NULL) {
 
-		if (plg_StringMatchLen(pattern, patternLen, pDiskTableKey->keyStr, pDiskTableKey->keyStrSize, 0)) {
-			void* vluePtr = (unsigned char*)pDiskTableKey + sizeof(DiskTableKey) + pDiskTableKey->keyStrSize;
-			if (pDiskTableKey->valueType == VALUE_NORMAL) {
-				plg_DictExtenAdd(pDictExten, pDiskTableKey->keyStr, pDiskTableKey->keyStrSize, vluePtr, pDiskTableKey->valueSize);
-			} else if (pDiskTableKey->valueType == VALUE_BIGVALUE) {
-				PDiskKeyBigValue pDiskKeyBigValue = (PDiskKeyBigValue)vluePtr;
-				void* bigValuePtr = table_GetBigValue(pTableHandle, pDiskKeyBigValue);
+		if (prefixLen) {
+			unsigned short seekLen = 0;
+			if (pDiskTableKey->keyStrSize < prefixLen) {
+				seekLen = prefixLen;
+			} else {
+				int r = memcmp(pDiskTableKey->keyStr, prefix, prefixLen);
+				if (r < 0) {
+					seekLen = pDiskTableKey->keyStrSize;
+				} else if (r > 0) {
+					seekLen = pDiskTableKey->keyStrSize + 1;
+				}
+			}
 
-				if (bigValuePtr == 0) {
-					continue;
+			if (seekLen) {
+				char* seekKey = calloc(1, seekLen);
+				memcpy(seekKey, prefix, prefixLen);
+				if (hasEnd && plg_TablePrevFindCmpFun(seekKey, seekLen, endKey, endKeyLen)) {
+					free(seekKey);
+					break;
 				}
-				plg_DictExtenAdd(pDictExten, pDiskTableKey->keyStr, pDiskTableKey->keyStrSize, bigValuePtr, pDiskKeyBigValue->allSize);
-				free(bigValuePtr);
+				plg_TableReleaseIterator(iter);
+				iter = table_ScanIterator(pTableHandle, seekKey, seekLen);
+				free(seekKey);
+				continue;
 			}
 		}
 
+		if (plg_StringMatchLen(pattern, patternLen, pDiskTableKey->keyStr, pDiskTableKey->keyStrSize, 0)) {
+			table_PatternAddValue(pTableHandle, pDiskTableKey, pDictExten);
+		}
+
 		if (endKeyLen == pDiskTableKey->keyStrSize && memcmp(pDiskTableKey->keyStr, endKey, pDiskTableKey->keyStrSize) == 0) {
 			break;
 		}
 	};
 	plg_TableReleaseIterator(iter);
+	free(prefix);
 }
 
-unsigned int plg_TableMultiAdd(void* pvTableHandle, void* pDictExten) {
+/*
+Read at most limit keys of the range from beginKey, or from the head without beginKey.
+With afterBegin beginKey itself is skipped, so that the next batch starts after the last key of the previous one.
+Return 1 when the range is finished like plg_TableRang
+*/
+unsigned int plg_TableRangBatch(void* pvTableHandle, void* beginKey, unsigned int beginKeyLen, short afterBegin, void* endKey, unsigned int endKeyLen, unsigned int limit, void* pDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
-	unsigned int s = 0;
-	void* dictIter = plg_DictExtenGetIterator(pDictExten);
-	void* dictNode;
-	while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
-
-		unsigned int keyLen, valueLen;
-		char* pKey = plg_DictExtenKey(dictNode, &keyLen);
-		char* pValue = plg_DictExtenValue(dictNode, &valueLen);
-		
-		if (valueLen > plg_TableBigValueSize()) {
-			DiskKeyBigValue diskKeyBigValue;
-			if (0 == plg_TableNewBigValue(pTableHandle, pValue, valueLen, &diskKeyBigValue))
-				return s;
+	void* iter = table_ScanIterator(pTableHandle, beginKey, beginKeyLen);
+	PDiskTableKey pDiskTableKey;
+	unsigned int count = 0;
+	unsigned int finish = 1;
+	while ((pDiskTableKey = plg_TableNextIterator(iter)) != NULL) {
 
-			unsigned int r = table_InsideAddWithAlter(pTableHandle, pKey, keyLen, VALUE_BIGVALUE, &diskKeyBigValue, sizeof(DiskKeyBigValue));
-			if (!s && r) {
-				s = 1;
-			}
-		} else {
-			unsigned int r = table_InsideAddWithAlter(pTableHandle, pKey, keyLen, VALUE_NORMAL, pValue, valueLen);
-			if (!s && r) {
-				s = 1;
+		if (afterBegin) {
+			afterBegin = 0;
+			if (beginKeyLen == pDiskTableKey->keyStrSize && memcmp(pDiskTableKey->keyStr, beginKey, beginKeyLen) == 0) {
+				continue;
 			}
 		}
-	}
-	plg_DictExtenReleaseIterator(dictIter);
-	return s;
-}
 
-void plg_TableMultiFind(void* pvTableHandle, void* pKeyDictExten, void* pValueDictExten) {
+		if (count++ == limit) {
+			finish = 0;
+			break;
+		}
+		table_PatternAddValue(pTableHandle, pDiskTableKey, pDictExten);
+
+		if (endKeyLen == pDiskTableKey->keyStrSize && memcmp(pDiskTableKey->keyStr, endKey, pDiskTableKey->keyStrSize) == 0) {
+			break;
+		}
+	};
+	plg_TableReleaseIterator(iter);
+	return finish;
+}
+
+static int table_MultiKeyCmp(void* v1, void* v2) {
+
+	unsigned int keyLen1, keyLen2;
+	char* key1 = plg_DictExtenKey(*(void**)v1, &keyLen1);
+	char* key2 = plg_DictExtenKey(*(void**)v2, &keyLen2);
+	if (keyLen1 != keyLen2) {
+		return keyLen1 > keyLen2 ? 1 : -1;
+	}
+	return memcmp(key1, key2, keyLen1);
+}
+
+/*
+Return the nodes of pDictExten in the order of the skip list keys, free it after use.
+Each key of the batch then continues the search from where the smaller key before it stopped
+*/
+static void** table_MultiSortKey(void* pDictExten, unsigned int* count) {
+
+	*count = plg_DictExtenSize(pDictExten);
+	if (*count == 0) {
+		return NULL;
+	}
+
+	void** pNode = malloc(sizeof(void*) * (*count));
+	unsigned int l = 0;
+	void* dictIter = plg_DictExtenGetIterator(pDictExten);
+	void* dictNode;
+	while ((dictNode = plg_DictExtenNext(dictIter)) != NULL && l < *count) {
+		pNode[l++] = dictNode;
+	}
+	plg_DictExtenReleaseIterator(dictIter);
+
+	*count = l;
+	plg_SortArrary(pNode, sizeof(void*), l, table_MultiKeyCmp);
+	return pNode;
+}
+
+unsigned int plg_TableMultiAdd(void* pvTableHandle, void* pDictExten) {
+
+	PTableHandle pTableHandle = pvTableHandle;
+	unsigned int s = 0, count;
+	void** pNode = table_MultiSortKey(pDictExten, &count);
+	SkipListPoint skipListPoint[SKIPLIST_MAXLEVEL] = {{ 0 }};
+	short isFinger = 0;
+	for (unsigned int l = 0; l < count; l++) {
+
+		unsigned int keyLen, valueLen, r;
+		char* pKey = plg_DictExtenKey(pNode[l], &keyLen);
+		char* pValue = plg_DictExtenValue(pNode[l], &valueLen);
+		
+		if (valueLen > plg_TableBigValueSize()) {
+			DiskKeyBigValue diskKeyBigValue;
+			if (0 == plg_TableNewBigValue(pTableHandle, pValue, valueLen, &diskKeyBigValue))
+				break;
+
+			r = table_FingerAddWithAlter(pTableHandle, pKey, keyLen, VALUE_BIGVALUE, &diskKeyBigValue, sizeof(DiskKeyBigValue), &skipListPoint, isFinger);
+		} else {
+			r = table_FingerAddWithAlter(pTableHandle, pKey, keyLen, VALUE_NORMAL, pValue, valueLen, &skipListPoint, isFinger);
+		}
+
+		//a failed add leaves the link points half written
+		if (r) {
+			s = 1;
+			isFinger = 1;
+		} else {
+			isFinger = 0;
+		}
+	}
+	free(pNode);
+	return s;
+}
+
+void plg_TableMultiFind(void* pvTableHandle, void* pKeyDictExten, void* pValueDictExten) {
+
+	PTableHandle pTableHandle = pvTableHandle;
+	unsigned int count;
+	void** pNode = table_MultiSortKey(pKeyDictExten, &count);
+	SkipListPoint skipListPoint[SKIPLIST_MAXLEVEL] = {{ 0 }};
+	short isFinger = 0;
+	for (unsigned int l = 0; l < count; l++) {
+
+		unsigned int keyLen;
+		char* pKey = plg_DictExtenKey(pNode[l], &keyLen);
+
+		isFinger = table_InsideFind(pTableHandle, pKey, keyLen, pValueDictExten, 0, &skipListPoint, isFinger) < 0 ? 0 : 1;
+	}
+	free(pNode);
+}
+
+/*
+Walk down the skip list for each key while the pages are in memory,
+The first page that is not in memory is read ahead and the walk of that key stops there
+*/
+void plg_TablePrefetch(void* pvTableHandle, void* pKeyDictExten) {
+
+	PTableHandle pTableHandle = pvTableHandle;
+	if (pTableHandle->pTableHandleCallBack->prefetchPage == 0) {
+		return;
+	}
+
+	PTableInFile pTableInFile;
+	if (pTableHandle->pTableInFile->isSetHead) {
+		pTableInFile = pTableHandle->pTableInFile;
+	} else {
+		pTableInFile = pTableHandle->pTableHandleCallBack->findTableInFile(pTableHandle, pTableHandle->nameaTable, pTableHandle->pTableInFile);
+	}
 
-	PTableHandle pTableHandle = pvTableHandle;
 	void* dictIter = plg_DictExtenGetIterator(pKeyDictExten);
 	void* dictNode;
 	while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
@@ -2791,10 +3621,46 @@ void plg_TableMultiFind(void* pvTableHandle, void* pKeyDictExten, void* pValueDi
 		unsigned int keyLen;
 		char* pKey = plg_DictExtenKey(dictNode, &keyLen);
 
-		plg_TableFind(pTableHandle, pKey, keyLen, pValueDictExten, 0);
+		unsigned int pageAddr = 0;
+		void* page = 0;
+		PDiskTableElement tableElement = &pTableInFile->tableHead[SKIPLIST_MAXLEVEL - 1];
+		do {
+			if (tableElement->nextElementPage != 0) {
+				unsigned int nextAddr = tableElement->nextElementPage;
+				void* nextPage;
+				if (pageAddr == nextAddr) {
+					nextPage = page;
+				} else {
+					if (pTableHandle->pTableHandleCallBack->prefetchPage(pTableHandle, &nextAddr, 1)) {
+						break;
+					}
+					if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, tableElement->nextElementPage, &nextPage) == 0) {
+						break;
+					}
+				}
+
+				PDiskTableElement nextItem = (PDiskTableElement)POINTER(nextPage, tableElement->nextElementOffset);
+				PDiskTableKey pDiskTableKey = (PDiskTableKey)POINTER(nextPage, nextItem->keyOffset);
+				if (plg_TableTailFindCmpFun(pKey, keyLen, pDiskTableKey->keyStr, pDiskTableKey->keyStrSize)) {
+					pageAddr = tableElement->nextElementPage;
+					page = nextPage;
+					tableElement = nextItem;
+					continue;
+				}
+			}
+
+			if (tableElement->currentLevel == 0) {
+				break;
+			}
+
+			if (pageAddr == 0) {
+				tableElement = &pTableInFile->tableHead[tableElement->currentLevel - 1];
+			} else {
+				tableElement = (PDiskTableElement)POINTER(page, tableElement->lowElementOffset);
+			}
+		} while (1);
 	}
 	plg_DictExtenReleaseIterator(dictIter);
-
 }
 
 static void table_MultiDel(void* pvTableHandle, void* pDictExten) {
@@ -2925,32 +3791,22 @@ unsigned int table_Pop(void* pvTableHandle, void* pDictExten) {
 	return r;
 }
 
-void plg_TableClear(void* pvTableHandle, short recursive) {
+/*
+Free a page chain of the table.
+If the handle can reclaim pages, the chain is only handed over and freed later in the background
+*/
+static void table_ClearPageChain(void* pvTableHandle, unsigned int nextPageAddr, short scanSet) {
 
 	PTableHandle pTableHandle = pvTableHandle;
-	PTableInFile pTableInFile = 0;
-	if (recursive) {
-		PDiskTableKey pDiskTableKey = 0;
-		PTableIterator iter = plg_TableGetIteratorWithKey(pTableHandle, NULL, 0);
-		while ((pDiskTableKey = plg_TableNextIterator(iter)) != NULL) {
-			if (pDiskTableKey->valueType == VALUE_SETHEAD) {
-				void* vluePtr = (unsigned char*)pDiskTableKey + sizeof(DiskTableKey) + pDiskTableKey->keyStrSize;
-				PTableInFile pTableInFile = (PTableInFile)vluePtr;
-				PTableInFile pRecTableInFile = pTableHandle->pTableInFile;
-				pTableHandle->pTableInFile = pTableInFile;
-				plg_TableClear(pTableHandle, 0);
-				pTableHandle->pTableInFile = pRecTableInFile;
-			}
-		}
-		plg_TableReleaseIterator(iter);
-		pTableInFile = pTableHandle->pTableHandleCallBack->tableCopyOnWrite(pTableHandle, pTableHandle->nameaTable, pTableHandle->pTableInFile);
-	} else {
-		pTableInFile = pTableHandle->pTableInFile;
+	if (nextPageAddr == 0) {
+		return;
+	}
+
+	if (pTableHandle->pTableHandleCallBack->reclaimPage) {
+		pTableHandle->pTableHandleCallBack->reclaimPage(pTableHandle, nextPageAddr, scanSet);
+		return;
 	}
 
-	unsigned int nextPageAddr = pTableInFile->tablePageHead;
-	pTableInFile->tablePageHead = 0;
-	
 	do {
 		if (nextPageAddr == 0) {
 			break;
@@ -2968,127 +3824,245 @@ void plg_TableClear(void* pvTableHandle, short recursive) {
 
 		pTableHandle->pTableHandleCallBack->delPage(pTableHandle, pPageHead->addr);
 	} while (1);
+}
 
-	
+void plg_TableClear(void* pvTableHandle, short recursive) {
 
-	nextPageAddr = pTableInFile->tableUsingPage;
-	pTableInFile->tableUsingPage = 0;
-	
-	do {
-		if (nextPageAddr == 0) {
-			break;
+	PTableHandle pTableHandle = pvTableHandle;
+	PTableInFile pTableInFile = 0;
+	if (recursive) {
+		//The set heads are found again when the table pages are reclaimed
+		if (pTableHandle->pTableHandleCallBack->reclaimPage == 0) {
+			PDiskTableKey pDiskTableKey = 0;
+			PTableIterator iter = plg_TableGetIteratorWithKey(pTableHandle, NULL, 0);
+			while ((pDiskTableKey = plg_TableNextIterator(iter)) != NULL) {
+				if (pDiskTableKey->valueType == VALUE_SETHEAD) {
+					void* vluePtr = (unsigned char*)pDiskTableKey + sizeof(DiskTableKey) + pDiskTableKey->keyStrSize;
+					PTableInFile pTableInFile = (PTableInFile)vluePtr;
+					PTableInFile pRecTableInFile = pTableHandle->pTableInFile;
+					pTableHandle->pTableInFile = pTableInFile;
+					plg_TableClear(pTableHandle, 0);
+					pTableHandle->pTableInFile = pRecTableInFile;
+				}
+			}
+			plg_TableReleaseIterator(iter);
 		}
+		pTableInFile = pTableHandle->pTableHandleCallBack->tableCopyOnWrite(pTableHandle, pTableHandle->nameaTable, pTableHandle->pTableInFile);
+	} else {
+		pTableInFile = pTableHandle->pTableInFile;
+	}
 
-		void* page;
-		if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, nextPageAddr, &page) == 0) {
-			break;
-		}
-		page = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, nextPageAddr, page);
+	plg_TableResetFreeSpace(pTableHandle);
+	table_ClearPageChain(pTableHandle, pTableInFile->tablePageHead, recursive);
+	table_ClearPageChain(pTableHandle, pTableInFile->tableUsingPage, 0);
+	table_ClearPageChain(pTableHandle, pTableInFile->valuePage, 0);
+	table_ClearPageChain(pTableHandle, pTableInFile->valueUsingPage, 0);
 
-		//find in page
-		PDiskPageHead pPageHead = (PDiskPageHead)((unsigned char*)page);
-		nextPageAddr = pPageHead->nextPage;
+	plg_TableInitTableInFile(pTableInFile);
+}
 
-		pTableHandle->pTableHandleCallBack->delPage(pTableHandle, pPageHead->addr);
-	} while (1);
-	
+unsigned short plg_TableBigValueSize() {
 
-	nextPageAddr = pTableInFile->valuePage;
-	pTableInFile->valuePage = 0;
+	unsigned retSize = sizeof(DiskKeyBigValue);
+	if (retSize < sizeof(TableInFile)) {
+		retSize = sizeof(TableInFile);
+	}
 
-	do {
-		if (nextPageAddr == 0) {
-			break;
-		}
+	return retSize;
+}
 
-		void* page;
-		if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, nextPageAddr, &page) == 0) {
-			break;
-		}
-		page = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, nextPageAddr, page);
+typedef struct _SetHead
+{
+	TableInFile tableInFile;
+	short isDirty;
+}*PSetHead, SetHead;
 
-		//find in page
-		PDiskPageHead pPageHead = (PDiskPageHead)((unsigned char*)page);
-		nextPageAddr = pPageHead->nextPage;
+static unsigned long long setHeadHashCallback(const void *key) {
+	return plg_dictGenHashFunction((unsigned char*)key, plg_sdsLen((char*)key));
+}
 
-		pTableHandle->pTableHandleCallBack->delPage(pTableHandle, pPageHead->addr);
-	} while (1);
-	
+static int setHeadCompareCallback(void *privdata, const void *key1, const void *key2) {
+	int l1, l2;
+	DICT_NOTUSED(privdata);
 
-	nextPageAddr = pTableInFile->valueUsingPage;
-	pTableInFile->valueUsingPage = 0;
+	l1 = plg_sdsLen((sds)key1);
+	l2 = plg_sdsLen((sds)key2);
+	if (l1 != l2) return 0;
+	return memcmp(key1, key2, l1) == 0;
+}
 
-	do {
-		if (nextPageAddr == 0) {
-			break;
-		}
+static void setHeadKeyFreeCallback(void *privdata, void *val) {
+	DICT_NOTUSED(privdata);
+	plg_sdsFree(val);
+}
 
-		void* page;
-		if (pTableHandle->pTableHandleCallBack->findPage(pTableHandle, nextPageAddr, &page) == 0) {
-			break;
+static void setHeadFreeCallback(void *privdata, void *val) {
+	DICT_NOTUSED(privdata);
+	free(val);
+}
+
+static dictType setHeadDictType = {
+	setHeadHashCallback,
+	NULL,
+	NULL,
+	setHeadCompareCallback,
+	setHeadKeyFreeCallback,
+	setHeadFreeCallback
+};
+
+/*
+Only the set operations of the transaction that writes the table may use the cache,
+Everything else reads the set heads from the table keys
+*/
+void plg_TableSetHeadCache(void* pvTableHandle, short isSetHeadCache) {
+	PTableHandle pTableHandle = pvTableHandle;
+	pTableHandle->isSetHeadCache = isSetHeadCache;
+}
+
+/*
+Write the changed set heads back to the table keys if isWrite, then forget all of them.
+Called before anything but a set operation touches the table and when the transaction ends
+*/
+void plg_TableSetHeadFlush(void* pvTableHandle, short isWrite) {
+
+	PTableHandle pTableHandle = pvTableHandle;
+	if (pTableHandle->setHead == NULL || dictSize(pTableHandle->setHead) == 0) {
+		return;
+	}
+
+	if (isWrite) {
+		dictIterator* iter = plg_dictGetIterator(pTableHandle->setHead);
+		dictEntry* node;
+		while ((node = plg_dictNext(iter)) != NULL) {
+			sds key = dictGetKey(node);
+			PSetHead pSetHead = dictGetVal(node);
+			if (pSetHead->isDirty) {
+				plg_InsideTableAlterFroSet(pTableHandle, key, plg_sdsLen(key), VALUE_SETHEAD, &pSetHead->tableInFile, sizeof(TableInFile));
+			}
 		}
-		page = pTableHandle->pTableHandleCallBack->pageCopyOnWrite(pTableHandle, nextPageAddr, page);
+		plg_dictReleaseIterator(iter);
+	}
+	plg_dictEmpty(pTableHandle->setHead, NULL);
+}
 
-		//find in page
-		PDiskPageHead pPageHead = (PDiskPageHead)((unsigned char*)page);
-		nextPageAddr = pPageHead->nextPage;
+static void table_SetHeadCacheAdd(PTableHandle pTableHandle, void* vKey, unsigned int keyLen, PTableInFile pSetTableInFile) {
 
-		pTableHandle->pTableHandleCallBack->delPage(pTableHandle, pPageHead->addr);
-	} while (1);
+	if (pTableHandle->setHead == NULL) {
+		pTableHandle->setHead = plg_dictCreate(&setHeadDictType, NULL, DICT_MIDDLE);
+	}
 
-	plg_TableInitTableInFile(pTableInFile);
+	PSetHead pSetHead = malloc(sizeof(SetHead));
+	memcpy(&pSetHead->tableInFile, pSetTableInFile, sizeof(TableInFile));
+	pSetHead->isDirty = 0;
+	plg_dictAdd(pTableHandle->setHead, plg_sdsNewLen(vKey, keyLen), pSetHead);
 }
 
-unsigned short plg_TableBigValueSize() {
+static PSetHead table_SetHeadCacheFind(PTableHandle pTableHandle, void* vKey, unsigned int keyLen) {
 
-	unsigned retSize = sizeof(DiskKeyBigValue);
-	if (retSize < sizeof(TableInFile)) {
-		retSize = sizeof(TableInFile);
+	if (pTableHandle->setHead == NULL) {
+		return NULL;
 	}
 
-	return retSize;
+	sds key = plg_sdsNewLen(vKey, keyLen);
+	dictEntry* entry = plg_dictFind(pTableHandle->setHead, key);
+	plg_sdsFree(key);
+	if (entry == NULL) {
+		return NULL;
+	}
+	return dictGetVal(entry);
+}
+
+/*
+Copy the nested TableInFile of the set vKey to pSetTableInFile.
+Returns 1 if the set exists
+*/
+static short table_SetHeadFind(PTableHandle pTableHandle, void* vKey, unsigned int keyLen, PTableInFile pSetTableInFile) {
+
+	if (pTableHandle->isSetHeadCache) {
+		PSetHead pSetHead = table_SetHeadCacheFind(pTableHandle, vKey, keyLen);
+		if (pSetHead) {
+			memcpy(pSetTableInFile, &pSetHead->tableInFile, sizeof(TableInFile));
+			return 1;
+		}
+	}
+
+	short ret = 0;
+	void* pDictExten = plg_DictExtenCreate();
+	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
+		if (plg_DictExtenSize(pDictExten)) {
+			void* entry = plg_DictExtenGetHead(pDictExten);
+			unsigned int retValueLen = 0;
+			void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
+			if (retValueLen) {
+				memcpy(pSetTableInFile, valuePtr, retValueLen);
+				ret = 1;
+			}
+		}
+	}
+	plg_DictExtenDestroy(pDictExten);
+
+	if (ret && pTableHandle->isSetHeadCache) {
+		table_SetHeadCacheAdd(pTableHandle, vKey, keyLen, pSetTableInFile);
+	}
+	return ret;
+}
+
+/*
+Keep the changed nested TableInFile of the set vKey,
+With the cache it is written back when the transaction ends. An empty set removes its key at once
+*/
+static unsigned int table_SetHeadAlter(PTableHandle pTableHandle, void* vKey, unsigned int keyLen, PTableInFile pSetTableInFile) {
+
+	PSetHead pSetHead = NULL;
+	if (pTableHandle->isSetHeadCache) {
+		pSetHead = table_SetHeadCacheFind(pTableHandle, vKey, keyLen);
+	}
+
+	if (pSetTableInFile->tablePageHead == 0) {
+		if (pSetHead) {
+			sds key = plg_sdsNewLen(vKey, keyLen);
+			plg_dictDelete(pTableHandle->setHead, key);
+			plg_sdsFree(key);
+		}
+		return plg_TableDelForSet(pTableHandle, vKey, keyLen);
+	}
+
+	if (pSetHead) {
+		memcpy(&pSetHead->tableInFile, pSetTableInFile, sizeof(TableInFile));
+		pSetHead->isDirty = 1;
+		return 1;
+	}
+	return plg_InsideTableAlterFroSet(pTableHandle, vKey, keyLen, VALUE_SETHEAD, pSetTableInFile, sizeof(TableInFile));
 }
 
 /*
 Ȳ
 
 */
-unsigned int plg_TableSetAdd(void* pvTableHandle, void* vKey, short keyLen, void* vValue, short valueLen) {
+unsigned int plg_TableSetAdd(void* pvTableHandle, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	short ret = 0, find = 0;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	TableInFile oldTableInFile;
-	memset(&oldTableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
 
 	//find
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
 		find = 1;
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int entryValueLen;
-			void* valuePtr = plg_DictExtenValue(entry, &entryValueLen);
-			if (entryValueLen) {
-				memcpy(&tableInFile, valuePtr, entryValueLen);
-				memcpy(&oldTableInFile, valuePtr, entryValueLen);
-
-				pTableHandle->pTableInFile = &tableInFile;
-				if (1 == plg_TableAddWithAlter(pTableHandle, vValue, valueLen, VALUE_NORMAL, NULL, 0)){
-					ret = 1;
-					if (memcmp(&tableInFile, &oldTableInFile, entryValueLen) != 0) {
-						pTableHandle->pTableInFile = pTableInFile;
-						if (0 == plg_InsideTableAlterFroSet(pTableHandle, vKey, keyLen, VALUE_SETHEAD, &tableInFile, sizeof(TableInFile))) {
-							ret = 0;
-						}
-					}
+		memcpy(&oldTableInFile, &tableInFile, sizeof(TableInFile));
+
+		pTableHandle->pTableInFile = &tableInFile;
+		if (1 == plg_TableAddWithAlter(pTableHandle, vValue, valueLen, VALUE_NORMAL, NULL, 0)){
+			ret = 1;
+			if (memcmp(&tableInFile, &oldTableInFile, sizeof(TableInFile)) != 0) {
+				pTableHandle->pTableInFile = pTableInFile;
+				if (0 == table_SetHeadAlter(pTableHandle, vKey, keyLen, &tableInFile)) {
+					ret = 0;
 				}
 			}
 		}
-	} 
-	plg_DictExtenDestroy(pDictExten);
+	}
 	
 	//no find new set
 	if (!find) {
@@ -3102,6 +4076,8 @@ unsigned int plg_TableSetAdd(void* pvTableHandle, void* vKey, short keyLen, void
 			pTableHandle->pTableInFile = pTableInFile;
 			if (0 == plg_InsideTableAdd(pTableHandle, vKey, keyLen, VALUE_SETHEAD, &tableInFile, sizeof(TableInFile))) {
 				ret = 0;
+			} else if (pTableHandle->isSetHeadCache) {
+				table_SetHeadCacheAdd(pTableHandle, vKey, keyLen, &tableInFile);
 			}
 			ret = 1;
 		}
@@ -3111,532 +4087,497 @@ unsigned int plg_TableSetAdd(void* pvTableHandle, void* vKey, short keyLen, void
 	return ret;
 }
 
-void plg_TableSetRang(void* pvTableHandle, void* vKey, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen, void* pInDictExten) {
+void plg_TableSetRang(void* pvTableHandle, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen, void* pInDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
-
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int retValueLen;
-			void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-			if (retValueLen) {
-				memcpy(&tableInFile, valuePtr, retValueLen);
 
-				pTableHandle->pTableInFile = &tableInFile;
-				plg_TableRang(pTableHandle, beginValue, beginValueLen, endValue, endValueLen, pInDictExten);
-			}
-		}
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		pTableHandle->pTableInFile = &tableInFile;
+		plg_TableRang(pTableHandle, beginValue, beginValueLen, endValue, endValueLen, pInDictExten);
 	}
-	plg_DictExtenDestroy(pDictExten);
 	pTableHandle->pTableInFile = pTableInFile;
 }
 
-void plg_TableSetPoint(void* pvTableHandle, void* vKey, short keyLen, void* beginValue, short beginValueLen, unsigned int direction, unsigned int offset, void* pInDictExten) {
+void plg_TableSetPoint(void* pvTableHandle, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, unsigned int direction, unsigned int offset, void* pInDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
 
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int retValueLen;
-			void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-			if (retValueLen) {
-				memcpy(&tableInFile, valuePtr, retValueLen);
-
-				pTableHandle->pTableInFile = &tableInFile;
-				plg_TablePoint(pTableHandle, beginValue, beginValueLen, direction, offset, pInDictExten);
-			}
-		}
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		pTableHandle->pTableInFile = &tableInFile;
+		plg_TablePoint(pTableHandle, beginValue, beginValueLen, direction, offset, pInDictExten);
 	}
-	plg_DictExtenDestroy(pDictExten);
 	pTableHandle->pTableInFile = pTableInFile;
 }
 
-void plg_TableSetLimite(void* pvTableHandle, void* vKey, short keyLen, void* vValue, short valueLen, unsigned int left, unsigned int right, void* pInDictExten) {
+void plg_TableSetLimite(void* pvTableHandle, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen, unsigned int left, unsigned int right, void* pInDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
-
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int retValueLen;
-			void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-			if (retValueLen) {
-				memcpy(&tableInFile, valuePtr, retValueLen);
 
-				pTableHandle->pTableInFile = &tableInFile;
-				plg_TableLimite(pTableHandle, vValue, valueLen, left, right, pInDictExten);
-			}
-		}
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		pTableHandle->pTableInFile = &tableInFile;
+		plg_TableLimite(pTableHandle, vValue, valueLen, left, right, pInDictExten);
 	}
-	plg_DictExtenDestroy(pDictExten);
 	pTableHandle->pTableInFile = pTableInFile;
 }
 
-unsigned int plg_TableSetLength(void* pvTableHandle, void* vKey, short keyLen) {
+unsigned int plg_TableSetLength(void* pvTableHandle, void* vKey, unsigned int keyLen) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
 	unsigned int len = 0;
 
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int retValueLen;
-			void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-			if (retValueLen) {
-				memcpy(&tableInFile, valuePtr, retValueLen);
-
-				pTableHandle->pTableInFile = &tableInFile;
-				len = plg_TableLength(pTableHandle);
-			}
-		}
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		pTableHandle->pTableInFile = &tableInFile;
+		len = plg_TableLength(pTableHandle);
 	}
-	plg_DictExtenDestroy(pDictExten);
 	pTableHandle->pTableInFile = pTableInFile;
 	return len;
 }
 
-unsigned int plg_TableSetIsKeyExist(void* pvTableHandle, void* vKey, short keyLen, void* vValue, short valueLen) {
+unsigned int plg_TableSetIsKeyExist(void* pvTableHandle, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
 	unsigned int is = 0;
 
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int retValueLen;
-			void* retValuePtr = plg_DictExtenValue(entry, &retValueLen);
-			if (retValueLen) {
-				memcpy(&tableInFile, retValuePtr, retValueLen);
-
-				pTableHandle->pTableInFile = &tableInFile;
-				is = plg_TableIsKeyExist(pTableHandle, vValue, valueLen);
-			}
-		}
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		pTableHandle->pTableInFile = &tableInFile;
+		is = plg_TableIsKeyExist(pTableHandle, vValue, valueLen);
 	}
-	plg_DictExtenDestroy(pDictExten);
 	pTableHandle->pTableInFile = pTableInFile;
 	return is;
 }
 
-void plg_TableSetMembers(void* pvTableHandle, void* vKey, short keyLen, void* pInDictExten) {
+void plg_TableSetMembers(void* pvTableHandle, void* vKey, unsigned int keyLen, void* pInDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
 
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int retValueLen;
-			void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-			if (retValueLen) {
-				memcpy(&tableInFile, valuePtr, retValueLen);
-
-				pTableHandle->pTableInFile = &tableInFile;
-				plg_TableMembers(pTableHandle, pInDictExten);
-			}
-		}
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		pTableHandle->pTableInFile = &tableInFile;
+		plg_TableMembers(pTableHandle, pInDictExten);
 	}
-	plg_DictExtenDestroy(pDictExten);
 	pTableHandle->pTableInFile = pTableInFile;
 }
 
-unsigned int plg_TableSetRand(void* pvTableHandle, void* vKey, short keyLen, void* pInDictExten) {
+unsigned int plg_TableSetRand(void* pvTableHandle, void* vKey, unsigned int keyLen, void* pInDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
 	unsigned int r = 0;
 
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int retValueLen;
-			void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-			if (retValueLen) {
-				memcpy(&tableInFile, valuePtr, retValueLen);
-
-				pTableHandle->pTableInFile = &tableInFile;
-				r = plg_TableRand(pTableHandle, pInDictExten);
-			}
-		}
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		pTableHandle->pTableInFile = &tableInFile;
+		r = plg_TableRand(pTableHandle, pInDictExten);
 	}
-	plg_DictExtenDestroy(pDictExten);
 	pTableHandle->pTableInFile = pTableInFile;
 	return r;
 }
 
 //for set Multiple
-void plg_TableSetDel(void* pvTableHandle, void* vKey, short keyLen, void* pValueDictExten) {
+void plg_TableSetDel(void* pvTableHandle, void* vKey, unsigned int keyLen, void* pValueDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	TableInFile oldTableInFile;
-	memset(&oldTableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
 
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int retValueLen;
-			void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-			if (retValueLen) {
-				memcpy(&tableInFile, valuePtr, retValueLen);
-				memcpy(&oldTableInFile, valuePtr, retValueLen);
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		memcpy(&oldTableInFile, &tableInFile, sizeof(TableInFile));
 
-				pTableHandle->pTableInFile = &tableInFile;
-				table_MultiDel(pTableHandle, pValueDictExten);
+		pTableHandle->pTableInFile = &tableInFile;
+		table_MultiDel(pTableHandle, pValueDictExten);
 
-				pTableHandle->pTableInFile = pTableInFile;
-				if (memcmp(&tableInFile, &oldTableInFile, retValueLen) != 0) {
-					if (tableInFile.tablePageHead) {
-						plg_InsideTableAlterFroSet(pTableHandle, vKey, keyLen, VALUE_SETHEAD, &tableInFile, sizeof(TableInFile));
-					} else {
-						plg_TableDelForSet(pTableHandle, vKey, keyLen);
-					}
-				}
-			}
+		pTableHandle->pTableInFile = pTableInFile;
+		if (memcmp(&tableInFile, &oldTableInFile, sizeof(TableInFile)) != 0) {
+			table_SetHeadAlter(pTableHandle, vKey, keyLen, &tableInFile);
 		}
 	}
-	plg_DictExtenDestroy(pDictExten);
 
 	pTableHandle->pTableInFile = pTableInFile;	
 }
 
 //for set move
-static void table_InsideSetDel(void* pvTableHandle, void* vKey, short keyLen, void* vValue, short valueLen) {
+static void table_InsideSetDel(void* pvTableHandle, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	TableInFile oldTableInFile;
-	memset(&oldTableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
 
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int retValueLen;
-			void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-			if (retValueLen) {
-				memcpy(&tableInFile, valuePtr, retValueLen);
-				memcpy(&oldTableInFile, valuePtr, retValueLen);
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		memcpy(&oldTableInFile, &tableInFile, sizeof(TableInFile));
 
-				pTableHandle->pTableInFile = &tableInFile;
-				plg_TableDel(pTableHandle, vValue, valueLen);
+		pTableHandle->pTableInFile = &tableInFile;
+		plg_TableDel(pTableHandle, vValue, valueLen);
 
-				pTableHandle->pTableInFile = pTableInFile;
-				if (memcmp(&tableInFile, &oldTableInFile, retValueLen) != 0) {
-					if (tableInFile.tablePageHead) {
-						plg_InsideTableAlterFroSet(pTableHandle, vKey, keyLen, VALUE_SETHEAD, &tableInFile, sizeof(TableInFile));
-					} else {
-						plg_TableDelForSet(pTableHandle, vKey, keyLen);
-					}
-				}
-			}
+		pTableHandle->pTableInFile = pTableInFile;
+		if (memcmp(&tableInFile, &oldTableInFile, sizeof(TableInFile)) != 0) {
+			table_SetHeadAlter(pTableHandle, vKey, keyLen, &tableInFile);
 		}
 	}
-	plg_DictExtenDestroy(pDictExten);
 
 	pTableHandle->pTableInFile = pTableInFile;
 }
 
-unsigned int plg_TableSetPop(void* pvTableHandle, void* vKey, short keyLen, void* pInDictExten) {
+unsigned int plg_TableSetPop(void* pvTableHandle, void* vKey, unsigned int keyLen, void* pInDictExten) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	TableInFile oldTableInFile;
-	memset(&oldTableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
 	unsigned int r = 0;;
 
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int retValueLen;
-			void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-			if (retValueLen) {
-				memcpy(&tableInFile, valuePtr, retValueLen);
-				memcpy(&oldTableInFile, valuePtr, retValueLen);
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		memcpy(&oldTableInFile, &tableInFile, sizeof(TableInFile));
 
-				pTableHandle->pTableInFile = &tableInFile;
-				r = table_Pop(pTableHandle, pInDictExten);
+		pTableHandle->pTableInFile = &tableInFile;
+		r = table_Pop(pTableHandle, pInDictExten);
 
-				pTableHandle->pTableInFile = pTableInFile;
-				if (memcmp(&tableInFile, &oldTableInFile, retValueLen) != 0) {
-					if (tableInFile.tablePageHead) {
-						plg_InsideTableAlterFroSet(pTableHandle, vKey, keyLen, VALUE_SETHEAD, &tableInFile, sizeof(TableInFile));
-					} else {
-						plg_TableDelForSet(pTableHandle, vKey, keyLen);
-					}
-				}
-			}
+		pTableHandle->pTableInFile = pTableInFile;
+		if (memcmp(&tableInFile, &oldTableInFile, sizeof(TableInFile)) != 0) {
+			table_SetHeadAlter(pTableHandle, vKey, keyLen, &tableInFile);
 		}
 	}
-	plg_DictExtenDestroy(pDictExten);
 	pTableHandle->pTableInFile = pTableInFile;
 	return r;
 }
 
-unsigned int plg_TableSetRangCount(void* pvTableHandle, void* vKey, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen) {
+unsigned int plg_TableSetRangCount(void* pvTableHandle, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	TableInFile tableInFile;
-	memset(&tableInFile, 0, sizeof(TableInFile));
 	PTableInFile pTableInFile = pTableHandle->pTableInFile;
-	void* pDictExten = plg_DictExtenCreate();
 	unsigned int count = 0;
-	if (0 < plg_TableFind(pTableHandle, vKey, keyLen, pDictExten, 1)) {
-		if (plg_DictExtenSize(pDictExten)) {
-			void* entry = plg_DictExtenGetHead(pDictExten);
-			unsigned int retValueLen;
-			void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-			if (retValueLen) {
-				memcpy(&tableInFile, valuePtr, retValueLen);
 
-				pTableHandle->pTableInFile = &tableInFile;
-				count = table_RangCount(pTableHandle, beginValue, beginValueLen, endValue, endValueLen);
-			}
-		}
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		pTableHandle->pTableInFile = &tableInFile;
+		count = table_RangCount(pTableHandle, beginValue, beginValueLen, endValue, endValueLen);
 	}
-	plg_DictExtenDestroy(pDictExten);
 	pTableHandle->pTableInFile = pTableInFile;
 
 	return count;
 }
 
-void plg_TableSetUion(void* pvTableHandle, void* pSetDictExten, void* pKeyDictExten) {
+//set operation of table_SetMerge
+#define SETOP_UION 1
+#define SETOP_INTER 2
+#define SETOP_DIFF 3
 
-	PTableHandle pTableHandle = pvTableHandle;
-	void* dictIter = plg_DictExtenGetIterator(pSetDictExten);
-	void* dictNode;
-	while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
+//Steps taken with the iterator before seeking through the skiplist
+#define _SETGALLOP_ 8
 
-		unsigned int keyLen;
-		char* pKey = plg_DictExtenKey(dictNode, &keyLen);
+/*
+The members of a set are the keys of its nested skiplist,
+The cursor walks them in the same order as the table keys
+*/
+typedef struct _SetCursor
+{
+	TableInFile tableInFile;
+	void* iter;
+	PDiskTableKey pDiskTableKey;
+}*PSetCursor, SetCursor;
 
-		//set members
-		TableInFile tableInFile;
-		memset(&tableInFile, 0, sizeof(TableInFile));
-		PTableInFile pTableInFile = pTableHandle->pTableInFile;
-		void* pDictExten = plg_DictExtenCreate();
-
-		if (0 < plg_TableFind(pTableHandle, pKey, keyLen, pDictExten, 1)) {
-			if (plg_DictExtenSize(pDictExten)) {
-				void* entry = plg_DictExtenGetHead(pDictExten);
-				unsigned int retValueLen;
-				void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-				if (retValueLen) {
-					memcpy(&tableInFile, valuePtr, retValueLen);
-
-					pTableHandle->pTableInFile = &tableInFile;
-					plg_TableMembers(pTableHandle, pKeyDictExten);
-				}
-			}
-		}
-		plg_DictExtenDestroy(pDictExten);
-		pTableHandle->pTableInFile = pTableInFile;
+static int table_SetKeyCmp(PDiskTableKey left, PDiskTableKey right) {
+
+	if (left->keyStrSize != right->keyStrSize) {
+		return left->keyStrSize > right->keyStrSize ? 1 : -1;
 	}
-	plg_DictExtenReleaseIterator(dictIter);
+	return memcmp(left->keyStr, right->keyStr, left->keyStrSize);
 }
 
-void plg_TableSetUionStore(void* pvTableHandle, void* pSetDictExten, void* vKey, short keyLen) {
+/*
+Returns 1 if the set exists and has members
+*/
+static short table_SetCursorOpen(PTableHandle pTableHandle, void* vKey, unsigned int keyLen, PSetCursor pSetCursor) {
 
-	PTableHandle pTableHandle = pvTableHandle;
-	void* pDictExten = plg_DictExtenCreate();
-	plg_TableSetUion(pTableHandle, pSetDictExten, pDictExten);
+	short ret = 0;
+	PTableInFile pTableInFile = pTableHandle->pTableInFile;
 
-	//set to key
-	if (plg_DictExtenSize(pDictExten)) {
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &pSetCursor->tableInFile)) {
+		pTableHandle->pTableInFile = &pSetCursor->tableInFile;
+		pSetCursor->iter = plg_TableGetIteratorWithKey(pTableHandle, NULL, 0);
+		pTableHandle->pTableInFile = pTableInFile;
 
-		void* dictIter = plg_DictExtenGetIterator(pDictExten);
-		void* dictNode;
-		while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
-			unsigned int retKeyLen = 0;
-			void* keyPtr = plg_DictExtenKey(dictNode, &retKeyLen);
-			plg_TableSetAdd(pTableHandle, vKey, keyLen, keyPtr, retKeyLen);
+		if (pSetCursor->iter) {
+			pSetCursor->pDiskTableKey = plg_TableNextIterator(pSetCursor->iter);
+			if (pSetCursor->pDiskTableKey) {
+				ret = 1;
+			} else {
+				plg_TableReleaseIterator(pSetCursor->iter);
+			}
 		}
-		plg_DictExtenReleaseIterator(dictIter);
 	}
-	plg_DictExtenDestroy(pDictExten);
+	return ret;
 }
 
-void plg_TableSetInter(void* pvTableHandle, void* pSetDictExten, void* pKeyDictExten) {
+/*
+Move the cursor to the first member not less than pDiskTableKey,
+Near members are reached by stepping, far ones through the skiplist
+*/
+static void table_SetCursorSeek(PTableHandle pTableHandle, PSetCursor pSetCursor, PDiskTableKey pDiskTableKey) {
 
-	PTableHandle pTableHandle = pvTableHandle;
-	void* dictIter = plg_DictExtenGetIterator(pSetDictExten);
-	void* dictNode;
-	while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
+	for (int l = 0; l < _SETGALLOP_; l++) {
+		if (pSetCursor->pDiskTableKey == NULL || table_SetKeyCmp(pSetCursor->pDiskTableKey, pDiskTableKey) >= 0) {
+			return;
+		}
+		pSetCursor->pDiskTableKey = plg_TableNextIterator(pSetCursor->iter);
+	}
 
-		unsigned int keyLen;
-		char* pKey = plg_DictExtenKey(dictNode, &keyLen);
+	if (pSetCursor->pDiskTableKey == NULL || table_SetKeyCmp(pSetCursor->pDiskTableKey, pDiskTableKey) >= 0) {
+		return;
+	}
 
-		//set members
-		TableInFile tableInFile;
-		memset(&tableInFile, 0, sizeof(TableInFile));
-		PTableInFile pTableInFile = pTableHandle->pTableInFile;
-		void* pDictExten = plg_DictExtenCreate();
-
-		if (0 < plg_TableFind(pTableHandle, pKey, keyLen, pDictExten, 1)) {
-			if (plg_DictExtenSize(pDictExten)) {
-				void* entry = plg_DictExtenGetHead(pDictExten);
-				unsigned int retValueLen = 0;
-				void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-				if (retValueLen) {
-					memcpy(&tableInFile, valuePtr, retValueLen);
-					pTableHandle->pTableInFile = &tableInFile;
-
-					//find inter
-					if (plg_DictExtenSize(pKeyDictExten) == 0) {
-						plg_TableMembers(pTableHandle, pKeyDictExten);
-					} else {
-						void* dictInterIter = plg_DictExtenGetIterator(pKeyDictExten);
-						void* dictInterNode;
-						while ((dictInterNode = plg_DictExtenNext(dictInterIter)) != NULL) {
-
-							unsigned int interKeyLen;
-							char* interKey = plg_DictExtenKey(dictInterNode, &interKeyLen);
-							if (1 > plg_TableFind(pTableHandle, interKey, interKeyLen, 0, 1)) {
-								plg_DictExtenDel(pKeyDictExten, interKey, interKeyLen);
-							}
-						}
-						plg_DictExtenReleaseIterator(dictInterIter);
-					}
-					//end find
-				}
-			}
-		}
-		plg_DictExtenDestroy(pDictExten);
-		pTableHandle->pTableInFile = pTableInFile;
+	PTableInFile pTableInFile = pTableHandle->pTableInFile;
+	pTableHandle->pTableInFile = &pSetCursor->tableInFile;
+	void* iter = plg_TableGetIteratorWithKey(pTableHandle, pDiskTableKey->keyStr, pDiskTableKey->keyStrSize);
+	pTableHandle->pTableInFile = pTableInFile;
+
+	if (iter == 0) {
+		pSetCursor->pDiskTableKey = NULL;
+		return;
 	}
-	plg_DictExtenReleaseIterator(dictIter);
+	plg_TableReleaseIterator(pSetCursor->iter);
+	pSetCursor->iter = iter;
+	pSetCursor->pDiskTableKey = plg_TableNextIterator(pSetCursor->iter);
 }
 
-void plg_TableSetInterStore(void* pvTableHandle, void* pSetDictExten, void* vKey, short keyLen) {
+static unsigned int table_SetMergeOut(PTableHandle pTableHandle, PDiskTableKey pDiskTableKey, void* pKeyDictExten, PTableInFile pStoreTableInFile) {
 
-	PTableHandle pTableHandle = pvTableHandle;
-	void* pDictExten = plg_DictExtenCreate();
-	plg_TableSetInter(pTableHandle, pSetDictExten, pDictExten);
+	if (pStoreTableInFile == NULL) {
+		void* vluePtr = (unsigned char*)pDiskTableKey + sizeof(DiskTableKey) + pDiskTableKey->keyStrSize;
+		plg_DictExtenAdd(pKeyDictExten, pDiskTableKey->keyStr, pDiskTableKey->keyStrSize, vluePtr, pDiskTableKey->valueSize);
+		return 1;
+	}
 
-	//set to key
-	if (plg_DictExtenSize(pDictExten)) {
+	PTableInFile pTableInFile = pTableHandle->pTableInFile;
+	pTableHandle->pTableInFile = pStoreTableInFile;
+	unsigned int ret = plg_TableAddWithAlter(pTableHandle, pDiskTableKey->keyStr, pDiskTableKey->keyStrSize, VALUE_NORMAL, NULL, 0);
+	pTableHandle->pTableInFile = pTableInFile;
+	return ret;
+}
 
-		void* dictIter = plg_DictExtenGetIterator(pDictExten);
-		void* dictNode;
-		while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
-			unsigned int retKeyLen = 0;
-			void* keyPtr = plg_DictExtenKey(dictNode, &retKeyLen);
-			plg_TableSetAdd(pTableHandle, vKey, keyLen, keyPtr, retKeyLen);
-		}
-		plg_DictExtenReleaseIterator(dictIter);
+/*
+The nested skiplists of the sets are already sorted,
+So the sets are merged by walking their iterators side by side.
+The result goes to pKeyDictExten, or straight into pStoreTableInFile if it is given.
+For diff the first existing set of pSetDictExten is the one the others are taken from.
+*/
+static unsigned int table_SetMerge(PTableHandle pTableHandle, void* pSetDictExten, short setOp, void* pKeyDictExten, PTableInFile pStoreTableInFile) {
+
+	unsigned int setSize = plg_DictExtenSize(pSetDictExten);
+	if (setSize == 0) {
+		return 0;
 	}
-	plg_DictExtenDestroy(pDictExten);
-}
 
-void plg_TableSetDiff(void* pvTableHandle, void* pSetDictExten, void* pKeyDictExten) {
+	PSetCursor pSetCursor = malloc(sizeof(SetCursor) * setSize);
+	unsigned int cursorCount = 0, count = 0;
+	short isEmpty = 0;
 
-	PTableHandle pTableHandle = pvTableHandle;
+	//a set without members has no key, it is skipped as if it was not given
 	void* dictIter = plg_DictExtenGetIterator(pSetDictExten);
 	void* dictNode;
 	while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
 
 		unsigned int keyLen;
 		char* pKey = plg_DictExtenKey(dictNode, &keyLen);
+		if (table_SetCursorOpen(pTableHandle, pKey, keyLen, &pSetCursor[cursorCount])) {
+			cursorCount += 1;
+		}
+	}
+	plg_DictExtenReleaseIterator(dictIter);
 
-		//set members
-		TableInFile tableInFile;
-		memset(&tableInFile, 0, sizeof(TableInFile));
-		PTableInFile pTableInFile = pTableHandle->pTableInFile;
-		void* pDictExten = plg_DictExtenCreate();
-
-		if (0 != plg_TableFind(pTableHandle, pKey, keyLen, pDictExten, 1)) {
-			if (plg_DictExtenSize(pDictExten)) {
-				void* entry = plg_DictExtenGetHead(pDictExten);
-				unsigned int retValueLen = 0;
-				void* valuePtr = plg_DictExtenValue(entry, &retValueLen);
-				if (retValueLen) {
-					memcpy(&tableInFile, valuePtr, retValueLen);
-					pTableHandle->pTableInFile = &tableInFile;
-
-					//find diff
-					if (plg_DictExtenSize(pKeyDictExten) == 0) {
-						plg_TableMembers(pTableHandle, pKeyDictExten);
-					} else {
-						void* dictInterIter = plg_DictExtenGetIterator(pKeyDictExten);
-						void* dictInterNode;
-						while ((dictInterNode = plg_DictExtenNext(dictInterIter)) != NULL) {
-
-							unsigned int interKeyLen;
-							char* interKey = plg_DictExtenKey(dictInterNode, &interKeyLen);
-							if (0 < plg_TableFind(pTableHandle, interKey, interKeyLen, 0, 1)) {
-								plg_DictExtenDel(pKeyDictExten, interKey, interKeyLen);
-							}
-						}
-						plg_DictExtenReleaseIterator(dictInterIter);
-					}
-					//end find
+	if (cursorCount == 0) {
+		isEmpty = 1;
+	}
+
+	if (!isEmpty && setOp == SETOP_UION) {
+		do {
+			PDiskTableKey pMinKey = NULL;
+			for (unsigned int l = 0; l < cursorCount; l++) {
+				if (pSetCursor[l].pDiskTableKey && (pMinKey == NULL || table_SetKeyCmp(pSetCursor[l].pDiskTableKey, pMinKey) < 0)) {
+					pMinKey = pSetCursor[l].pDiskTableKey;
+				}
+			}
+			if (pMinKey == NULL) {
+				break;
+			}
+
+			count += table_SetMergeOut(pTableHandle, pMinKey, pKeyDictExten, pStoreTableInFile);
+			
+			//advance the others first, pMinKey points into one of them
+			PSetCursor pMinCursor = NULL;
+			for (unsigned int l = 0; l < cursorCount; l++) {
+				if (pSetCursor[l].pDiskTableKey == pMinKey) {
+					pMinCursor = &pSetCursor[l];
+				} else if (pSetCursor[l].pDiskTableKey && table_SetKeyCmp(pSetCursor[l].pDiskTableKey, pMinKey) == 0) {
+					pSetCursor[l].pDiskTableKey = plg_TableNextIterator(pSetCursor[l].iter);
+				}
+			}
+			pMinCursor->pDiskTableKey = plg_TableNextIterator(pMinCursor->iter);
+		} while (1);
+	} else if (!isEmpty && setOp == SETOP_INTER) {
+		do {
+			PDiskTableKey pMaxKey = pSetCursor[0].pDiskTableKey;
+			for (unsigned int l = 1; l < cursorCount; l++) {
+				if (table_SetKeyCmp(pSetCursor[l].pDiskTableKey, pMaxKey) > 0) {
+					pMaxKey = pSetCursor[l].pDiskTableKey;
+				}
+			}
+
+			short isSame = 1;
+			for (unsigned int l = 0; l < cursorCount; l++) {
+				table_SetCursorSeek(pTableHandle, &pSetCursor[l], pMaxKey);
+				if (pSetCursor[l].pDiskTableKey == NULL) {
+					isEmpty = 1;
+					break;
+				} else if (table_SetKeyCmp(pSetCursor[l].pDiskTableKey, pMaxKey) != 0) {
+					isSame = 0;
+				}
+			}
+			if (isEmpty) {
+				break;
+			}
+			if (!isSame) {
+				continue;
+			}
+
+			count += table_SetMergeOut(pTableHandle, pMaxKey, pKeyDictExten, pStoreTableInFile);
+			for (unsigned int l = 0; l < cursorCount; l++) {
+				pSetCursor[l].pDiskTableKey = plg_TableNextIterator(pSetCursor[l].iter);
+				if (pSetCursor[l].pDiskTableKey == NULL) {
+					isEmpty = 1;
 				}
 			}
+		} while (!isEmpty);
+	} else if (!isEmpty && setOp == SETOP_DIFF) {
+		while (pSetCursor[0].pDiskTableKey != NULL) {
+
+			short isFind = 0;
+			for (unsigned int l = 1; l < cursorCount; l++) {
+				table_SetCursorSeek(pTableHandle, &pSetCursor[l], pSetCursor[0].pDiskTableKey);
+				if (pSetCursor[l].pDiskTableKey && table_SetKeyCmp(pSetCursor[l].pDiskTableKey, pSetCursor[0].pDiskTableKey) == 0) {
+					isFind = 1;
+					break;
+				}
+			}
+
+			if (!isFind) {
+				count += table_SetMergeOut(pTableHandle, pSetCursor[0].pDiskTableKey, pKeyDictExten, pStoreTableInFile);
+			}
+			pSetCursor[0].pDiskTableKey = plg_TableNextIterator(pSetCursor[0].iter);
 		}
-		plg_DictExtenDestroy(pDictExten);
-		pTableHandle->pTableInFile = pTableInFile;
 	}
-	plg_DictExtenReleaseIterator(dictIter);
+
+	for (unsigned int l = 0; l < cursorCount; l++) {
+		plg_TableReleaseIterator(pSetCursor[l].iter);
+	}
+	free(pSetCursor);
+	return count;
 }
 
-void plg_TableSetDiffStore(void* pvTableHandle, void* pSetDictExten, void* vKey, short keyLen) {
+/*
+Resolve the destination set once and add the result of the merge straight into it,
+If the destination is also one of the sources, the result is collected first
+*/
+static void table_SetMergeStore(PTableHandle pTableHandle, void* pSetDictExten, short setOp, void* vKey, unsigned int keyLen) {
 
-	PTableHandle pTableHandle = pvTableHandle;
-	void* pDictExten = plg_DictExtenCreate();
-	plg_TableSetDiff(pTableHandle, pSetDictExten, pDictExten);
+	short find = 0;
+	TableInFile tableInFile;
+	TableInFile oldTableInFile;
+	PTableInFile pTableInFile = pTableHandle->pTableInFile;
+
+	if (table_SetHeadFind(pTableHandle, vKey, keyLen, &tableInFile)) {
+		memcpy(&oldTableInFile, &tableInFile, sizeof(TableInFile));
+		find = 1;
+	} else if (plg_TableIsKeyExist(pTableHandle, vKey, keyLen)) {
+		//not a set
+		return;
+	} else {
+		plg_TableInitTableInFile(&tableInFile);
+		tableInFile.isSetHead = 1;
+	}
+
+	short isSource = 0;
+	void* dictIter = plg_DictExtenGetIterator(pSetDictExten);
+	void* dictNode;
+	while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
+		unsigned int setKeyLen;
+		char* pSetKey = plg_DictExtenKey(dictNode, &setKeyLen);
+		if (setKeyLen == (unsigned int)keyLen && memcmp(pSetKey, vKey, keyLen) == 0) {
+			isSource = 1;
+			break;
+		}
+	}
+	plg_DictExtenReleaseIterator(dictIter);
 
-	//set to key
-	if (plg_DictExtenSize(pDictExten)) {
+	unsigned int count = 0;
+	void* pDictExten;
+	if (!isSource) {
+		count = table_SetMerge(pTableHandle, pSetDictExten, setOp, NULL, &tableInFile);
+	} else {
+		pDictExten = plg_DictExtenCreate();
+		table_SetMerge(pTableHandle, pSetDictExten, setOp, pDictExten, NULL);
 
-		void* dictIter = plg_DictExtenGetIterator(pDictExten);
-		void* dictNode;
+		pTableHandle->pTableInFile = &tableInFile;
+		dictIter = plg_DictExtenGetIterator(pDictExten);
 		while ((dictNode = plg_DictExtenNext(dictIter)) != NULL) {
 			unsigned int retKeyLen = 0;
 			void* keyPtr = plg_DictExtenKey(dictNode, &retKeyLen);
-			plg_TableSetAdd(pTableHandle, vKey, keyLen, keyPtr, retKeyLen);
+			count += plg_TableAddWithAlter(pTableHandle, keyPtr, retKeyLen, VALUE_NORMAL, NULL, 0);
 		}
 		plg_DictExtenReleaseIterator(dictIter);
+		pTableHandle->pTableInFile = pTableInFile;
+		plg_DictExtenDestroy(pDictExten);
 	}
-	plg_DictExtenDestroy(pDictExten);
+
+	//write back the set head
+	if (find) {
+		if (memcmp(&tableInFile, &oldTableInFile, sizeof(TableInFile)) != 0) {
+			table_SetHeadAlter(pTableHandle, vKey, keyLen, &tableInFile);
+		}
+	} else if (count) {
+		if (plg_InsideTableAdd(pTableHandle, vKey, keyLen, VALUE_SETHEAD, &tableInFile, sizeof(TableInFile)) && pTableHandle->isSetHeadCache) {
+			table_SetHeadCacheAdd(pTableHandle, vKey, keyLen, &tableInFile);
+		}
+	}
+}
+
+void plg_TableSetUion(void* pvTableHandle, void* pSetDictExten, void* pKeyDictExten) {
+	table_SetMerge(pvTableHandle, pSetDictExten, SETOP_UION, pKeyDictExten, NULL);
+}
+
+void plg_TableSetUionStore(void* pvTableHandle, void* pSetDictExten, void* vKey, unsigned int keyLen) {
+	table_SetMergeStore(pvTableHandle, pSetDictExten, SETOP_UION, vKey, keyLen);
+}
+
+void plg_TableSetInter(void* pvTableHandle, void* pSetDictExten, void* pKeyDictExten) {
+	table_SetMerge(pvTableHandle, pSetDictExten, SETOP_INTER, pKeyDictExten, NULL);
+}
+
+void plg_TableSetInterStore(void* pvTableHandle, void* pSetDictExten, void* vKey, unsigned int keyLen) {
+	table_SetMergeStore(pvTableHandle, pSetDictExten, SETOP_INTER, vKey, keyLen);
+}
+
+void plg_TableSetDiff(void* pvTableHandle, void* pSetDictExten, void* pKeyDictExten) {
+	table_SetMerge(pvTableHandle, pSetDictExten, SETOP_DIFF, pKeyDictExten, NULL);
+}
+
+void plg_TableSetDiffStore(void* pvTableHandle, void* pSetDictExten, void* vKey, unsigned int keyLen) {
+	table_SetMergeStore(pvTableHandle, pSetDictExten, SETOP_DIFF, vKey, keyLen);
 }
 
-void plg_TableSetMove(void* pvTableHandle, void* vSrcKey, short  srcKeyLen, void* vDesKey, short desKeyLen, void* vValue, short valueLen) {
+void plg_TableSetMove(void* pvTableHandle, void* vSrcKey, unsigned int srcKeyLen, void* vDesKey, unsigned int desKeyLen, void* vValue, unsigned int valueLen) {
 
 	PTableHandle pTableHandle = pvTableHandle;
 	table_InsideSetDel(pTableHandle, vSrcKey, srcKeyLen, vValue, valueLen);
@@ -3647,7 +4588,7 @@ void plg_TableMembersWithJson(void* pvTableHandle, void* vjsonRoot) {
 
 	pJSON* jsonRoot = vjsonRoot;
 	PTableHandle pTableHandle = pvTableHandle;
-	void* iter = plg_TableGetIteratorWithKey(pTableHandle, NULL, 0);
+	void* iter = table_ScanIterator(pTableHandle, NULL, 0);
 	PDiskTableKey pDiskTableKey;
 	while ((pDiskTableKey = plg_TableNextIterator(iter)) != NULL) {
 
@@ -32,6 +32,8 @@ typedef struct _TableHandleCallBack {
 	void*(*tableCopyOnWrite)(void* pTableHandle, sds table, void* tableInFile);
 	void(*addDirtyTable)(void* pTableHandle, sds table);
 	void*(*findTableInFile)(void* pTableHandle, sds table, void* tableInFile);
+	unsigned int(*prefetchPage)(void* pTableHandle, unsigned int* pageAddr, unsigned int count);
+	unsigned int(*reclaimPage)(void* pTableHandle, unsigned int pageAddr, short scanSet);
 }*PTableHandleCallBack, TableHandleCallBack;
 
 void* plg_TableCreateHandle(void* pTableInFile, void* pageOperateHandle, unsigned int pageSize,
@@ -45,10 +47,12 @@ unsigned int plg_TableHitStamp(void* pTableHandle);
 void plg_TableResetHandle(void* pTableHandle, void* pTableInFile, sds tableName);
 void* plg_TableOperateHandle(void* pvTableHandle);
 void plg_TableArrangementPage(unsigned int pageSize, void* page);
+unsigned int plg_TableCompactPage(void* pvTableHandle, unsigned int pageAddr);
+void plg_TableResetFreeSpace(void* pvTableHandle);
 typedef int(*FindCmpFun)(void* key1, unsigned int key1Len, void* key2, unsigned int Key2Len);
 int plg_TablePrevFindCmpFun(void* key1, unsigned int key1Len, void* key2, unsigned int Key2Len);
 int plg_TableTailFindCmpFun(void* key1, unsigned int key1Len, void* key2, unsigned int Key2Len);
-unsigned int plg_TableFindWithName(void* pTableHandle, char* key, short keyLen, void* skipListPoint, FindCmpFun pFindCmpFun);
+unsigned int plg_TableFindWithName(void* pTableHandle, char* key, unsigned int keyLen, void* skipListPoint, FindCmpFun pFindCmpFun);
 int plg_TableCheckLength(void* page, unsigned int pageSize);
 
 //normal
@@ -56,50 +60,57 @@ unsigned short plg_TableGetTableType(void* pvTableHandle);
 unsigned short plg_TableSetTableType(void* pvTableHandle, unsigned short tableType);
 unsigned short plg_TableSetTableTypeIfByte(void* pvTableHandle, unsigned short tableType);
 
-unsigned int plg_TableAdd(void* pTableHandle, void* vKey, short keyLen, void* value, unsigned short length);
-unsigned int plg_TableDel(void* pTableHandle, void* vKey, short keyLen);
-unsigned int plg_TableAlter(void* pTableHandle, void* vKey, short keyLen, void* value, unsigned short length);
-int plg_TableFind(void* pTableHandle, void* vKey, short keyLen, void* pDictExten, short isSet);
-unsigned int plg_TableAddWithAlter(void* pTableHandle, void* vKey, short keyLen, char valueType, void* value, unsigned short length);
+unsigned int plg_TableAdd(void* pTableHandle, void* vKey, unsigned int keyLen, void* value, unsigned short length);
+unsigned int plg_TableDel(void* pTableHandle, void* vKey, unsigned int keyLen);
+unsigned int plg_TableAlter(void* pTableHandle, void* vKey, unsigned int keyLen, void* value, unsigned short length);
+unsigned int plg_TableCompareAndSet(void* pTableHandle, void* vKey, unsigned int keyLen, void* oldValue, unsigned int oldLength, void* value, unsigned int length);
+unsigned int plg_TableIncrDouble(void* pTableHandle, void* vKey, unsigned int keyLen, double increment, double* result);
+unsigned int plg_TableAppend(void* pTableHandle, void* vKey, unsigned int keyLen, void* value, unsigned int length);
+int plg_TableFind(void* pTableHandle, void* vKey, unsigned int keyLen, void* pDictExten, short isSet);
+unsigned int plg_TableAddWithAlter(void* pTableHandle, void* vKey, unsigned int keyLen, char valueType, void* value, unsigned short length);
 unsigned int plg_TableLength(void* pTableHandle);
-unsigned int plg_TableAddIfNoExist(void* pTableHandle, void* vKey, short keyLen, char valueType, void* value, unsigned short length);
-unsigned int plg_TableIsKeyExist(void* pTableHandle, void* vKey, short keyLen);
-unsigned int plg_TableRename(void* pTableHandle, void* vKey, short keyLen, void* vNewKey, short newKeyLen);
-void plg_TableLimite(void* pTableHandle, void* vKey, short keyLen, unsigned int left, unsigned int right, void* pDictExten);
+unsigned int plg_TableAddIfNoExist(void* pTableHandle, void* vKey, unsigned int keyLen, char valueType, void* value, unsigned short length);
+unsigned int plg_TableIsKeyExist(void* pTableHandle, void* vKey, unsigned int keyLen);
+unsigned int plg_TableRename(void* pTableHandle, void* vKey, unsigned int keyLen, void* vNewKey, unsigned int newKeyLen);
+void plg_TableLimite(void* pTableHandle, void* vKey, unsigned int keyLen, unsigned int left, unsigned int right, void* pDictExten);
 void plg_TableOrder(void* pTableHandle, short order, unsigned int limite, void* pDictExten);
-void plg_TableRang(void* pTableHandle, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pDictExten);
-void plg_TablePattern(void* pvTableHandle, void* beginKey, short beginKeyLen, void* endKey, short endKeyLen, void* pattern, short patternLen, void* pDictExten);
+void plg_TableRang(void* pTableHandle, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pDictExten);
+void plg_TablePattern(void* pvTableHandle, void* beginKey, unsigned int beginKeyLen, void* endKey, unsigned int endKeyLen, void* pattern, short patternLen, void* pDictExten);
+unsigned int plg_TableRangBatch(void* pvTableHandle, void* beginKey, unsigned int beginKeyLen, short afterBegin, void* endKey, unsigned int endKeyLen, unsigned int limit, void* pDictExten);
 unsigned int plg_TableMultiAdd(void* pTableHandle, void* pDictExten);
 void plg_TableMultiFind(void* pTableHandle, void* pKeyDictExten, void* pValueDictExten);
+void plg_TablePrefetch(void* pTableHandle, void* pKeyDictExten);
 unsigned int plg_TableRand(void* pTableHandle, void* pDictExten);
 void plg_TableClear(void* pTableHandle, short recursive);
 unsigned short plg_TableBigValueSize();
-void plg_TablePoint(void* pvTableHandle, void* beginKey, short beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten);
+void plg_TablePoint(void* pvTableHandle, void* beginKey, unsigned int beginKeyLen, unsigned int direction, unsigned int offset, void* pDictExten);
 void plg_TableMembers(void* pvTableHandle, void* pDictExten);
 
 //set
-unsigned int plg_TableSetAdd(void* pTableHandle, void* vKey, short keyLen, void* vValue, short valueLen);
-void plg_TableSetRang(void* pTableHandle, void* vKey, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen, void* pInDictExten);
-void plg_TableSetLimite(void* pTableHandle, void* vKey, short keyLen, void* vValue, short valueLen, unsigned int left, unsigned int right, void* pInDictExten);
-unsigned int plg_TableSetLength(void* pTableHandle, void* vKey, short keyLen);
-unsigned int plg_TableSetIsKeyExist(void* pTableHandle, void* vKey, short keyLen, void* vValue, short valueLen);
-void plg_TableSetMembers(void* pTableHandle, void* vKey, short keyLen, void* pInDictExten);
-unsigned int plg_TableSetRand(void* pTableHandle, void* vKey, short keyLen, void* pInDictExten);
-void plg_TableSetDel(void* pTableHandle, void* vKey, short keyLen, void* pValueDictExten);
-unsigned int plg_TableSetPop(void* pTableHandle, void* vKey, short keyLen, void* pInDictExten);
-unsigned int plg_TableSetRangCount(void* pTableHandle, void* vKey, short keyLen, void* beginValue, short beginValueLen, void* endValue, short endValueLen);
+unsigned int plg_TableSetAdd(void* pTableHandle, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen);
+void plg_TableSetRang(void* pTableHandle, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen, void* pInDictExten);
+void plg_TableSetLimite(void* pTableHandle, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen, unsigned int left, unsigned int right, void* pInDictExten);
+unsigned int plg_TableSetLength(void* pTableHandle, void* vKey, unsigned int keyLen);
+unsigned int plg_TableSetIsKeyExist(void* pTableHandle, void* vKey, unsigned int keyLen, void* vValue, unsigned int valueLen);
+void plg_TableSetMembers(void* pTableHandle, void* vKey, unsigned int keyLen, void* pInDictExten);
+unsigned int plg_TableSetRand(void* pTableHandle, void* vKey, unsigned int keyLen, void* pInDictExten);
+void plg_TableSetDel(void* pTableHandle, void* vKey, unsigned int keyLen, void* pValueDictExten);
+unsigned int plg_TableSetPop(void* pTableHandle, void* vKey, unsigned int keyLen, void* pInDictExten);
+unsigned int plg_TableSetRangCount(void* pTableHandle, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, void* endValue, unsigned int endValueLen);
 void plg_TableSetUion(void* pTableHandle, void* pSetDictExten, void* pKeyDictExten);
-void plg_TableSetUionStore(void* pTableHandle, void* pSetDictExten, void* vKey, short keyLen);
+void plg_TableSetUionStore(void* pTableHandle, void* pSetDictExten, void* vKey, unsigned int keyLen);
 void plg_TableSetInter(void* pTableHandle, void* pSetDictExten, void* pKeyDictExten);
-void plg_TableSetInterStore(void* pTableHandle, void* pSetDictExten, void* vKey, short keyLen);
+void plg_TableSetInterStore(void* pTableHandle, void* pSetDictExten, void* vKey, unsigned int keyLen);
 void plg_TableSetDiff(void* pTableHandle, void* pSetDictExten, void* pKeyDictExten);
-void plg_TableSetDiffStore(void* pTableHandle, void* pSetDictExten, void* vKey, short keyLen);
-void plg_TableSetMove(void* pvTableHandle, void* vSrcKey, short  srcKeyLen, void* vDesKey, short desKeyLen, void* vValue, short valueLen);
-void plg_TableSetPoint(void* pvTableHandle, void* vKey, short keyLen, void* beginValue, short beginValueLen, unsigned int direction, unsigned int offset, void* pInDictExten);
+void plg_TableSetDiffStore(void* pTableHandle, void* pSetDictExten, void* vKey, unsigned int keyLen);
+void plg_TableSetMove(void* pvTableHandle, void* vSrcKey, unsigned int srcKeyLen, void* vDesKey, unsigned int desKeyLen, void* vValue, unsigned int valueLen);
+void plg_TableSetPoint(void* pvTableHandle, void* vKey, unsigned int keyLen, void* beginValue, unsigned int beginValueLen, unsigned int direction, unsigned int offset, void* pInDictExten);
+void plg_TableSetHeadCache(void* pTableHandle, short isSetHeadCache);
+void plg_TableSetHeadFlush(void* pTableHandle, short isWrite);
 
 //iter return pTableIterator
 void* plg_TableGetIteratorToTail(void* pTableHandle);
-void* plg_TableGetIteratorWithKey(void* pTableHandle, void* vKey, short keyLen);
+void* plg_TableGetIteratorWithKey(void* pTableHandle, void* vKey, unsigned int keyLen);
 void* plg_TablePrevIterator(void* pTableIterator);
 void* plg_TableNextIterator(void* pTableIterator);
 void plg_TableReleaseIterator(void* pTableIterator);